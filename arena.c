@@ -0,0 +1,106 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN sizeof(void *)
+
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    _Alignas(ARENA_ALIGN) char data[];
+} ArenaBlock;
+
+void arena_init(Arena *arena)
+{
+    arena->head = NULL;
+    arena->used = 0;
+    arena->reserved = 0;
+    arena->blocks = 0;
+    arena->allocations = 0;
+}
+
+/* Returns size bytes at the front of the current block after padding it
+   to align, starting a new block when they do not fit */
+static char *arena_take(Arena *arena, size_t size, size_t align)
+{
+    ArenaBlock *block = arena->head;
+    size_t pad = 0;
+    if (block != NULL)
+    {
+        pad = (align - block->used % align) % align;
+    }
+    if (block == NULL || block->size - block->used < pad + size)
+    {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + block_size);
+        block->next = arena->head;
+        block->used = 0;
+        block->size = block_size;
+        arena->head = block;
+        arena->reserved += block_size;
+        arena->blocks++;
+        pad = 0;
+    }
+
+    char *result = block->data + block->used + pad;
+    block->used += pad + size;
+    arena->used += pad + size;
+    arena->allocations++;
+    return result;
+}
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    return arena_take(arena, size, ARENA_ALIGN);
+}
+
+char *arena_strndup(Arena *arena, const char *text, size_t length)
+{
+    char *copy = arena_take(arena, length + 1, 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void arena_adopt(Arena *arena, Arena *other)
+{
+    if (other->head == NULL)
+    {
+        return;
+    }
+
+    /* Keep filling arena's current block; the adopted ones go behind it */
+    if (arena->head == NULL)
+    {
+        arena->head = other->head;
+    }
+    else
+    {
+        ArenaBlock *last = other->head;
+        while (last->next != NULL)
+        {
+            last = last->next;
+        }
+        last->next = arena->head->next;
+        arena->head->next = other->head;
+    }
+    arena->used += other->used;
+    arena->reserved += other->reserved;
+    arena->blocks += other->blocks;
+    arena->allocations += other->allocations;
+    arena_init(other);
+}
+
+void arena_free(Arena *arena)
+{
+    ArenaBlock *block = arena->head;
+    while (block != NULL)
+    {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena);
+}
@@ -0,0 +1,35 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ArenaBlock;
+
+/* Bump allocator: allocations are carved out of large blocks in order and
+   are only ever released all together by arena_free. */
+typedef struct Arena
+{
+    struct ArenaBlock *head; /* block currently being filled */
+    size_t used;             /* bytes handed out, padding included */
+    size_t reserved;         /* bytes held in blocks */
+    int blocks;
+    int allocations;
+} Arena;
+
+void arena_init(Arena *arena);
+
+/* Aligned for any node type: nodes hold only pointers, ints and floats */
+void *arena_alloc(Arena *arena, size_t size);
+
+/* Copies length bytes plus a terminating NUL, without alignment padding */
+char *arena_strndup(Arena *arena, const char *text, size_t length);
+
+/* Moves every block of other into arena, leaving other empty; what was
+   allocated from either lives until arena is freed */
+void arena_adopt(Arena *arena, Arena *other);
+
+void arena_free(Arena *arena);
+
+#endif
@@ -2,12 +2,9 @@
 #ifndef AST_H
 #define AST_H
 
-#include <stdlib.h>
 #include <string.h>
 #include "tokens.h"
-
-extern int yylineno;
-extern char current_lexeme[];
+#include "arena.h"
 
 typedef enum
 {
@@ -46,13 +43,14 @@ typedef enum
     NODE_PRIVATE,
     NODE_ID,
     NODE_VISIBILITY,
-    NODE_OP
+    NODE_OP,
+    NODE_ERROR /* stands in for a construct syntax error recovery skipped */
 } NodeType;
 
 struct ASTNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset; /* source byte offset where the construct starts */
     struct ASTNode *next;
     struct Scope *scope;
 };
@@ -60,7 +58,7 @@ struct ASTNode
 struct GenericNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -73,7 +71,7 @@ struct GenericNode
 struct LiteralNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -81,24 +79,24 @@ struct LiteralNode
     {
         int int_value;
         float float_value;
-        char *string_value;
+        const char *string_value;
     } value;
 };
 
 struct IdentifierNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
-    char *name;
+    const char *name;
 };
 
 struct BinOpNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -110,7 +108,7 @@ struct BinOpNode
 struct UnaryOpNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -121,11 +119,11 @@ struct UnaryOpNode
 struct VarDeclNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
-    char *id;
+    const char *id;
     struct ASTNode *type_node;
     struct ASTNode *array_dims;
 };
@@ -133,12 +131,12 @@ struct VarDeclNode
 struct FuncHeadNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
     int is_constructor;
-    char *id;
+    const char *id;
     struct ASTNode *params;
     struct ASTNode *return_type;
 };
@@ -146,7 +144,7 @@ struct FuncHeadNode
 struct FuncDefNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -157,11 +155,11 @@ struct FuncDefNode
 struct ClassDeclNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
-    char *id;
+    const char *id;
     struct ASTNode *isa_list;
     struct ASTNode *inheritance_list;
     struct ASTNode *members;
@@ -170,18 +168,18 @@ struct ClassDeclNode
 struct ImplDefNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
-    char *id;
+    const char *id;
     struct ASTNode *func_defs;
 };
 
 struct IfNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -193,7 +191,7 @@ struct IfNode
 struct WhileNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -204,7 +202,7 @@ struct WhileNode
 struct AssignNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -215,7 +213,7 @@ struct AssignNode
 struct VarAccessNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
@@ -227,20 +225,20 @@ struct VarAccessNode
 struct FuncCallNode
 {
     NodeType type;
-    int line_number;
+    unsigned int offset;
     struct ASTNode *next;
     struct Scope *scope;
 
-    char *id;
+    const char *id;
     struct ASTNode *id_nest;
     struct ASTNode *args;
 };
 
-static inline struct ASTNode *create_node(NodeType type, struct ASTNode *c1, struct ASTNode *c2)
+static inline struct ASTNode *create_node(Arena *arena, NodeType type, struct ASTNode *c1, struct ASTNode *c2, unsigned int offset)
 {
-    struct GenericNode *node = (struct GenericNode *)malloc(sizeof(struct GenericNode));
+    struct GenericNode *node = (struct GenericNode *)arena_alloc(arena, sizeof(struct GenericNode));
     node->type = type;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->child1 = c1;
@@ -250,55 +248,57 @@ static inline struct ASTNode *create_node(NodeType type, struct ASTNode *c1, str
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_id_node(char *name)
+/* Name and string arguments are interned in the compilation's string
+   table, so nodes share them and compare them by pointer. */
+static inline struct ASTNode *create_id_node(Arena *arena, const char *name, unsigned int offset)
 {
-    struct IdentifierNode *node = (struct IdentifierNode *)malloc(sizeof(struct IdentifierNode));
+    struct IdentifierNode *node = (struct IdentifierNode *)arena_alloc(arena, sizeof(struct IdentifierNode));
     node->type = NODE_ID;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
-    node->name = strdup(name);
+    node->name = name;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_int_lit(int value)
+static inline struct ASTNode *create_int_lit(Arena *arena, int value, unsigned int offset)
 {
-    struct LiteralNode *node = (struct LiteralNode *)malloc(sizeof(struct LiteralNode));
+    struct LiteralNode *node = (struct LiteralNode *)arena_alloc(arena, sizeof(struct LiteralNode));
     node->type = NODE_INT_LIT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->value.int_value = value;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_float_lit(float value)
+static inline struct ASTNode *create_float_lit(Arena *arena, float value, unsigned int offset)
 {
-    struct LiteralNode *node = (struct LiteralNode *)malloc(sizeof(struct LiteralNode));
+    struct LiteralNode *node = (struct LiteralNode *)arena_alloc(arena, sizeof(struct LiteralNode));
     node->type = NODE_FLOAT_LIT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->value.float_value = value;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_string_lit(char *value)
+static inline struct ASTNode *create_string_lit(Arena *arena, const char *value, unsigned int offset)
 {
-    struct LiteralNode *node = (struct LiteralNode *)malloc(sizeof(struct LiteralNode));
+    struct LiteralNode *node = (struct LiteralNode *)arena_alloc(arena, sizeof(struct LiteralNode));
     node->type = NODE_STRING_LIT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
-    node->value.string_value = strdup(value);
+    node->value.string_value = value;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_bin_op(int op, struct ASTNode *left, struct ASTNode *right)
+static inline struct ASTNode *create_bin_op(Arena *arena, int op, struct ASTNode *left, struct ASTNode *right, unsigned int offset)
 {
-    struct BinOpNode *node = (struct BinOpNode *)malloc(sizeof(struct BinOpNode));
+    struct BinOpNode *node = (struct BinOpNode *)arena_alloc(arena, sizeof(struct BinOpNode));
     node->type = NODE_BIN_OP;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->op = op;
@@ -307,11 +307,11 @@ static inline struct ASTNode *create_bin_op(int op, struct ASTNode *left, struct
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_unary_op(int op, struct ASTNode *operand)
+static inline struct ASTNode *create_unary_op(Arena *arena, int op, struct ASTNode *operand, unsigned int offset)
 {
-    struct UnaryOpNode *node = (struct UnaryOpNode *)malloc(sizeof(struct UnaryOpNode));
+    struct UnaryOpNode *node = (struct UnaryOpNode *)arena_alloc(arena, sizeof(struct UnaryOpNode));
     node->type = NODE_UNARY_OP;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->op = op;
@@ -319,11 +319,11 @@ static inline struct ASTNode *create_unary_op(int op, struct ASTNode *operand)
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_op_node(int op)
+static inline struct ASTNode *create_op_node(Arena *arena, int op, unsigned int offset)
 {
-    struct UnaryOpNode *node = (struct UnaryOpNode *)malloc(sizeof(struct UnaryOpNode));
+    struct UnaryOpNode *node = (struct UnaryOpNode *)arena_alloc(arena, sizeof(struct UnaryOpNode));
     node->type = NODE_OP;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->op = op;
@@ -331,11 +331,11 @@ static inline struct ASTNode *create_op_node(int op)
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_class_decl(char *id, struct ASTNode *isa, struct ASTNode *inherit, struct ASTNode *members)
+static inline struct ASTNode *create_class_decl(Arena *arena, const char *id, struct ASTNode *isa, struct ASTNode *inherit, struct ASTNode *members, unsigned int offset)
 {
-    struct ClassDeclNode *node = (struct ClassDeclNode *)malloc(sizeof(struct ClassDeclNode));
+    struct ClassDeclNode *node = (struct ClassDeclNode *)arena_alloc(arena, sizeof(struct ClassDeclNode));
     node->type = NODE_CLASS_DECL;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->id = id;
@@ -345,22 +345,22 @@ static inline struct ASTNode *create_class_decl(char *id, struct ASTNode *isa, s
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_visibility_node(char *visibility)
+static inline struct ASTNode *create_visibility_node(Arena *arena, const char *visibility, unsigned int offset)
 {
-    struct IdentifierNode *node = (struct IdentifierNode *)malloc(sizeof(struct IdentifierNode));
+    struct IdentifierNode *node = (struct IdentifierNode *)arena_alloc(arena, sizeof(struct IdentifierNode));
     node->type = (strcmp(visibility, "public") == 0) ? NODE_PUBLIC : NODE_PRIVATE;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
-    node->name = strdup(visibility);
+    node->name = visibility;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_impl_def(char *id, struct ASTNode *func_list)
+static inline struct ASTNode *create_impl_def(Arena *arena, const char *id, struct ASTNode *func_list, unsigned int offset)
 {
-    struct ImplDefNode *node = (struct ImplDefNode *)malloc(sizeof(struct ImplDefNode));
+    struct ImplDefNode *node = (struct ImplDefNode *)arena_alloc(arena, sizeof(struct ImplDefNode));
     node->type = NODE_IMPL_DEF;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->id = id;
@@ -368,11 +368,11 @@ static inline struct ASTNode *create_impl_def(char *id, struct ASTNode *func_lis
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_func_def(struct ASTNode *head, struct ASTNode *body)
+static inline struct ASTNode *create_func_def(Arena *arena, struct ASTNode *head, struct ASTNode *body, unsigned int offset)
 {
-    struct FuncDefNode *node = (struct FuncDefNode *)malloc(sizeof(struct FuncDefNode));
+    struct FuncDefNode *node = (struct FuncDefNode *)arena_alloc(arena, sizeof(struct FuncDefNode));
     node->type = NODE_FUNC_DEF;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->func_head = head;
@@ -380,11 +380,11 @@ static inline struct ASTNode *create_func_def(struct ASTNode *head, struct ASTNo
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_func_head(int is_ctor, char *id, struct ASTNode *params, struct ASTNode *ret_type)
+static inline struct ASTNode *create_func_head(Arena *arena, int is_ctor, const char *id, struct ASTNode *params, struct ASTNode *ret_type, unsigned int offset)
 {
-    struct FuncHeadNode *node = (struct FuncHeadNode *)malloc(sizeof(struct FuncHeadNode));
+    struct FuncHeadNode *node = (struct FuncHeadNode *)arena_alloc(arena, sizeof(struct FuncHeadNode));
     node->type = NODE_FUNC_HEAD;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->is_constructor = is_ctor;
@@ -394,22 +394,22 @@ static inline struct ASTNode *create_func_head(int is_ctor, char *id, struct AST
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_type_node(char *type_name)
+static inline struct ASTNode *create_type_node(Arena *arena, const char *type_name, unsigned int offset)
 {
-    struct IdentifierNode *node = (struct IdentifierNode *)malloc(sizeof(struct IdentifierNode));
+    struct IdentifierNode *node = (struct IdentifierNode *)arena_alloc(arena, sizeof(struct IdentifierNode));
     node->type = NODE_TYPE;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
-    node->name = strdup(type_name);
+    node->name = type_name;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_var_decl(char *id, struct ASTNode *type_node, struct ASTNode *dims)
+static inline struct ASTNode *create_var_decl(Arena *arena, const char *id, struct ASTNode *type_node, struct ASTNode *dims, unsigned int offset)
 {
-    struct VarDeclNode *node = (struct VarDeclNode *)malloc(sizeof(struct VarDeclNode));
+    struct VarDeclNode *node = (struct VarDeclNode *)arena_alloc(arena, sizeof(struct VarDeclNode));
     node->type = NODE_VAR_DECL;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->id = id;
@@ -418,11 +418,11 @@ static inline struct ASTNode *create_var_decl(char *id, struct ASTNode *type_nod
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_if_node(struct ASTNode *cond, struct ASTNode *if_body, struct ASTNode *else_body)
+static inline struct ASTNode *create_if_node(Arena *arena, struct ASTNode *cond, struct ASTNode *if_body, struct ASTNode *else_body, unsigned int offset)
 {
-    struct IfNode *node = (struct IfNode *)malloc(sizeof(struct IfNode));
+    struct IfNode *node = (struct IfNode *)arena_alloc(arena, sizeof(struct IfNode));
     node->type = NODE_IF_STMT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->condition = cond;
@@ -431,11 +431,11 @@ static inline struct ASTNode *create_if_node(struct ASTNode *cond, struct ASTNod
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_while_node(struct ASTNode *cond, struct ASTNode *body)
+static inline struct ASTNode *create_while_node(Arena *arena, struct ASTNode *cond, struct ASTNode *body, unsigned int offset)
 {
-    struct WhileNode *node = (struct WhileNode *)malloc(sizeof(struct WhileNode));
+    struct WhileNode *node = (struct WhileNode *)arena_alloc(arena, sizeof(struct WhileNode));
     node->type = NODE_WHILE_STMT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->condition = cond;
@@ -443,44 +443,44 @@ static inline struct ASTNode *create_while_node(struct ASTNode *cond, struct AST
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_read_node(struct ASTNode *var)
+static inline struct ASTNode *create_read_node(Arena *arena, struct ASTNode *var, unsigned int offset)
 {
-    struct GenericNode *node = (struct GenericNode *)malloc(sizeof(struct GenericNode));
+    struct GenericNode *node = (struct GenericNode *)arena_alloc(arena, sizeof(struct GenericNode));
     node->type = NODE_READ_STMT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->child1 = var;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_write_node(struct ASTNode *expr)
+static inline struct ASTNode *create_write_node(Arena *arena, struct ASTNode *expr, unsigned int offset)
 {
-    struct GenericNode *node = (struct GenericNode *)malloc(sizeof(struct GenericNode));
+    struct GenericNode *node = (struct GenericNode *)arena_alloc(arena, sizeof(struct GenericNode));
     node->type = NODE_WRITE_STMT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->child1 = expr;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_return_node(struct ASTNode *expr)
+static inline struct ASTNode *create_return_node(Arena *arena, struct ASTNode *expr, unsigned int offset)
 {
-    struct GenericNode *node = (struct GenericNode *)malloc(sizeof(struct GenericNode));
+    struct GenericNode *node = (struct GenericNode *)arena_alloc(arena, sizeof(struct GenericNode));
     node->type = NODE_RETURN_STMT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->child1 = expr;
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_assign_node(struct ASTNode *var, struct ASTNode *expr)
+static inline struct ASTNode *create_assign_node(Arena *arena, struct ASTNode *var, struct ASTNode *expr, unsigned int offset)
 {
-    struct AssignNode *node = (struct AssignNode *)malloc(sizeof(struct AssignNode));
+    struct AssignNode *node = (struct AssignNode *)arena_alloc(arena, sizeof(struct AssignNode));
     node->type = NODE_ASSIGN_STMT;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->variable = var;
@@ -488,11 +488,11 @@ static inline struct ASTNode *create_assign_node(struct ASTNode *var, struct AST
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_var_node(struct ASTNode *base, struct ASTNode *indices, struct ASTNode *members)
+static inline struct ASTNode *create_var_node(Arena *arena, struct ASTNode *base, struct ASTNode *indices, struct ASTNode *members, unsigned int offset)
 {
-    struct VarAccessNode *node = (struct VarAccessNode *)malloc(sizeof(struct VarAccessNode));
+    struct VarAccessNode *node = (struct VarAccessNode *)arena_alloc(arena, sizeof(struct VarAccessNode));
     node->type = NODE_VARIABLE;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->base = base;
@@ -501,11 +501,11 @@ static inline struct ASTNode *create_var_node(struct ASTNode *base, struct ASTNo
     return (struct ASTNode *)node;
 }
 
-static inline struct ASTNode *create_func_call(char *id, struct ASTNode *idnest, struct ASTNode *args)
+static inline struct ASTNode *create_func_call(Arena *arena, const char *id, struct ASTNode *idnest, struct ASTNode *args, unsigned int offset)
 {
-    struct FuncCallNode *node = (struct FuncCallNode *)malloc(sizeof(struct FuncCallNode));
+    struct FuncCallNode *node = (struct FuncCallNode *)arena_alloc(arena, sizeof(struct FuncCallNode));
     node->type = NODE_FUNC_CALL;
-    node->line_number = yylineno;
+    node->offset = offset;
     node->next = NULL;
     node->scope = NULL;
     node->id = id;
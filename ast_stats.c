@@ -0,0 +1,221 @@
+#include "ast_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TOP_NAMES 5
+
+static int metrics_enter(CompactAst *ast, AstId node, void *state)
+{
+    AstStats *stats = (AstStats *)state;
+    stats->nodes[ast_kind(ast, node)]++;
+    if (++stats->depth > stats->max_depth)
+    {
+        stats->max_depth = stats->depth;
+    }
+    return AST_VISIT_CHILDREN;
+}
+
+static void metrics_leave(CompactAst *ast, AstId node, void *state)
+{
+    (void)ast;
+    (void)node;
+    ((AstStats *)state)->depth--;
+}
+
+static int uses_enter_id(CompactAst *ast, AstId node, void *state)
+{
+    ((AstStats *)state)->name_uses[ast->word[node]]++;
+    return AST_VISIT_CHILDREN;
+}
+
+static int uses_enter_call(CompactAst *ast, AstId node, void *state)
+{
+    ((AstStats *)state)->name_uses[((AstCall *)ast_record(ast, node))->name]++;
+    return AST_VISIT_CHILDREN;
+}
+
+static void add_note(AstStats *stats, unsigned int offset, AstLintKind kind, const char *name)
+{
+    if (stats->note_count == stats->note_capacity)
+    {
+        stats->note_capacity = stats->note_capacity != 0 ? stats->note_capacity * 2 : 16;
+        stats->notes = (AstLintNote *)realloc(stats->notes, stats->note_capacity * sizeof(AstLintNote));
+    }
+    stats->notes[stats->note_count].offset = offset;
+    stats->notes[stats->note_count].kind = kind;
+    stats->notes[stats->note_count].name = name;
+    stats->note_count++;
+}
+
+static int lint_enter_var_decl(CompactAst *ast, AstId node, void *state)
+{
+    AstStats *stats = (AstStats *)state;
+    (void)ast;
+    if (stats->declaration_count == stats->declaration_capacity)
+    {
+        stats->declaration_capacity = stats->declaration_capacity != 0 ? stats->declaration_capacity * 2 : 64;
+        stats->declarations =
+            (AstId *)realloc(stats->declarations, stats->declaration_capacity * sizeof(AstId));
+    }
+    stats->declarations[stats->declaration_count++] = node;
+    return AST_VISIT_CHILDREN;
+}
+
+/* Name of a variable access that is a bare name, else NULL */
+static const char *plain_name(const CompactAst *ast, AstId node)
+{
+    if (ast_kind(ast, node) != NODE_VARIABLE)
+    {
+        return NULL;
+    }
+    const AstVarAccess *var = (const AstVarAccess *)ast_record(ast, node);
+    if (var->indices.count != 0 || var->members.count != 0 || ast_kind(ast, var->base) != NODE_ID)
+    {
+        return NULL;
+    }
+    return ast_node_name(ast, var->base);
+}
+
+static int lint_enter_assign(CompactAst *ast, AstId node, void *state)
+{
+    AstAssign *assign = (AstAssign *)ast_record(ast, node);
+    const char *name = plain_name(ast, assign->variable);
+    if (name != NULL && name == plain_name(ast, assign->expression))
+    {
+        add_note((AstStats *)state, ast->offset[node], LINT_SELF_ASSIGNMENT, name);
+    }
+    return AST_VISIT_CHILDREN;
+}
+
+static int lint_enter_block(CompactAst *ast, AstId node, void *state)
+{
+    if (((AstBlock *)ast_record(ast, node))->items.count == 0)
+    {
+        add_note((AstStats *)state, ast->offset[node], LINT_EMPTY_BLOCK, NULL);
+    }
+    return AST_VISIT_CHILDREN;
+}
+
+void ast_stats_init(AstStats *stats, const CompactAst *ast)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    stats->metrics.name = "metrics";
+    for (int kind = 0; kind < AST_KIND_COUNT; kind++)
+    {
+        stats->metrics.pre[kind] = metrics_enter;
+        stats->metrics.post[kind] = metrics_leave;
+    }
+
+    stats->uses.name = "uses";
+    stats->uses.pre[NODE_ID] = uses_enter_id;
+    stats->uses.pre[NODE_FUNC_CALL] = uses_enter_call;
+    stats->name_count = ast->name_count;
+    stats->name_uses = (unsigned int *)calloc(ast->name_count + 1, sizeof(unsigned int));
+
+    stats->lint.name = "lint";
+    stats->lint.pre[NODE_VAR_DECL] = lint_enter_var_decl;
+    stats->lint.pre[NODE_ASSIGN_STMT] = lint_enter_assign;
+    stats->lint.pre[NODE_STAT_BLOCK] = lint_enter_block;
+}
+
+void ast_stats_add(AstStats *stats, AstWalk *walk)
+{
+    ast_walk_add(walk, &stats->metrics, stats);
+    ast_walk_add(walk, &stats->uses, stats);
+    ast_walk_add(walk, &stats->lint, stats);
+}
+
+static int compare_notes(const void *a, const void *b)
+{
+    unsigned int offset_a = ((const AstLintNote *)a)->offset;
+    unsigned int offset_b = ((const AstLintNote *)b)->offset;
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+void ast_stats_report(AstStats *stats, const CompactAst *ast, const LineIndex *lines, const char *label,
+                      FILE *out)
+{
+    unsigned long long total = 0;
+    for (int kind = 0; kind < AST_KIND_COUNT; kind++)
+    {
+        total += stats->nodes[kind];
+    }
+    unsigned long long statements = stats->nodes[NODE_IF_STMT] + stats->nodes[NODE_WHILE_STMT] +
+                                    stats->nodes[NODE_READ_STMT] + stats->nodes[NODE_WRITE_STMT] +
+                                    stats->nodes[NODE_RETURN_STMT] + stats->nodes[NODE_ASSIGN_STMT];
+    fprintf(out, "%sAST: %llu nodes visited, depth %d, %llu functions, %llu statements, %llu expressions\n",
+            label, total, stats->max_depth, stats->nodes[NODE_FUNC_DEF], statements,
+            stats->nodes[NODE_BIN_OP] + stats->nodes[NODE_UNARY_OP] + stats->nodes[NODE_VARIABLE] +
+                stats->nodes[NODE_FUNC_CALL]);
+
+    /* Picked by repeated scans; only a handful are printed */
+    int top[TOP_NAMES];
+    int top_count = 0;
+    for (; top_count < TOP_NAMES; top_count++)
+    {
+        int best = -1;
+        for (int i = 0; i < stats->name_count; i++)
+        {
+            int taken = 0;
+            for (int t = 0; t < top_count; t++)
+            {
+                taken |= top[t] == i;
+            }
+            if (!taken && stats->name_uses[i] != 0 && (best < 0 || stats->name_uses[i] > stats->name_uses[best]))
+            {
+                best = i;
+            }
+        }
+        if (best < 0)
+        {
+            break;
+        }
+        top[top_count] = best;
+    }
+    fprintf(out, "%sMost used names:", label);
+    for (int t = 0; t < top_count; t++)
+    {
+        fprintf(out, "%s %s (%u)", t > 0 ? "," : "", ast_name(ast, (unsigned int)top[t]), stats->name_uses[top[t]]);
+    }
+    fprintf(out, "%s\n", top_count == 0 ? " none" : "");
+
+    /* A declaration is unused when its name is used nowhere in the file */
+    for (int i = 0; i < stats->declaration_count; i++)
+    {
+        AstVarDecl *var_decl = (AstVarDecl *)ast_record(ast, stats->declarations[i]);
+        if (stats->name_uses[var_decl->name] == 0)
+        {
+            add_note(stats, ast->offset[stats->declarations[i]], LINT_UNUSED_VARIABLE, ast_name(ast, var_decl->name));
+        }
+    }
+    if (stats->note_count > 1)
+    {
+        qsort(stats->notes, stats->note_count, sizeof(AstLintNote), compare_notes);
+    }
+    for (int i = 0; i < stats->note_count; i++)
+    {
+        const AstLintNote *note = &stats->notes[i];
+        fprintf(out, "%sLint at line %d: ", label, line_index_line(lines, note->offset));
+        switch (note->kind)
+        {
+        case LINT_SELF_ASSIGNMENT:
+            fprintf(out, "Variable '%s' is assigned to itself\n", note->name);
+            break;
+        case LINT_EMPTY_BLOCK:
+            fprintf(out, "Empty block\n");
+            break;
+        case LINT_UNUSED_VARIABLE:
+            fprintf(out, "Variable '%s' is declared but never used\n", note->name);
+            break;
+        }
+    }
+}
+
+void ast_stats_free(AstStats *stats)
+{
+    free(stats->name_uses);
+    free(stats->declarations);
+    free(stats->notes);
+    memset(stats, 0, sizeof(*stats));
+}
@@ -0,0 +1,60 @@
+#ifndef AST_STATS_H
+#define AST_STATS_H
+
+#include <stdio.h>
+#include "ast_visit.h"
+#include "line_index.h"
+
+/* Analyses that only read the tree, for --stats: node counts and depth,
+   how often each name is used, and lint notes. They are visitors, so
+   they run in the same walk as the first semantic pass. */
+
+typedef enum
+{
+    LINT_SELF_ASSIGNMENT,
+    LINT_EMPTY_BLOCK,
+    LINT_UNUSED_VARIABLE
+} AstLintKind;
+
+typedef struct AstLintNote
+{
+    unsigned int offset;
+    AstLintKind kind;
+    const char *name; /* the variable; NULL for an empty block */
+} AstLintNote;
+
+typedef struct AstStats
+{
+    AstVisitor metrics;
+    AstVisitor uses;
+    AstVisitor lint;
+
+    unsigned long long nodes[AST_KIND_COUNT];
+    int depth;
+    int max_depth;
+
+    unsigned int *name_uses; /* identifiers and calls, by name index */
+    int name_count;
+
+    AstId *declarations; /* variables, checked for uses once the walk is done */
+    int declaration_count;
+    int declaration_capacity;
+
+    AstLintNote *notes;
+    int note_count;
+    int note_capacity;
+} AstStats;
+
+void ast_stats_init(AstStats *stats, const CompactAst *ast);
+
+/* Registers the three analyses with walk */
+void ast_stats_add(AstStats *stats, AstWalk *walk);
+
+/* Counts, the most used names and the lint notes, each line starting
+   with label; call after the walk */
+void ast_stats_report(AstStats *stats, const CompactAst *ast, const LineIndex *lines, const char *label,
+                      FILE *out);
+
+void ast_stats_free(AstStats *stats);
+
+#endif
@@ -0,0 +1,307 @@
+#include "ast_visit.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *const kind_names[AST_KIND_COUNT] = {
+    "prog", "class list", "class", "implement", "function", "member list", "variable declaration", "attribute",
+    "function head", "type", "return type", "function body", "statement list", "if", "while", "read", "write",
+    "return", "assignment", "block", "expression", "binary operator", "unary operator", "variable", "call",
+    "integer", "float", "string", "parameter list", "argument list", "function declaration", "public", "private",
+    "identifier", "visibility", "operator", "error"};
+
+void ast_walk_init(AstWalk *walk)
+{
+    memset(walk, 0, sizeof(*walk));
+}
+
+void ast_walk_add(AstWalk *walk, const AstVisitor *visitor, void *state)
+{
+    if (walk->count == AST_WALK_MAX_VISITORS)
+    {
+        fprintf(stderr, "Error: More than %d AST visitors in one walk\n", AST_WALK_MAX_VISITORS);
+        return;
+    }
+    walk->visitors[walk->count] = visitor;
+    walk->states[walk->count] = state;
+    walk->count++;
+}
+
+void ast_walk_measure(AstWalk *walk)
+{
+    if (walk->costs == NULL)
+    {
+        walk->costs = (AstHookCost *)calloc((size_t)AST_WALK_MAX_VISITORS * AST_KIND_COUNT * 2, sizeof(AstHookCost));
+    }
+}
+
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static AstHookCost *hook_cost(const AstWalk *walk, int visitor, NodeType kind, int leaving)
+{
+    return &walk->costs[(visitor * AST_KIND_COUNT + kind) * 2 + leaving];
+}
+
+static void push(AstWalk *walk, int *count, AstId node, unsigned int mask, int leaving)
+{
+    if (node == 0)
+    {
+        return;
+    }
+    if (*count == walk->stack_capacity)
+    {
+        walk->stack_capacity = walk->stack_capacity != 0 ? walk->stack_capacity * 2 : 256;
+        walk->stack = (AstWalkEntry *)realloc(walk->stack, walk->stack_capacity * sizeof(AstWalkEntry));
+    }
+    walk->stack[*count].node = node;
+    walk->stack[*count].mask = mask;
+    walk->stack[*count].leaving = leaving;
+    (*count)++;
+}
+
+/* Pushed last to first, so they come off the stack in source order */
+static void push_list(AstWalk *walk, int *count, const CompactAst *ast, AstList list, unsigned int mask)
+{
+    for (unsigned int i = list.count; i-- > 0;)
+    {
+        push(walk, count, ast_item(ast, list, i), mask, 0);
+    }
+}
+
+static void push_children(AstWalk *walk, int *count, const CompactAst *ast, AstId node, unsigned int mask)
+{
+    switch (ast_kind(ast, node))
+    {
+    case NODE_PROG:
+    case NODE_FUNC_BODY:
+        push_list(walk, count, ast, ast_list(ast, node), mask);
+        break;
+
+    case NODE_STAT_BLOCK:
+        push_list(walk, count, ast, ((AstBlock *)ast_record(ast, node))->items, mask);
+        break;
+
+    case NODE_ATTRIBUTE_DECL:
+    case NODE_FUNC_DECL:
+    case NODE_READ_STMT:
+    case NODE_WRITE_STMT:
+        push(walk, count, ast_child(ast, node), mask, 0);
+        break;
+
+    case NODE_RETURN_STMT:
+        push(walk, count, ((AstReturn *)ast_record(ast, node))->value, mask, 0);
+        break;
+
+    case NODE_UNARY_OP:
+        push(walk, count, ((AstUnary *)ast_record(ast, node))->operand, mask, 0);
+        break;
+
+    case NODE_BIN_OP:
+    {
+        AstBinary *binary = (AstBinary *)ast_record(ast, node);
+        push(walk, count, binary->right, mask, 0);
+        push(walk, count, binary->left, mask, 0);
+        break;
+    }
+
+    case NODE_CLASS_DECL:
+    {
+        AstClass *class_decl = (AstClass *)ast_record(ast, node);
+        push_list(walk, count, ast, class_decl->members, mask);
+        push_list(walk, count, ast, class_decl->inherits, mask);
+        push_list(walk, count, ast, class_decl->isa, mask);
+        break;
+    }
+
+    case NODE_IMPL_DEF:
+        push_list(walk, count, ast, ((AstImpl *)ast_record(ast, node))->funcs, mask);
+        break;
+
+    case NODE_FUNC_DEF:
+    {
+        AstFuncDef *func_def = (AstFuncDef *)ast_record(ast, node);
+        push(walk, count, func_def->body, mask, 0);
+        push(walk, count, func_def->head, mask, 0);
+        break;
+    }
+
+    case NODE_FUNC_HEAD:
+    {
+        AstFuncHead *head = (AstFuncHead *)ast_record(ast, node);
+        push(walk, count, head->return_type, mask, 0);
+        push_list(walk, count, ast, head->params, mask);
+        break;
+    }
+
+    case NODE_VAR_DECL:
+    {
+        AstVarDecl *var_decl = (AstVarDecl *)ast_record(ast, node);
+        push_list(walk, count, ast, var_decl->dims, mask);
+        push(walk, count, var_decl->type, mask, 0);
+        break;
+    }
+
+    case NODE_IF_STMT:
+    {
+        AstIf *if_stmt = (AstIf *)ast_record(ast, node);
+        push(walk, count, if_stmt->else_body, mask, 0);
+        push(walk, count, if_stmt->then_body, mask, 0);
+        push(walk, count, if_stmt->condition, mask, 0);
+        break;
+    }
+
+    case NODE_WHILE_STMT:
+    {
+        AstWhile *while_stmt = (AstWhile *)ast_record(ast, node);
+        push(walk, count, while_stmt->body, mask, 0);
+        push(walk, count, while_stmt->condition, mask, 0);
+        break;
+    }
+
+    case NODE_ASSIGN_STMT:
+    {
+        AstAssign *assign = (AstAssign *)ast_record(ast, node);
+        push(walk, count, assign->expression, mask, 0);
+        push(walk, count, assign->variable, mask, 0);
+        break;
+    }
+
+    case NODE_VARIABLE:
+    {
+        AstVarAccess *var = (AstVarAccess *)ast_record(ast, node);
+        push_list(walk, count, ast, var->members, mask);
+        push_list(walk, count, ast, var->indices, mask);
+        push(walk, count, var->base, mask, 0);
+        break;
+    }
+
+    case NODE_FUNC_CALL:
+    {
+        AstCall *call = (AstCall *)ast_record(ast, node);
+        push_list(walk, count, ast, call->args, mask);
+        push_list(walk, count, ast, call->id_nest, mask);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void ast_walk_run(AstWalk *walk, CompactAst *ast, AstId root)
+{
+    unsigned int all = walk->count == AST_WALK_MAX_VISITORS ? ~0u : (1u << walk->count) - 1;
+    int count = 0;
+    push(walk, &count, root, all, 0);
+
+    while (count > 0)
+    {
+        AstWalkEntry entry = walk->stack[--count];
+        NodeType kind = ast_kind(ast, entry.node);
+
+        if (entry.leaving)
+        {
+            for (int v = 0; v < walk->count; v++)
+            {
+                AstPostHook post = walk->visitors[v]->post[kind];
+                if (post == NULL || !(entry.mask & (1u << v)))
+                {
+                    continue;
+                }
+                if (walk->costs == NULL)
+                {
+                    post(ast, entry.node, walk->states[v]);
+                    continue;
+                }
+                unsigned long long start = now_ns();
+                post(ast, entry.node, walk->states[v]);
+                AstHookCost *cost = hook_cost(walk, v, kind, 1);
+                cost->ns += now_ns() - start;
+                cost->calls++;
+            }
+            continue;
+        }
+
+        unsigned int mask = entry.mask;
+        for (int v = 0; v < walk->count; v++)
+        {
+            AstPreHook pre = walk->visitors[v]->pre[kind];
+            if (pre == NULL || !(mask & (1u << v)))
+            {
+                continue;
+            }
+            int answer;
+            if (walk->costs == NULL)
+            {
+                answer = pre(ast, entry.node, walk->states[v]);
+            }
+            else
+            {
+                unsigned long long start = now_ns();
+                answer = pre(ast, entry.node, walk->states[v]);
+                AstHookCost *cost = hook_cost(walk, v, kind, 0);
+                cost->ns += now_ns() - start;
+                cost->calls++;
+            }
+            if (answer == AST_VISIT_SKIP)
+            {
+                mask &= ~(1u << v);
+            }
+        }
+
+        if (mask != 0)
+        {
+            push(walk, &count, entry.node, mask, 1);
+            push_children(walk, &count, ast, entry.node, mask);
+        }
+    }
+}
+
+void ast_walk_report(const AstWalk *walk, FILE *out)
+{
+    if (walk->costs == NULL)
+    {
+        return;
+    }
+    for (int v = 0; v < walk->count; v++)
+    {
+        unsigned long long visitor_ns = 0;
+        for (int kind = 0; kind < AST_KIND_COUNT; kind++)
+        {
+            for (int leaving = 0; leaving < 2; leaving++)
+            {
+                const AstHookCost *cost = hook_cost(walk, v, (NodeType)kind, leaving);
+                if (cost->calls == 0)
+                {
+                    continue;
+                }
+                fprintf(out, "  %-14s %-4s %-22s %10llu calls %10.3f ms %8.1f ns/call\n", walk->visitors[v]->name,
+                        leaving ? "post" : "pre", kind_names[kind], cost->calls, cost->ns / 1e6,
+                        (double)cost->ns / cost->calls);
+                visitor_ns += cost->ns;
+            }
+        }
+        fprintf(out, "  %-14s total %.3f ms\n", walk->visitors[v]->name, visitor_ns / 1e6);
+    }
+}
+
+void ast_walk_free(AstWalk *walk)
+{
+    free(walk->costs);
+    free(walk->stack);
+    memset(walk, 0, sizeof(*walk));
+}
+
+void ast_visit(CompactAst *ast, AstId root, const AstVisitor *visitor, void *state)
+{
+    AstWalk walk;
+    ast_walk_init(&walk);
+    ast_walk_add(&walk, visitor, state);
+    ast_walk_run(&walk, ast, root);
+    ast_walk_free(&walk);
+}
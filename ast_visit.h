@@ -0,0 +1,76 @@
+#ifndef AST_VISIT_H
+#define AST_VISIT_H
+
+#include <stdio.h>
+#include "compact_ast.h"
+
+/* One depth-first walk of a compact AST that runs several analyses at
+   once. An analysis is a visitor: tables of pre and post hooks indexed
+   by node kind, called in source order as the walk enters and leaves a
+   node. Kinds without a hook cost the visitor nothing. The walk keeps its
+   own stack, so deep operator chains do not nest C frames. */
+
+#define AST_KIND_COUNT (NODE_ERROR + 1)
+
+/* Visitors one walk can run, one bit each in a node's mask */
+#define AST_WALK_MAX_VISITORS 32
+
+/* A pre hook's answer */
+#define AST_VISIT_CHILDREN 0
+#define AST_VISIT_SKIP 1 /* the visitor sees neither the children nor the post hook */
+
+typedef int (*AstPreHook)(CompactAst *ast, AstId node, void *state);
+typedef void (*AstPostHook)(CompactAst *ast, AstId node, void *state);
+
+typedef struct AstVisitor
+{
+    const char *name;
+    AstPreHook pre[AST_KIND_COUNT];
+    AstPostHook post[AST_KIND_COUNT];
+} AstVisitor;
+
+typedef struct AstHookCost
+{
+    unsigned long long calls;
+    unsigned long long ns;
+} AstHookCost;
+
+typedef struct AstWalkEntry
+{
+    AstId node;
+    unsigned int mask; /* visitors that see the node */
+    int leaving;
+} AstWalkEntry;
+
+typedef struct AstWalk
+{
+    const AstVisitor *visitors[AST_WALK_MAX_VISITORS];
+    void *states[AST_WALK_MAX_VISITORS];
+    int count;
+
+    /* Per visitor, kind and pre/post; NULL unless measuring */
+    AstHookCost *costs;
+
+    AstWalkEntry *stack;
+    int stack_capacity;
+} AstWalk;
+
+void ast_walk_init(AstWalk *walk);
+
+/* Hooks are called in the order their visitors were added */
+void ast_walk_add(AstWalk *walk, const AstVisitor *visitor, void *state);
+
+/* Times every hook call from now on, two clock reads each; ast_walk_report
+   prints the totals */
+void ast_walk_measure(AstWalk *walk);
+
+void ast_walk_run(AstWalk *walk, CompactAst *ast, AstId root);
+
+void ast_walk_report(const AstWalk *walk, FILE *out);
+
+void ast_walk_free(AstWalk *walk);
+
+/* Walks from root with a single visitor */
+void ast_visit(CompactAst *ast, AstId root, const AstVisitor *visitor, void *state);
+
+#endif
@@ -0,0 +1,26 @@
+# A function body with a million statements, a sum of 200k terms and a
+# long else-if chain, each of which took a C stack frame per element
+# when lists and operator chains were parsed and checked recursively:
+#   python checks/big_program.py > big_program.src
+#   compiler big_program.src
+import sys
+
+statements = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+terms = int(sys.argv[2]) if len(sys.argv) > 2 else 200000
+chain = int(sys.argv[3]) if len(sys.argv) > 3 else 100000
+
+out = sys.stdout
+out.write("func main() => void\n{\n    local x: integer;\n    x = 0;\n")
+for i in range(statements):
+    out.write("    x = x + %d;\n" % (i % 1000))
+
+out.write("    x = 0")
+for i in range(terms):
+    out.write(" + %d" % (i % 1000) if i % 2 == 0 else " - x")
+    if i % 20 == 19:
+        out.write("\n       ")
+out.write(";\n")
+
+for i in range(chain):
+    out.write("    if (x == %d) then x = %d; else\n" % (i, i + 1))
+out.write("    x = x * 2;\n}\n")
@@ -0,0 +1,21 @@
+# A function whose body nests blocks, ifs and whiles far deeper than the
+# C stack would allow a frame per level, with an error at the bottom:
+#   python checks/deep_nesting.py > deep_nesting.src
+#   compiler deep_nesting.src
+import sys
+
+depth = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+
+out = sys.stdout
+out.write("func main() => void\n{\n    local x: integer;\n    x = 0;\n")
+for i in range(depth):
+    if i % 3 == 0:
+        out.write("if (x < %d) then {\n" % i)
+    elif i % 3 == 1:
+        out.write("while (x > %d) {\n" % i)
+    else:
+        out.write("if (x == %d) then x = %d; else {\n" % (i, i))
+out.write("x = 1.5;\n")
+for i in reversed(range(depth)):
+    out.write("};\n" if i % 3 == 1 else "}\n")
+out.write("}\n")
@@ -0,0 +1,55 @@
+# A program made almost entirely of expressions, in the places they are
+# most common: array indices, call arguments and conditions. Used with
+# checks/time_parse.py to measure how fast expressions parse:
+#   python checks/expressions.py > expressions.src
+#   python checks/time_parse.py expressions.src compiler
+import random
+import sys
+
+functions = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+seed = int(sys.argv[2]) if len(sys.argv) > 2 else 1
+
+rng = random.Random(seed)
+names = ["a", "b", "i", "j", "n"]
+
+
+def operand(depth):
+    pick = rng.randrange(5 if depth > 0 else 2)
+    if pick == 0:
+        return str(rng.randrange(1000))
+    if pick == 1:
+        return rng.choice(names)
+    if pick == 2:
+        return "v[%s]" % arith(depth - 1)
+    if pick == 3:
+        return "(%s)" % arith(depth - 1)
+    return "f(%s, %s)" % (arith(depth - 1), arith(depth - 1))
+
+
+def arith(depth):
+    text = operand(depth)
+    for _ in range(rng.randrange(4)):
+        text += " %s %s" % (rng.choice(["+", "-", "*", "/"]), operand(depth))
+    return text
+
+
+def condition(depth):
+    return "%s %s %s" % (arith(depth), rng.choice(["<", "<=", ">", ">=", "==", "<>"]), arith(depth))
+
+
+out = sys.stdout
+out.write("func f(p: integer, q: integer) => integer\n{\n    return (p + q);\n}\n")
+for k in range(functions):
+    out.write("func g%d(n: integer) => void\n{\n" % k)
+    out.write("    local a: integer;\n    local b: integer;\n    local i: integer;\n    local j: integer;\n")
+    out.write("    local v: integer[1000];\n")
+    for _ in range(10):
+        kind = rng.randrange(3)
+        if kind == 0:
+            out.write("    v[%s] = %s;\n" % (arith(2), arith(3)))
+        elif kind == 1:
+            out.write("    if (%s) then a = %s; else b = %s;\n" % (condition(2), arith(2), arith(2)))
+        else:
+            out.write("    while (%s) {\n        i = f(%s, %s);\n    };\n" % (condition(2), arith(2), arith(2)))
+    out.write("}\n")
+out.write("func main() => void\n{\n    g0(1);\n}\n")
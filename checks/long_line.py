@@ -0,0 +1,17 @@
+# A program with one line longer than a parallel lexing chunk, so the
+# chunk boundaries of --lexer=parallel fall inside it:
+#   python checks/long_line.py > long_line.src
+#   compiler --lex-diff --lex-jobs=4 long_line.src
+import sys
+
+out = sys.stdout
+out.write("func main() => void\n{\n    local abc0: integer;\n")
+for i in range(1000):
+    out.write("    abc0 = abc0 + %d;\n" % i)
+out.write("   ")
+for i in range(10000):
+    out.write(" abc0 = abc0 * %d;" % i)
+out.write("\n")
+for i in range(2000):
+    out.write("abc0 = abc0 - %d;\n" % i)
+out.write("}\n")
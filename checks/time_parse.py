@@ -0,0 +1,28 @@
+# Runs each compiler given on the command line over a source file with
+# --time and prints the best lexing and parsing times of several runs,
+# so two builds, say from before and after a parser change, can be
+# compared on the same input:
+#   python checks/time_parse.py expressions.src old\compiler compiler
+import re
+import subprocess
+import sys
+
+RUNS = 10
+
+if len(sys.argv) < 3:
+    sys.exit("usage: time_parse.py SOURCE COMPILER...")
+source = sys.argv[1]
+pattern = re.compile(r"Lexing: ([0-9.]+) ms .*Parsing: ([0-9.]+) ms")
+
+for compiler in sys.argv[2:]:
+    lex_best = parse_best = None
+    for _ in range(RUNS):
+        output = subprocess.run([compiler, "--time", "--lexer=fast", source], stdout=subprocess.PIPE,
+                                universal_newlines=True).stdout
+        match = pattern.search(output)
+        if match is None:
+            sys.exit("%s printed no timings for %s" % (compiler, source))
+        lex_ms, parse_ms = float(match.group(1)), float(match.group(2))
+        lex_best = lex_ms if lex_best is None else min(lex_best, lex_ms)
+        parse_best = parse_ms if parse_best is None else min(parse_best, parse_ms)
+    print("%s: lexing %.3f ms, parsing %.3f ms (best of %d)" % (compiler, lex_best, parse_best, RUNS))
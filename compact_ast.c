@@ -0,0 +1,958 @@
+#include "compact_ast.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COMPACT_INITIAL_CAPACITY 256
+
+/* Build-time map from interned name pointers to names table indexes */
+typedef struct NameSlot
+{
+    const char *name; /* NULL for an empty slot */
+    unsigned int index;
+} NameSlot;
+
+/* An operator node on the left spine of a chain, waiting for its right operand */
+typedef struct SpineEntry
+{
+    struct BinOpNode *node;
+    AstId id;
+} SpineEntry;
+
+/* A block, if or while whose children are being flattened. Bodies nest
+   one level per statement, so they are walked with an explicit stack. */
+typedef struct NestEntry
+{
+    struct ASTNode *node;
+    AstId id;
+    int stage; /* children stored so far */
+    union
+    {
+        AstIf if_record;
+        AstWhile while_record;
+        AstBlock block;
+    } record;
+    struct ASTNode *item;     /* next block item to flatten */
+    unsigned int outer_scope; /* scope to restore after a block */
+} NestEntry;
+
+/* An expression node later uses may share */
+typedef struct ShareSlot
+{
+    unsigned int hash;
+    unsigned int owner; /* function of a variable, else 0 */
+    AstId id;           /* 0 for an empty slot */
+    int reused;         /* set once a later use has found it */
+} ShareSlot;
+
+typedef struct Builder
+{
+    CompactAst *ast;
+    NameSlot *slots;
+    int capacity;
+
+    SpineEntry *spine;
+    int spine_count;
+    int spine_capacity;
+
+    NestEntry *nest;
+    int nest_count;
+    int nest_capacity;
+
+    unsigned int scope;  /* slot of the function or block being flattened */
+    unsigned int parent; /* offset of the node whose children are being flattened */
+
+    /* Set when expressions are shared. The table holds every shareable
+       node of the file that is on its parent's line. */
+    const LineIndex *lines;
+    ShareSlot *shares;
+    int share_count;
+    int share_capacity;
+    int line;                /* 1-based line last looked up */
+    unsigned int line_start; /* offsets it spans */
+    unsigned int line_end;
+    unsigned int function;  /* function being flattened, 0 outside any */
+    unsigned int functions; /* functions entered so far */
+    AstId *reused;          /* composite nodes found again, each once */
+    int reused_count;
+    int reused_capacity;
+} Builder;
+
+static void *grow(void *data, int *capacity, int needed, size_t size)
+{
+    int new_capacity = *capacity;
+    while (new_capacity < needed)
+    {
+        new_capacity *= 2;
+    }
+    *capacity = new_capacity;
+    return realloc(data, new_capacity * size);
+}
+
+static AstId new_node(CompactAst *ast, NodeType kind, unsigned int offset)
+{
+    if (ast->count == ast->capacity)
+    {
+        ast->capacity *= 2;
+        ast->kind = (unsigned char *)realloc(ast->kind, ast->capacity * sizeof(unsigned char));
+        ast->offset = (unsigned int *)realloc(ast->offset, ast->capacity * sizeof(unsigned int));
+        ast->word = (unsigned int *)realloc(ast->word, ast->capacity * sizeof(unsigned int));
+        if (ast->on_parent_line != NULL)
+        {
+            ast->on_parent_line = (unsigned int *)realloc(ast->on_parent_line, ast->capacity / 32 * sizeof(unsigned int));
+        }
+    }
+    AstId id = (AstId)ast->count++;
+    ast->kind[id] = (unsigned char)kind;
+    ast->offset[id] = offset;
+    ast->word[id] = 0;
+    if (ast->on_parent_line != NULL)
+    {
+        ast->on_parent_line[id >> 5] &= ~(1u << (id & 31));
+    }
+    return id;
+}
+
+/* Copies a record of 32-bit fields into the pool and returns its index */
+static unsigned int put_record(CompactAst *ast, const void *record, size_t size)
+{
+    int words = (int)(size / sizeof(unsigned int));
+    if (ast->pool_count + words > ast->pool_capacity)
+    {
+        ast->pool = (unsigned int *)grow(ast->pool, &ast->pool_capacity, ast->pool_count + words, sizeof(unsigned int));
+    }
+    unsigned int index = (unsigned int)ast->pool_count;
+    memcpy(ast->pool + index, record, size);
+    ast->pool_count += words;
+    return index;
+}
+
+static unsigned int new_scope_slot(CompactAst *ast)
+{
+    if (ast->scope_count == ast->scope_capacity)
+    {
+        ast->scopes = (struct Scope **)grow(ast->scopes, &ast->scope_capacity, ast->scope_count + 1, sizeof(struct Scope *));
+    }
+    ast->scopes[ast->scope_count] = NULL;
+    return (unsigned int)ast->scope_count++;
+}
+
+static unsigned int name_hash(const char *name)
+{
+    return (unsigned int)(((uintptr_t)name >> 3) * 2654435761u);
+}
+
+static void name_slots_grow(Builder *b)
+{
+    NameSlot *old = b->slots;
+    int old_capacity = b->capacity;
+
+    b->capacity = old_capacity * 2;
+    b->slots = (NameSlot *)calloc(b->capacity, sizeof(NameSlot));
+    unsigned int mask = (unsigned int)b->capacity - 1;
+    for (int i = 0; i < old_capacity; i++)
+    {
+        if (old[i].name != NULL)
+        {
+            unsigned int j = name_hash(old[i].name) & mask;
+            while (b->slots[j].name != NULL)
+            {
+                j = (j + 1) & mask;
+            }
+            b->slots[j] = old[i];
+        }
+    }
+    free(old);
+}
+
+/* Names are interned, so equal names share a pointer and one table entry */
+static unsigned int name_index(Builder *b, const char *name)
+{
+    CompactAst *ast = b->ast;
+    unsigned int mask = (unsigned int)b->capacity - 1;
+    unsigned int i = name_hash(name) & mask;
+    for (; b->slots[i].name != NULL; i = (i + 1) & mask)
+    {
+        if (b->slots[i].name == name)
+        {
+            return b->slots[i].index;
+        }
+    }
+
+    if (ast->name_count == ast->name_capacity)
+    {
+        ast->names = (const char **)grow(ast->names, &ast->name_capacity, ast->name_count + 1, sizeof(const char *));
+    }
+    unsigned int index = (unsigned int)ast->name_count++;
+    ast->names[index] = name;
+
+    b->slots[i].name = name;
+    b->slots[i].index = index;
+    if (2 * ast->name_count > b->capacity)
+    {
+        name_slots_grow(b);
+    }
+    return index;
+}
+
+static unsigned int mix(unsigned int h, unsigned int word)
+{
+    return (h ^ word) * 16777619u;
+}
+
+static int is_shareable(NodeType kind)
+{
+    switch (kind)
+    {
+    case NODE_INT_LIT:
+    case NODE_FLOAT_LIT:
+    case NODE_STRING_LIT:
+    case NODE_ID:
+    case NODE_VARIABLE:
+    case NODE_UNARY_OP:
+    case NODE_BIN_OP:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Whether typing the node means typing others, so its type is worth
+   keeping; a literal or a bare name is as quick to type again */
+static int is_composite(const CompactAst *ast, AstId id)
+{
+    if (ast_kind(ast, id) == NODE_VARIABLE)
+    {
+        const AstVarAccess *var = (const AstVarAccess *)ast_record(ast, id);
+        return var->indices.count != 0 || var->members.count != 0;
+    }
+    return ast_kind(ast, id) == NODE_UNARY_OP || ast_kind(ast, id) == NODE_BIN_OP;
+}
+
+static unsigned int list_hash(const CompactAst *ast, unsigned int h, AstList list)
+{
+    h = mix(h, list.count);
+    for (unsigned int i = 0; i < list.count; i++)
+    {
+        h = mix(h, ast_item(ast, list, i));
+    }
+    return h;
+}
+
+static int same_list(const CompactAst *ast, AstList a, AstList b)
+{
+    if (a.count != b.count)
+    {
+        return 0;
+    }
+    for (unsigned int i = 0; i < a.count; i++)
+    {
+        if (ast->items[a.first + i] != ast->items[b.first + i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Hash of what the node is, not where it is; children are compared by id,
+   which is enough once they are shared themselves */
+static unsigned int expression_hash(const CompactAst *ast, AstId id)
+{
+    unsigned int h = mix(2166136261u, ast->kind[id]);
+    switch (ast_kind(ast, id))
+    {
+    case NODE_UNARY_OP:
+    {
+        const AstUnary *unary = (const AstUnary *)ast_record(ast, id);
+        return mix(mix(h, unary->op), unary->operand);
+    }
+    case NODE_BIN_OP:
+    {
+        const AstBinary *binary = (const AstBinary *)ast_record(ast, id);
+        return mix(mix(mix(h, binary->op), binary->left), binary->right);
+    }
+    case NODE_VARIABLE:
+    {
+        const AstVarAccess *var = (const AstVarAccess *)ast_record(ast, id);
+        return list_hash(ast, list_hash(ast, mix(h, var->base), var->indices), var->members);
+    }
+    default:
+        return mix(h, ast->word[id]);
+    }
+}
+
+static int same_expression(const CompactAst *ast, AstId a, AstId b)
+{
+    if (ast->kind[a] != ast->kind[b])
+    {
+        return 0;
+    }
+    switch (ast_kind(ast, a))
+    {
+    case NODE_UNARY_OP:
+    {
+        const AstUnary *unary_a = (const AstUnary *)ast_record(ast, a);
+        const AstUnary *unary_b = (const AstUnary *)ast_record(ast, b);
+        return unary_a->op == unary_b->op && unary_a->operand == unary_b->operand;
+    }
+    case NODE_BIN_OP:
+    {
+        const AstBinary *binary_a = (const AstBinary *)ast_record(ast, a);
+        const AstBinary *binary_b = (const AstBinary *)ast_record(ast, b);
+        return binary_a->op == binary_b->op && binary_a->left == binary_b->left && binary_a->right == binary_b->right;
+    }
+    case NODE_VARIABLE:
+    {
+        const AstVarAccess *var_a = (const AstVarAccess *)ast_record(ast, a);
+        const AstVarAccess *var_b = (const AstVarAccess *)ast_record(ast, b);
+        return var_a->base == var_b->base && same_list(ast, var_a->indices, var_b->indices) &&
+               same_list(ast, var_a->members, var_b->members);
+    }
+    default:
+        return ast->word[a] == ast->word[b];
+    }
+}
+
+static void shares_grow(Builder *b)
+{
+    ShareSlot *old = b->shares;
+    int old_capacity = b->share_capacity;
+
+    b->share_capacity = old_capacity * 2;
+    b->shares = (ShareSlot *)calloc(b->share_capacity, sizeof(ShareSlot));
+    unsigned int mask = (unsigned int)b->share_capacity - 1;
+    for (int i = 0; i < old_capacity; i++)
+    {
+        if (old[i].id != 0)
+        {
+            unsigned int j = old[i].hash & mask;
+            while (b->shares[j].id != 0)
+            {
+                j = (j + 1) & mask;
+            }
+            b->shares[j] = old[i];
+        }
+    }
+    free(old);
+}
+
+/* Whether two offsets are on one line. Nodes mostly come in source
+   order, so the line of the last lookup and the one after it are tried
+   before searching. */
+static int same_line(Builder *b, unsigned int offset, unsigned int other)
+{
+    if (offset < b->line_start || offset >= b->line_end)
+    {
+        int line = b->line + 1;
+        if (offset < b->line_end || (line < b->lines->count && offset >= b->lines->starts[line]))
+        {
+            line = line_index_line(b->lines, offset);
+        }
+        b->line = line;
+        b->line_start = b->lines->starts[line - 1];
+        b->line_end = line < b->lines->count ? b->lines->starts[line] : ~0u;
+    }
+    return other >= b->line_start && other < b->line_end;
+}
+
+/* Returns the node an identical expression anywhere in the file already
+   has, dropping id along with the pool and list space taken since the
+   marks. A node can only match when all its children did, so nothing was
+   built after it. Otherwise id is kept for later uses.
+
+   Variables only match within one function, where a name always binds
+   to the same symbol, so every use of a node has the same type. Only
+   nodes on their parent's line take part, in every use, so a diagnostic
+   at one can be reported at the parent's offset; see ast_use_offset. */
+static AstId share(Builder *b, AstId id, unsigned int parent, int pool_mark, int item_mark)
+{
+    CompactAst *ast = b->ast;
+    if (!same_line(b, parent, ast->offset[id]))
+    {
+        return id;
+    }
+    unsigned int owner = ast_kind(ast, id) == NODE_VARIABLE ? b->function : 0;
+    unsigned int hash = mix(expression_hash(ast, id), owner);
+
+    unsigned int mask = (unsigned int)b->share_capacity - 1;
+    unsigned int i = hash & mask;
+    for (; b->shares[i].id != 0; i = (i + 1) & mask)
+    {
+        ShareSlot *slot = &b->shares[i];
+        if (slot->hash == hash && slot->owner == owner && same_expression(ast, slot->id, id))
+        {
+            ast->count = (int)id;
+            ast->pool_count = pool_mark;
+            ast->item_count = item_mark;
+            ast->shared++;
+            if (!slot->reused && is_composite(ast, slot->id))
+            {
+                if (b->reused_count == b->reused_capacity)
+                {
+                    b->reused = (AstId *)grow(b->reused, &b->reused_capacity, b->reused_count + 1, sizeof(AstId));
+                }
+                b->reused[b->reused_count++] = slot->id;
+                slot->reused = 1;
+            }
+            return slot->id;
+        }
+    }
+
+    b->shares[i].hash = hash;
+    b->shares[i].owner = owner;
+    b->shares[i].id = id;
+    b->shares[i].reused = 0;
+    ast->on_parent_line[id >> 5] |= 1u << (id & 31);
+    if (2 * ++b->share_count > b->share_capacity)
+    {
+        shares_grow(b);
+    }
+    return id;
+}
+
+/* A variable gets its slot once it is known not to be shared, so each
+   slot has one node */
+static unsigned int new_binding_slot(Builder *b, AstId id)
+{
+    CompactAst *ast = b->ast;
+    if (ast->binding_count == ast->binding_capacity)
+    {
+        int capacity = ast->binding_capacity;
+        ast->uses = (AstUse *)grow(ast->uses, &capacity, ast->binding_count + 1, sizeof(AstUse));
+        ast->bindings = (struct SymbolEntry **)grow(ast->bindings, &ast->binding_capacity, ast->binding_count + 1,
+                                                    sizeof(struct SymbolEntry *));
+    }
+    ast->uses[ast->binding_count].node = id;
+    ast->uses[ast->binding_count].scope = b->scope;
+    ast->bindings[ast->binding_count] = NULL;
+    return (unsigned int)ast->binding_count++;
+}
+
+static AstId flatten(Builder *b, struct ASTNode *node);
+
+/* Reserves the list's run in items before its elements are flattened, so
+   their own lists are placed after it */
+static AstList reserve_list(Builder *b, struct ASTNode *head)
+{
+    CompactAst *ast = b->ast;
+    AstList list;
+    list.first = (unsigned int)ast->item_count;
+    list.count = 0;
+    for (struct ASTNode *node = head; node != NULL; node = node->next)
+    {
+        list.count++;
+    }
+    if (list.count == 0)
+    {
+        return list;
+    }
+
+    if (ast->item_count + (int)list.count > ast->item_capacity)
+    {
+        ast->items = (AstId *)grow(ast->items, &ast->item_capacity, ast->item_count + list.count, sizeof(AstId));
+    }
+    ast->item_count += list.count;
+    return list;
+}
+
+static AstList flatten_list(Builder *b, struct ASTNode *head)
+{
+    CompactAst *ast = b->ast;
+    AstList list = reserve_list(b, head);
+    unsigned int i = list.first;
+    for (struct ASTNode *node = head; node != NULL; node = node->next)
+    {
+        AstId id = flatten(b, node);
+        ast->items[i++] = id;
+    }
+    return list;
+}
+
+/* Flattens a chain along its left spine; see AstBinary. Ids come out in
+   the same preorder as the recursive walk. */
+static AstId flatten_chain(Builder *b, struct ASTNode *node)
+{
+    CompactAst *ast = b->ast;
+    unsigned int parent = b->parent;
+    int base = b->spine_count;
+    while (node != NULL && node->type == NODE_BIN_OP)
+    {
+        if (b->spine_count == b->spine_capacity)
+        {
+            b->spine = (SpineEntry *)grow(b->spine, &b->spine_capacity, b->spine_count + 1, sizeof(SpineEntry));
+        }
+        b->spine[b->spine_count].node = (struct BinOpNode *)node;
+        b->spine[b->spine_count].id = new_node(ast, node->type, node->offset);
+        b->spine_count++;
+        node = ((struct BinOpNode *)node)->left;
+    }
+
+    b->parent = b->spine[b->spine_count - 1].node->offset;
+    AstId left = flatten(b, node);
+    while (b->spine_count > base)
+    {
+        SpineEntry entry = b->spine[--b->spine_count];
+        unsigned int entry_parent = b->spine_count > base ? b->spine[b->spine_count - 1].node->offset : parent;
+        AstBinary record;
+        record.op = (unsigned int)entry.node->op;
+        record.left = left;
+        b->parent = entry.node->offset;
+        record.right = flatten(b, entry.node->right);
+        int pool_mark = ast->pool_count;
+        ast->word[entry.id] = put_record(ast, &record, sizeof(record));
+        left = b->shares != NULL ? share(b, entry.id, entry_parent, pool_mark, ast->item_count) : entry.id;
+    }
+    b->parent = parent;
+    return left;
+}
+
+static int is_nested(struct ASTNode *node)
+{
+    return node != NULL &&
+           (node->type == NODE_STAT_BLOCK || node->type == NODE_IF_STMT || node->type == NODE_WHILE_STMT);
+}
+
+static void push_nested(Builder *b, struct ASTNode *node)
+{
+    CompactAst *ast = b->ast;
+    if (b->nest_count == b->nest_capacity)
+    {
+        b->nest = (NestEntry *)grow(b->nest, &b->nest_capacity, b->nest_count + 1, sizeof(NestEntry));
+    }
+    NestEntry *entry = &b->nest[b->nest_count++];
+    entry->node = node;
+    entry->id = new_node(ast, node->type, node->offset);
+    entry->stage = 0;
+    if (node->type == NODE_STAT_BLOCK)
+    {
+        entry->outer_scope = b->scope;
+        entry->record.block.scope = b->scope = new_scope_slot(ast);
+        entry->item = ((struct GenericNode *)node)->child1;
+        entry->record.block.items = reserve_list(b, entry->item);
+    }
+}
+
+/* The entry's next child, or 0 once it has them all */
+static int next_nested_child(const NestEntry *entry, struct ASTNode **child)
+{
+    switch (entry->node->type)
+    {
+    case NODE_IF_STMT:
+    {
+        struct IfNode *if_node = (struct IfNode *)entry->node;
+        struct ASTNode *children[3] = {if_node->condition, if_node->if_body, if_node->else_body};
+        if (entry->stage == 3)
+            return 0;
+        *child = children[entry->stage];
+        return 1;
+    }
+    case NODE_WHILE_STMT:
+    {
+        struct WhileNode *while_node = (struct WhileNode *)entry->node;
+        if (entry->stage == 2)
+            return 0;
+        *child = entry->stage == 0 ? while_node->condition : while_node->while_body;
+        return 1;
+    }
+    default:
+        if (entry->item == NULL)
+            return 0;
+        *child = entry->item;
+        return 1;
+    }
+}
+
+static void store_nested_child(Builder *b, NestEntry *entry, AstId id)
+{
+    switch (entry->node->type)
+    {
+    case NODE_IF_STMT:
+    {
+        AstId *fields[3] = {&entry->record.if_record.condition, &entry->record.if_record.then_body,
+                            &entry->record.if_record.else_body};
+        *fields[entry->stage] = id;
+        break;
+    }
+    case NODE_WHILE_STMT:
+        if (entry->stage == 0)
+            entry->record.while_record.condition = id;
+        else
+            entry->record.while_record.body = id;
+        break;
+    default:
+        b->ast->items[entry->record.block.items.first + entry->stage] = id;
+        entry->item = entry->item->next;
+        break;
+    }
+    entry->stage++;
+}
+
+static void finish_nested(Builder *b, NestEntry *entry)
+{
+    CompactAst *ast = b->ast;
+    size_t size = sizeof(AstBlock);
+    if (entry->node->type == NODE_IF_STMT)
+    {
+        size = sizeof(AstIf);
+    }
+    else if (entry->node->type == NODE_WHILE_STMT)
+    {
+        size = sizeof(AstWhile);
+    }
+    else
+    {
+        b->scope = entry->outer_scope;
+    }
+    ast->word[entry->id] = put_record(ast, &entry->record, size);
+}
+
+/* Blocks, ifs and whiles nest one level per statement, so they are walked
+   with an explicit stack like operator chains. Ids, records and slots come
+   out in the same order as the recursive walk; other statements and
+   expressions are still flattened by a call each. */
+static AstId flatten_nested(Builder *b, struct ASTNode *node)
+{
+    unsigned int parent = b->parent;
+    int base = b->nest_count;
+    push_nested(b, node);
+    for (;;)
+    {
+        struct ASTNode *child;
+        if (!next_nested_child(&b->nest[b->nest_count - 1], &child))
+        {
+            NestEntry *entry = &b->nest[--b->nest_count];
+            finish_nested(b, entry);
+            if (b->nest_count == base)
+            {
+                b->parent = parent;
+                return entry->id;
+            }
+            store_nested_child(b, &b->nest[b->nest_count - 1], entry->id);
+        }
+        else if (is_nested(child))
+        {
+            push_nested(b, child);
+        }
+        else
+        {
+            b->parent = b->nest[b->nest_count - 1].node->offset;
+            AstId id = flatten(b, child);
+            store_nested_child(b, &b->nest[b->nest_count - 1], id);
+        }
+    }
+}
+
+static AstId flatten(Builder *b, struct ASTNode *node)
+{
+    if (node == NULL)
+        return 0;
+    if (node->type == NODE_BIN_OP)
+        return flatten_chain(b, node);
+    if (is_nested(node))
+        return flatten_nested(b, node);
+
+    CompactAst *ast = b->ast;
+    int pool_mark = ast->pool_count;
+    int item_mark = ast->item_count;
+    AstId id = new_node(ast, node->type, node->offset);
+    unsigned int word = 0;
+    unsigned int parent = b->parent;
+    b->parent = node->offset;
+
+    switch (node->type)
+    {
+    case NODE_PROG:
+    case NODE_FUNC_BODY:
+    {
+        AstList list = flatten_list(b, ((struct GenericNode *)node)->child1);
+        word = put_record(ast, &list, sizeof(list));
+        break;
+    }
+
+    case NODE_ATTRIBUTE_DECL:
+    case NODE_FUNC_DECL:
+    case NODE_READ_STMT:
+    case NODE_WRITE_STMT:
+        word = flatten(b, ((struct GenericNode *)node)->child1);
+        break;
+
+    case NODE_RETURN_STMT:
+    {
+        AstReturn record;
+        record.value = flatten(b, ((struct GenericNode *)node)->child1);
+        record.binding = new_binding_slot(b, id);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_ID:
+    case NODE_TYPE:
+    case NODE_PUBLIC:
+    case NODE_PRIVATE:
+        word = name_index(b, ((struct IdentifierNode *)node)->name);
+        break;
+
+    case NODE_STRING_LIT:
+        word = name_index(b, ((struct LiteralNode *)node)->value.string_value);
+        break;
+
+    case NODE_INT_LIT:
+        word = (unsigned int)((struct LiteralNode *)node)->value.int_value;
+        break;
+
+    case NODE_FLOAT_LIT:
+        memcpy(&word, &((struct LiteralNode *)node)->value.float_value, sizeof(word));
+        break;
+
+    case NODE_OP:
+        word = (unsigned int)((struct UnaryOpNode *)node)->op;
+        break;
+
+    case NODE_UNARY_OP:
+    {
+        struct UnaryOpNode *unary = (struct UnaryOpNode *)node;
+        AstUnary record;
+        record.op = (unsigned int)unary->op;
+        record.operand = flatten(b, unary->operand);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_CLASS_DECL:
+    {
+        struct ClassDeclNode *class_decl = (struct ClassDeclNode *)node;
+        AstClass record;
+        record.name = name_index(b, class_decl->id);
+        record.isa = flatten_list(b, class_decl->isa_list);
+        record.inherits = flatten_list(b, class_decl->inheritance_list);
+        record.members = flatten_list(b, class_decl->members);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_IMPL_DEF:
+    {
+        struct ImplDefNode *impl = (struct ImplDefNode *)node;
+        AstImpl record;
+        record.name = name_index(b, impl->id);
+        record.funcs = flatten_list(b, impl->func_defs);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_FUNC_DEF:
+    {
+        struct FuncDefNode *func_def = (struct FuncDefNode *)node;
+        unsigned int outer_function = b->function;
+        unsigned int outer_scope = b->scope;
+        AstFuncDef record;
+        b->function = ++b->functions;
+        record.scope = b->scope = new_scope_slot(ast);
+        record.head = flatten(b, func_def->func_head);
+        record.body = flatten(b, func_def->func_body);
+        b->function = outer_function;
+        b->scope = outer_scope;
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_FUNC_HEAD:
+    {
+        struct FuncHeadNode *head = (struct FuncHeadNode *)node;
+        AstFuncHead record;
+        record.is_constructor = (unsigned int)head->is_constructor;
+        record.name = name_index(b, head->id);
+        record.params = flatten_list(b, head->params);
+        record.return_type = flatten(b, head->return_type);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_VAR_DECL:
+    {
+        struct VarDeclNode *var_decl = (struct VarDeclNode *)node;
+        AstVarDecl record;
+        record.name = name_index(b, var_decl->id);
+        record.type = flatten(b, var_decl->type_node);
+        record.dims = flatten_list(b, var_decl->array_dims);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_ASSIGN_STMT:
+    {
+        struct AssignNode *assign = (struct AssignNode *)node;
+        AstAssign record;
+        record.variable = flatten(b, assign->variable);
+        record.expression = flatten(b, assign->expression);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_VARIABLE:
+    {
+        struct VarAccessNode *var = (struct VarAccessNode *)node;
+        AstVarAccess record;
+        record.base = flatten(b, var->base);
+        record.indices = flatten_list(b, var->indices);
+        record.members = flatten_list(b, var->members);
+        record.binding = 0; /* given once the node is known not to be shared */
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    case NODE_FUNC_CALL:
+    {
+        struct FuncCallNode *call = (struct FuncCallNode *)node;
+        AstCall record;
+        record.name = name_index(b, call->id);
+        record.id_nest = flatten_list(b, call->id_nest);
+        record.args = flatten_list(b, call->args);
+        record.binding = new_binding_slot(b, id);
+        word = put_record(ast, &record, sizeof(record));
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    b->parent = parent;
+    ast->word[id] = word;
+    if (b->shares != NULL && is_shareable(node->type))
+    {
+        AstId shared = share(b, id, parent, pool_mark, item_mark);
+        if (shared != id)
+        {
+            return shared;
+        }
+    }
+    if (node->type == NODE_VARIABLE)
+    {
+        ((AstVarAccess *)ast_record(ast, id))->binding = new_binding_slot(b, id);
+    }
+    return id;
+}
+
+static void build(CompactAst *ast, struct ASTNode *root, const LineIndex *lines)
+{
+    memset(ast, 0, sizeof(*ast));
+    ast->capacity = COMPACT_INITIAL_CAPACITY;
+    ast->pool_capacity = COMPACT_INITIAL_CAPACITY;
+    ast->item_capacity = COMPACT_INITIAL_CAPACITY;
+    ast->name_capacity = COMPACT_INITIAL_CAPACITY;
+    ast->scope_capacity = COMPACT_INITIAL_CAPACITY / 4;
+    ast->kind = (unsigned char *)malloc(ast->capacity * sizeof(unsigned char));
+    ast->offset = (unsigned int *)malloc(ast->capacity * sizeof(unsigned int));
+    ast->word = (unsigned int *)malloc(ast->capacity * sizeof(unsigned int));
+    ast->pool = (unsigned int *)malloc(ast->pool_capacity * sizeof(unsigned int));
+    ast->items = (AstId *)malloc(ast->item_capacity * sizeof(AstId));
+    ast->names = (const char **)malloc(ast->name_capacity * sizeof(const char *));
+    ast->scopes = (struct Scope **)malloc(ast->scope_capacity * sizeof(struct Scope *));
+    ast->binding_capacity = COMPACT_INITIAL_CAPACITY;
+    ast->uses = (AstUse *)malloc(ast->binding_capacity * sizeof(AstUse));
+    ast->bindings = (struct SymbolEntry **)malloc(ast->binding_capacity * sizeof(struct SymbolEntry *));
+
+    if (lines != NULL)
+    {
+        ast->on_parent_line = (unsigned int *)calloc(ast->capacity / 32, sizeof(unsigned int));
+    }
+
+    /* Id 0 is the null node */
+    new_node(ast, NODE_PROG, 0);
+
+    Builder b;
+    b.ast = ast;
+    b.capacity = COMPACT_INITIAL_CAPACITY;
+    b.slots = (NameSlot *)calloc(b.capacity, sizeof(NameSlot));
+    b.spine_capacity = 64;
+    b.spine_count = 0;
+    b.spine = (SpineEntry *)malloc(b.spine_capacity * sizeof(SpineEntry));
+    b.nest_capacity = 64;
+    b.nest_count = 0;
+    b.nest = (NestEntry *)malloc(b.nest_capacity * sizeof(NestEntry));
+    b.lines = lines;
+    b.shares = NULL;
+    b.share_count = 0;
+    b.share_capacity = COMPACT_INITIAL_CAPACITY;
+    b.line = 0;
+    b.line_start = 1;
+    b.line_end = 0;
+    b.function = 0;
+    b.functions = 0;
+    b.scope = 0;
+    b.parent = 0;
+    b.reused = NULL;
+    b.reused_count = 0;
+    b.reused_capacity = 64;
+    if (lines != NULL)
+    {
+        b.shares = (ShareSlot *)calloc(b.share_capacity, sizeof(ShareSlot));
+        b.reused = (AstId *)malloc(b.reused_capacity * sizeof(AstId));
+    }
+    ast->root = flatten(&b, root);
+    free(b.slots);
+    free(b.spine);
+    free(b.nest);
+    free(b.shares);
+
+    if (lines != NULL)
+    {
+        ast->type_capacity = 16;
+        while (ast->type_capacity < 2 * b.reused_count)
+        {
+            ast->type_capacity *= 2;
+        }
+        ast->types = (AstTypeMemo *)calloc(ast->type_capacity, sizeof(AstTypeMemo));
+        unsigned int mask = (unsigned int)ast->type_capacity - 1;
+        for (int r = 0; r < b.reused_count; r++)
+        {
+            unsigned int i = b.reused[r] & mask;
+            while (ast->types[i].node != 0)
+            {
+                i = (i + 1) & mask;
+            }
+            ast->types[i].node = b.reused[r];
+        }
+    }
+    free(b.reused);
+}
+
+void compact_ast_build(CompactAst *ast, struct ASTNode *root)
+{
+    build(ast, root, NULL);
+}
+
+void compact_ast_build_shared(CompactAst *ast, struct ASTNode *root, const LineIndex *lines)
+{
+    build(ast, root, lines);
+}
+
+void compact_ast_free(CompactAst *ast)
+{
+    free(ast->kind);
+    free(ast->offset);
+    free(ast->word);
+    free(ast->pool);
+    free(ast->items);
+    free(ast->names);
+    free(ast->scopes);
+    free(ast->uses);
+    free(ast->bindings);
+    free(ast->types);
+    free(ast->on_parent_line);
+    memset(ast, 0, sizeof(*ast));
+}
+
+size_t compact_ast_bytes(const CompactAst *ast)
+{
+    return (size_t)ast->count * (sizeof(unsigned char) + 2 * sizeof(unsigned int)) +
+           (size_t)ast->pool_count * sizeof(unsigned int) +
+           (size_t)ast->item_count * sizeof(AstId) +
+           (size_t)ast->name_count * sizeof(const char *) +
+           (size_t)ast->scope_count * sizeof(struct Scope *) +
+           (size_t)ast->binding_count * (sizeof(AstUse) + sizeof(struct SymbolEntry *)) +
+           (size_t)ast->type_capacity * sizeof(AstTypeMemo) +
+           (ast->on_parent_line != NULL ? (size_t)(ast->count + 31) / 32 * sizeof(unsigned int) : 0);
+}
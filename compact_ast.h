@@ -0,0 +1,268 @@
+#ifndef COMPACT_AST_H
+#define COMPACT_AST_H
+
+#include <stddef.h>
+#include "ast.h"
+#include "line_index.h"
+
+/* Index form of the AST read by the semantic passes. A node is a kind,
+   a source offset and one 32-bit word. Leaves keep their value in the
+   word; other kinds point it at a fixed-size record in the pool, so each
+   kind only pays for the fields it has. Child lists are contiguous runs
+   of ids in items[] rather than next chains, and only the kinds that open
+   a scope (function definitions and statement blocks) carry a scope slot.
+   Likewise only the kinds that name a symbol (variables, calls and
+   returns) carry a binding slot. Id 0 is the null node. */
+
+typedef unsigned int AstId;
+
+typedef struct AstList
+{
+    unsigned int first; /* index into items */
+    unsigned int count;
+} AstList;
+
+/* Pool records; names are indexes into the names table */
+typedef struct AstBlock
+{
+    AstList items;
+    unsigned int scope;
+} AstBlock;
+
+typedef struct AstUnary
+{
+    unsigned int op;
+    AstId operand;
+} AstUnary;
+
+/* A left-associative chain such as a + b + c nests one level per operator
+   on the left, so code that descends one walks its left spine with an
+   explicit stack rather than a C frame per operator */
+typedef struct AstBinary
+{
+    unsigned int op;
+    AstId left;
+    AstId right;
+} AstBinary;
+
+typedef struct AstClass
+{
+    unsigned int name;
+    AstList isa;
+    AstList inherits;
+    AstList members;
+} AstClass;
+
+typedef struct AstImpl
+{
+    unsigned int name;
+    AstList funcs;
+} AstImpl;
+
+typedef struct AstFuncDef
+{
+    AstId head;
+    AstId body;
+    unsigned int scope;
+} AstFuncDef;
+
+typedef struct AstFuncHead
+{
+    unsigned int is_constructor;
+    unsigned int name;
+    AstList params;
+    AstId return_type;
+} AstFuncHead;
+
+typedef struct AstVarDecl
+{
+    unsigned int name;
+    AstId type;
+    AstList dims;
+} AstVarDecl;
+
+typedef struct AstIf
+{
+    AstId condition;
+    AstId then_body;
+    AstId else_body;
+} AstIf;
+
+typedef struct AstWhile
+{
+    AstId condition;
+    AstId body;
+} AstWhile;
+
+typedef struct AstAssign
+{
+    AstId variable;
+    AstId expression;
+} AstAssign;
+
+typedef struct AstVarAccess
+{
+    AstId base;
+    AstList indices;
+    AstList members;
+    unsigned int binding;
+} AstVarAccess;
+
+typedef struct AstCall
+{
+    unsigned int name;
+    AstList id_nest;
+    AstList args;
+    unsigned int binding;
+} AstCall;
+
+typedef struct AstReturn
+{
+    AstId value;
+    unsigned int binding; /* the function returned from */
+} AstReturn;
+
+/* What a binding slot binds: a variable, call or return, and the scope
+   slot of the innermost function or block around it */
+typedef struct AstUse
+{
+    AstId node;
+    unsigned int scope;
+} AstUse;
+
+/* Type of a shared expression, NULL until one is found. Variables are
+   only shared within a function, so every use sees the same symbols. */
+typedef struct AstTypeMemo
+{
+    AstId node; /* 0 for an empty slot */
+    const char *type;
+} AstTypeMemo;
+
+typedef struct CompactAst
+{
+    unsigned char *kind;
+    unsigned int *offset;
+    unsigned int *word;
+    int count;
+    int capacity;
+
+    unsigned int *pool;
+    int pool_count;
+    int pool_capacity;
+
+    AstId *items;
+    int item_count;
+    int item_capacity;
+
+    const char **names; /* interned, not owned */
+    int name_count;
+    int name_capacity;
+
+    struct Scope **scopes;
+    int scope_count;
+    int scope_capacity;
+
+    AstUse *uses;                  /* by binding slot, in source order */
+    struct SymbolEntry **bindings; /* by binding slot; set by name resolution */
+    int binding_count;
+    int binding_capacity;
+
+    AstTypeMemo *types; /* hash table of the nodes with several uses; NULL when not shared */
+    int type_capacity;
+    int shared; /* expression uses that found an identical node */
+
+    /* Bit per node, set for those on their parent's line in every use,
+       which shared nodes are; NULL when not shared */
+    unsigned int *on_parent_line;
+
+    AstId root;
+} CompactAst;
+
+/* Flattens the tree under root; the pointer tree is not needed afterwards */
+void compact_ast_build(CompactAst *ast, struct ASTNode *root);
+
+/* As compact_ast_build, but literals, names, variables and operators that
+   repeat an expression already built anywhere in the file are not built
+   again: every use gets the id of the first one, so the result is a DAG.
+   Variables are only shared within a function, so a type found for a
+   node holds at all its uses. A node's offset is its first use's, so
+   diagnostics below a statement go through ast_use_offset. Shared
+   operators and subscripted variables have a slot in types, so the
+   semantic passes type each of them once. */
+void compact_ast_build_shared(CompactAst *ast, struct ASTNode *root, const LineIndex *lines);
+
+void compact_ast_free(CompactAst *ast);
+
+/* Bytes used by the node arrays, pool, lists and tables */
+size_t compact_ast_bytes(const CompactAst *ast);
+
+static inline NodeType ast_kind(const CompactAst *ast, AstId id)
+{
+    return (NodeType)ast->kind[id];
+}
+
+static inline void *ast_record(const CompactAst *ast, AstId id)
+{
+    return ast->pool + ast->word[id];
+}
+
+/* Text of a name field in a record */
+static inline const char *ast_name(const CompactAst *ast, unsigned int name)
+{
+    return ast->names[name];
+}
+
+/* Name held by an id, type, visibility or string literal node */
+static inline const char *ast_node_name(const CompactAst *ast, AstId id)
+{
+    return ast->names[ast->word[id]];
+}
+
+static inline AstId ast_item(const CompactAst *ast, AstList list, unsigned int i)
+{
+    return ast->items[list.first + i];
+}
+
+/* Single child of a read, write, attribute or function declaration */
+static inline AstId ast_child(const CompactAst *ast, AstId id)
+{
+    return ast->word[id];
+}
+
+/* Offset to report a use of child at, given the offset its parent was
+   reported at. A node that may be shared is on its parent's line in every
+   use, and a diagnostic only names the line, so it takes the parent's. */
+static inline unsigned int ast_use_offset(const CompactAst *ast, AstId child, unsigned int parent_offset)
+{
+    if (ast->on_parent_line != NULL && (ast->on_parent_line[child >> 5] >> (child & 31) & 1))
+    {
+        return parent_offset;
+    }
+    return ast->offset[child];
+}
+
+/* Memo of a shared expression, or NULL */
+static inline AstTypeMemo *ast_type_memo(const CompactAst *ast, AstId id)
+{
+    if (ast->types == NULL)
+    {
+        return NULL;
+    }
+    unsigned int mask = (unsigned int)ast->type_capacity - 1;
+    for (unsigned int i = id & mask; ast->types[i].node != 0; i = (i + 1) & mask)
+    {
+        if (ast->types[i].node == id)
+        {
+            return &ast->types[i];
+        }
+    }
+    return NULL;
+}
+
+/* Children of a program or function body */
+static inline AstList ast_list(const CompactAst *ast, AstId id)
+{
+    return *(AstList *)ast_record(ast, id);
+}
+
+#endif
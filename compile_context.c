@@ -0,0 +1,25 @@
+#include <string.h>
+#include "compile_context.h"
+
+void compile_context_init(CompileContext *ctx)
+{
+    memset(ctx, 0, sizeof(CompileContext));
+    ctx->cursor = -1;
+    error_log_init(&ctx->errors);
+    interner_init(&ctx->strings);
+    arena_init(&ctx->ast);
+}
+
+void compile_context_free(CompileContext *ctx)
+{
+    if (ctx->scanner != NULL)
+    {
+        lexer_destroy(ctx);
+    }
+    trace_close(ctx->trace);
+    ctx->trace = NULL;
+    token_buffer_free(&ctx->tokens);
+    error_log_free(&ctx->errors);
+    interner_free(&ctx->strings);
+    arena_free(&ctx->ast);
+}
@@ -0,0 +1,64 @@
+#ifndef COMPILE_CONTEXT_H
+#define COMPILE_CONTEXT_H
+
+#include "tokens.h"
+#include "token_buffer.h"
+#include "token_trace.h"
+#include "line_index.h"
+#include "interner.h"
+#include "arena.h"
+#include "error_logger.h"
+
+struct TokenRing;
+struct SyntaxLog;
+
+/* All state of one compilation. The front end keeps nothing in globals,
+   so independent contexts can be compiled on different threads. */
+typedef struct CompileContext
+{
+    /* Lexer */
+    void *scanner;
+    TraceSink *trace;
+    const LineIndex *lines; /* owned by the caller; may be shared between contexts */
+    int byte_offset;
+    int token_offset;
+    TokenValue token_value;
+    int error_count;
+    int lex_quiet; /* lexical errors are counted but not printed */
+
+    /* Parser */
+    TokenBuffer tokens;
+    struct TokenRing *ring; /* replaces tokens when a lexer thread feeds the parser */
+    int cursor;
+    int lookahead;
+    TokenView current_token;
+    Arena ast; /* every AST node, released in one go with the context */
+    struct SyntaxLog *syntax_log; /* set on parse workers, which hold their errors back */
+    int panic;       /* a syntax error is waiting for the driver to recover from it */
+    int error_quiet; /* tokens to match after recovering before errors are reported again */
+    int errors_seen; /* syntax errors, counting those not reported */
+
+    /* Semantic analysis */
+    ErrorLog errors;
+
+    /* Identifiers, type names and string literals of every phase */
+    Interner strings;
+    SharedInterner *shared_strings; /* set on parse workers; strings then caches it */
+} CompileContext;
+
+void compile_context_init(CompileContext *ctx);
+
+void compile_context_free(CompileContext *ctx);
+
+/* Flex engine entry points, defined in lex_a.l */
+int lexer_init(CompileContext *ctx);
+
+int lexer_scan_memory(CompileContext *ctx, char *data, int size);
+
+int lex_all(CompileContext *ctx, TokenBuffer *tokens);
+
+int lex_to_ring(CompileContext *ctx, struct TokenRing *ring);
+
+void lexer_destroy(CompileContext *ctx);
+
+#endif
@@ -7,40 +7,43 @@
 typedef struct ErrorNode
 {
     char *message;
-    int line_number;
+    unsigned int offset;
     struct ErrorNode *next;
 } ErrorNode;
 
-static ErrorNode *error_list_head = NULL;
-static ErrorNode *error_list_tail = NULL;
-static int semantic_error_count = 0;
+void error_log_init(ErrorLog *log)
+{
+    log->head = NULL;
+    log->tail = NULL;
+    log->count = 0;
+}
 
-void log_semantic_error(const char *message, int line)
+void log_semantic_error(ErrorLog *log, const char *message, unsigned int offset)
 {
-    semantic_error_count++;
+    log->count++;
 
     ErrorNode *new_error = (ErrorNode *)malloc(sizeof(ErrorNode));
     new_error->message = strdup(message);
-    new_error->line_number = line;
+    new_error->offset = offset;
     new_error->next = NULL;
 
-    if (error_list_head == NULL)
+    if (log->head == NULL)
     {
 
-        error_list_head = new_error;
-        error_list_tail = new_error;
+        log->head = new_error;
+        log->tail = new_error;
     }
     else
     {
 
-        error_list_tail->next = new_error;
-        error_list_tail = new_error;
+        log->tail->next = new_error;
+        log->tail = new_error;
     }
 }
 
-int print_errors_to_file(const char *filename)
+int print_errors_to_file(ErrorLog *log, const LineIndex *lines, const char *filename)
 {
-    if (semantic_error_count == 0)
+    if (log->count == 0)
     {
 
         return 0;
@@ -53,18 +56,56 @@ int print_errors_to_file(const char *filename)
         return 1;
     }
 
-    ErrorNode *current = error_list_head;
+    ErrorNode *current = log->head;
     while (current != NULL)
     {
 
         fprintf(file, "Error at line %d: %s\n",
-                current->line_number, current->message);
-
-        ErrorNode *to_free = current;
+                line_index_line(lines, current->offset), current->message);
         current = current->next;
+    }
 
-        free(to_free->message);
-        free(to_free);
+    fclose(file);
+    printf("Semantic errors written to %s\n", filename);
+    return 0;
+}
+
+void error_log_spill(ErrorLog *log, const LineIndex *lines, FILE *file)
+{
+    int count = log->count;
+    for (ErrorNode *current = log->head; current != NULL; current = current->next)
+    {
+        fprintf(file, "Error at line %d: %s\n",
+                line_index_line(lines, current->offset), current->message);
+    }
+    error_log_free(log);
+    log->count = count;
+}
+
+int print_spilled_errors_to_file(FILE *const *spills, int spill_count, int count, const char *filename)
+{
+    if (count == 0)
+    {
+
+        return 0;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error: Could not open error file %s\n", filename);
+        return 1;
+    }
+
+    char buffer[8192];
+    for (int i = 0; i < spill_count; i++)
+    {
+        rewind(spills[i]);
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), spills[i])) > 0)
+        {
+            fwrite(buffer, 1, n, file);
+        }
     }
 
     fclose(file);
@@ -72,7 +113,21 @@ int print_errors_to_file(const char *filename)
     return 0;
 }
 
-int get_semantic_error_count()
+int get_semantic_error_count(ErrorLog *log)
+{
+    return log->count;
+}
+
+void error_log_free(ErrorLog *log)
 {
-    return semantic_error_count;
-}
\ No newline at end of file
+    ErrorNode *current = log->head;
+    while (current != NULL)
+    {
+        ErrorNode *to_free = current;
+        current = current->next;
+
+        free(to_free->message);
+        free(to_free);
+    }
+    error_log_init(log);
+}
@@ -1,13 +1,36 @@
-
 #ifndef ERROR_LOGGER_H
 #define ERROR_LOGGER_H
 
 #include <stdio.h>
+#include "line_index.h"
+
+struct ErrorNode;
+
+/* Semantic errors of one compilation, in the order they were reported */
+typedef struct ErrorLog
+{
+    struct ErrorNode *head;
+    struct ErrorNode *tail;
+    int count;
+} ErrorLog;
+
+void error_log_init(ErrorLog *log);
+
+/* offset is where the offending construct starts in the source */
+void log_semantic_error(ErrorLog *log, const char *message, unsigned int offset);
+
+/* Lines are looked up in lines only now, when the errors are written */
+int print_errors_to_file(ErrorLog *log, const LineIndex *lines, const char *filename);
+
+/* Writes the errors logged so far to file, as print_errors_to_file would,
+   and frees them; the count keeps including them */
+void error_log_spill(ErrorLog *log, const LineIndex *lines, FILE *file);
 
-void log_semantic_error(const char *message, int line);
+/* Writes the spill files, in order, to filename; nothing when count is 0 */
+int print_spilled_errors_to_file(FILE *const *spills, int spill_count, int count, const char *filename);
 
-int print_errors_to_file(const char *filename);
+int get_semantic_error_count(ErrorLog *log);
 
-int get_semantic_error_count();
+void error_log_free(ErrorLog *log);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,915 @@
+#include "fast_lexer.h"
+#include "keywords.h"
+#include "numeric.h"
+#include "vec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* ---- character-class scanning ----
+   Each helper returns the first position at or after p whose byte is
+   outside (or, for the find_* helpers, inside) the class. The source
+   padding guarantees a full vector can always be loaded at p < end, and
+   the zero padding bytes belong to none of the classes. */
+
+#ifdef VEC_WIDTH
+/* Lanes where lo <= x <= hi, using an unsigned saturating compare */
+static inline vec_t vec_in_range(vec_t x, char lo, char hi)
+{
+    vec_t shifted = vec_sub(x, vec_set1(lo));
+    return vec_eq(vec_min(shifted, vec_set1(hi - lo)), shifted);
+}
+
+static inline vec_t vec_is_space(vec_t x)
+{
+    return vec_or(vec_or(vec_eq(x, vec_set1(' ')), vec_eq(x, vec_set1('\t'))), vec_eq(x, vec_set1('\n')));
+}
+
+static inline vec_t vec_is_digit(vec_t x)
+{
+    return vec_in_range(x, '0', '9');
+}
+
+static inline vec_t vec_is_alnum(vec_t x)
+{
+    vec_t lower = vec_or(x, vec_set1(0x20));
+    return vec_or(vec_or(vec_in_range(lower, 'a', 'z'), vec_is_digit(x)), vec_eq(x, vec_set1('_')));
+}
+
+#define DEFINE_SKIP(name, class_fn)                                  \
+    static inline int name(const char *text, int p, int end)         \
+    {                                                                \
+        while (p < end)                                              \
+        {                                                            \
+            unsigned int out = ~vec_mask(class_fn(vec_load(text + p))) & VEC_ALL_MASK; \
+            if (out != 0)                                            \
+            {                                                        \
+                p += __builtin_ctz(out);                             \
+                return p < end ? p : end;                            \
+            }                                                        \
+            p += VEC_WIDTH;                                          \
+        }                                                            \
+        return end;                                                  \
+    }
+
+DEFINE_SKIP(skip_spaces, vec_is_space)
+DEFINE_SKIP(skip_digits, vec_is_digit)
+DEFINE_SKIP(skip_alnum, vec_is_alnum)
+
+static inline int find_byte(const char *text, int p, int end, char c)
+{
+    vec_t needle = vec_set1(c);
+    while (p < end)
+    {
+        unsigned int hit = vec_mask(vec_eq(vec_load(text + p), needle));
+        if (hit != 0)
+        {
+            p += __builtin_ctz(hit);
+            return p < end ? p : end;
+        }
+        p += VEC_WIDTH;
+    }
+    return end;
+}
+
+static inline int find_either(const char *text, int p, int end, char a, char b)
+{
+    vec_t va = vec_set1(a);
+    vec_t vb = vec_set1(b);
+    while (p < end)
+    {
+        vec_t x = vec_load(text + p);
+        unsigned int hit = vec_mask(vec_or(vec_eq(x, va), vec_eq(x, vb)));
+        if (hit != 0)
+        {
+            p += __builtin_ctz(hit);
+            return p < end ? p : end;
+        }
+        p += VEC_WIDTH;
+    }
+    return end;
+}
+
+#else
+static inline int skip_spaces(const char *text, int p, int end)
+{
+    while (p < end && (text[p] == ' ' || text[p] == '\t' || text[p] == '\n'))
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline int skip_digits(const char *text, int p, int end)
+{
+    while (p < end && text[p] >= '0' && text[p] <= '9')
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline int skip_alnum(const char *text, int p, int end)
+{
+    while (p < end && (((text[p] | 0x20) >= 'a' && (text[p] | 0x20) <= 'z') ||
+                       (text[p] >= '0' && text[p] <= '9') || text[p] == '_'))
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline int find_byte(const char *text, int p, int end, char c)
+{
+    const char *hit = (const char *)memchr(text + p, c, end - p);
+    return hit ? (int)(hit - text) : end;
+}
+
+static inline int find_either(const char *text, int p, int end, char a, char b)
+{
+    while (p < end && text[p] != a && text[p] != b)
+    {
+        p++;
+    }
+    return p;
+}
+#endif
+
+static inline int is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline int is_letter(char c)
+{
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+static inline int is_letter_or_underscore(char c)
+{
+    return is_letter(c) || c == '_';
+}
+
+/* ---- numeric rules ----
+   Every rule that can start with a digit is measured separately and the
+   longest match wins, ties going to the rule listed first in lex_a.l,
+   exactly like flex. */
+
+enum
+{
+    NUM_FLOAT,
+    NUM_INTEGER,
+    NUM_BAD_FLOAT_FORMAT,
+    NUM_BAD_IDENTIFIER,
+    NUM_MISSING_FRACTION,
+    NUM_INCOMPLETE_EXPONENT,
+    NUM_RULE_COUNT
+};
+
+static const char *num_rule_messages[NUM_RULE_COUNT] = {
+    NULL,
+    NULL,
+    "Invalid float literal format",
+    "Invalid identifier (cannot start with digit)",
+    "Invalid float literal (missing fractional part)",
+    "Invalid float literal (incomplete exponent)"};
+
+/* {integer}: 0 | [1-9][0-9]* */
+static inline int match_integer(const char *text, int p, int end)
+{
+    if (p >= end || !is_digit(text[p]))
+    {
+        return 0;
+    }
+    if (text[p] == '0')
+    {
+        return 1;
+    }
+    return skip_digits(text, p, end) - p;
+}
+
+/* {integer}{fraction}({exponent})? with fraction \.([0-9]*[1-9]|0) */
+static int match_float(const char *text, int p, int end)
+{
+    int int_end = p + match_integer(text, p, end);
+    if (int_end >= end || text[int_end] != '.')
+    {
+        return 0;
+    }
+
+    int frac_start = int_end + 1;
+    int frac_end = skip_digits(text, frac_start, end);
+
+    int last_nonzero = frac_end - 1;
+    while (last_nonzero >= frac_start && text[last_nonzero] == '0')
+    {
+        last_nonzero--;
+    }
+
+    int best = 0;
+    if (last_nonzero >= frac_start)
+    {
+        best = last_nonzero + 1 - p;
+    }
+    else if (frac_start < frac_end)
+    {
+        best = frac_start + 1 - p;
+    }
+
+    /* An exponent can only follow a fraction that uses the whole digit run */
+    int whole_run = (frac_end > frac_start && last_nonzero == frac_end - 1) ||
+                    (frac_end == frac_start + 1 && text[frac_start] == '0');
+    if (whole_run && frac_end < end && (text[frac_end] == 'e' || text[frac_end] == 'E'))
+    {
+        int q = frac_end + 1;
+        if (q < end && (text[q] == '+' || text[q] == '-'))
+        {
+            q++;
+        }
+        int exp_len = match_integer(text, q, end);
+        if (exp_len > 0)
+        {
+            best = q + exp_len - p;
+        }
+    }
+    return best;
+}
+
+/* [0-9]+\.[0-9]*[eE][+-]?[0-9]*[a-zA-Z_] */
+static int match_bad_float_format(const char *text, int p, int end, int digits_end)
+{
+    if (digits_end >= end || text[digits_end] != '.')
+    {
+        return 0;
+    }
+    int q = skip_digits(text, digits_end + 1, end);
+    if (q >= end || (text[q] != 'e' && text[q] != 'E'))
+    {
+        return 0;
+    }
+    q++;
+    if (q < end && (text[q] == '+' || text[q] == '-'))
+    {
+        q++;
+    }
+    q = skip_digits(text, q, end);
+    if (q >= end || !is_letter_or_underscore(text[q]))
+    {
+        return 0;
+    }
+    return q + 1 - p;
+}
+
+static int scan_number(const char *text, int p, int end, int *rule)
+{
+    int digits_end = skip_digits(text, p, end);
+    int lengths[NUM_RULE_COUNT];
+
+    lengths[NUM_FLOAT] = match_float(text, p, end);
+    lengths[NUM_INTEGER] = match_integer(text, p, end);
+    lengths[NUM_BAD_FLOAT_FORMAT] = match_bad_float_format(text, p, end, digits_end);
+
+    lengths[NUM_BAD_IDENTIFIER] = 0;
+    if (digits_end < end && is_letter_or_underscore(text[digits_end]))
+    {
+        lengths[NUM_BAD_IDENTIFIER] = skip_alnum(text, digits_end + 1, end) - p;
+    }
+
+    lengths[NUM_MISSING_FRACTION] = 0;
+    if (digits_end < end && text[digits_end] == '.')
+    {
+        lengths[NUM_MISSING_FRACTION] = digits_end + 1 - p;
+    }
+
+    lengths[NUM_INCOMPLETE_EXPONENT] = 0;
+    if (digits_end < end && (text[digits_end] == 'e' || text[digits_end] == 'E'))
+    {
+        int q = digits_end + 1;
+        if (q < end && (text[q] == '+' || text[q] == '-'))
+        {
+            q++;
+        }
+        lengths[NUM_INCOMPLETE_EXPONENT] = q - p;
+    }
+
+    int best = NUM_FLOAT;
+    for (int r = 1; r < NUM_RULE_COUNT; r++)
+    {
+        if (lengths[r] > lengths[best])
+        {
+            best = r;
+        }
+    }
+    *rule = best;
+    return lengths[best];
+}
+
+/* ---- reporting ---- */
+
+static void lexeme_to_cstr(char *buffer, int size, const char *text, int length)
+{
+    if (length > size - 1)
+    {
+        length = size - 1;
+    }
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+}
+
+static void fast_trace(CompileContext *ctx, int type, const char *text, int start, int length)
+{
+    char lexeme[512];
+    lexeme_to_cstr(lexeme, sizeof(lexeme), text + start, length);
+    trace_token(ctx->trace, ctx->lines, type, lexeme, start, length);
+}
+
+static void fast_error(CompileContext *ctx, const char *text, int start, int length, const char *message)
+{
+    char lexeme[512];
+    lexeme_to_cstr(lexeme, sizeof(lexeme), text + start, length);
+    if (!ctx->lex_quiet)
+    {
+        trace_error(ctx->trace, ctx->lines, lexeme, start, length, message);
+    }
+    ctx->error_count++;
+}
+
+/* Operators of one or two characters; returns the token and sets *length */
+static int scan_operator(const char *text, int p, int end, int *length)
+{
+    char next = p + 1 < end ? text[p + 1] : '\0';
+    *length = 1;
+
+    switch (text[p])
+    {
+    case ':':
+        if (next == '=')
+        {
+            *length = 2;
+            return ASSIGN_OP;
+        }
+        return COLON;
+    case '=':
+        if (next == '=')
+        {
+            *length = 2;
+            return EQ_OP;
+        }
+        if (next == '>')
+        {
+            *length = 2;
+            return ARROW;
+        }
+        return ASSIGN_OP;
+    case '<':
+        if (next == '>')
+        {
+            *length = 2;
+            return NE_OP;
+        }
+        if (next == '=')
+        {
+            *length = 2;
+            return LE_OP;
+        }
+        return LT_OP;
+    case '>':
+        if (next == '=')
+        {
+            *length = 2;
+            return GE_OP;
+        }
+        return GT_OP;
+    case '+':
+        return PLUS_OP;
+    case '-':
+        return MINUS_OP;
+    case '*':
+        return MULT_OP;
+    case '/':
+        return DIV_OP;
+    case '(':
+        return LPAREN;
+    case ')':
+        return RPAREN;
+    case '{':
+        return LBRACE;
+    case '}':
+        return RBRACE;
+    case '[':
+        return LBRACKET;
+    case ']':
+        return RBRACKET;
+    case ';':
+        return SEMICOLON;
+    case ',':
+        return COMMA;
+    }
+    return 0;
+}
+
+/* ---- driver ---- */
+
+/* An error found by a speculative run, reported once the run is chosen */
+typedef struct LexError
+{
+    int start;
+    int length;
+    const char *message;
+} LexError;
+
+/* Lexing of one byte range. With ctx set, errors and trace output go
+   straight to the compilation; without it, errors are kept in errors[]. */
+typedef struct LexRun
+{
+    CompileContext *ctx;
+    TokenBuffer *tokens;
+    LexError *errors;
+    int error_count;
+    int error_capacity;
+    int ends_in_comment;
+    int comment_start; /* -1 when the open comment began before the range */
+    const TokenBuffer *follow; /* another lexing of the same text to converge with */
+    int follow_index;
+    int follow_shift; /* where follow's offsets lie in this run's text */
+    int sync_from;    /* no convergence before this offset */
+    int synced_at;    /* token of follow this run continues with, or -1 */
+} LexRun;
+
+static void lex_run_init(LexRun *run, CompileContext *ctx, TokenBuffer *tokens)
+{
+    run->ctx = ctx;
+    run->tokens = tokens;
+    run->errors = NULL;
+    run->error_count = 0;
+    run->error_capacity = 0;
+    run->ends_in_comment = 0;
+    run->comment_start = -1;
+    run->follow = NULL;
+    run->follow_index = 0;
+    run->follow_shift = 0;
+    run->sync_from = 0;
+    run->synced_at = -1;
+}
+
+static void report_error(LexRun *run, const char *text, int start, int length, const char *message)
+{
+    if (run->ctx != NULL)
+    {
+        fast_error(run->ctx, text, start, length, message);
+        return;
+    }
+
+    if (run->error_count == run->error_capacity)
+    {
+        run->error_capacity = run->error_capacity ? run->error_capacity * 2 : 16;
+        run->errors = (LexError *)realloc(run->errors, run->error_capacity * sizeof(LexError));
+    }
+    LexError *e = &run->errors[run->error_count++];
+    e->start = start;
+    e->length = length;
+    e->message = message;
+}
+
+/* Position just past the closing star-slash, or -1 if the comment stays open */
+static int find_comment_end(const char *text, int p, int end)
+{
+    while ((p = find_byte(text, p, end, '*')) < end)
+    {
+        if (p + 1 < end && text[p + 1] == '/')
+        {
+            return p + 2;
+        }
+        p++;
+    }
+    return -1;
+}
+
+/* Once a run starts a token where its follow run also started one, both
+   are in the same state at the same place and the rest of the range would
+   lex identically, so the run can stop and share the follow run's tail. */
+static int converges(LexRun *run, int start)
+{
+    if (start < run->sync_from)
+    {
+        return 0;
+    }
+    const TokenBuffer *other = run->follow;
+    int target = start - run->follow_shift;
+    int k = run->follow_index;
+    while (k < other->count && (int)other->start[k] < target)
+    {
+        k++;
+    }
+    run->follow_index = k;
+    if (k < other->count && (int)other->start[k] == target)
+    {
+        run->synced_at = k;
+        return 1;
+    }
+    return 0;
+}
+
+/* Lexes [begin, end), which must start where the flex rules would start a
+   match: a line start or a token start. When in_comment is set the range
+   starts inside a block comment opened earlier. */
+static void lex_range(LexRun *run, const char *text, int begin, int end, int in_comment)
+{
+    CompileContext *ctx = run->ctx;
+    TokenBuffer *tokens = run->tokens;
+    int p = begin;
+
+    if (in_comment)
+    {
+        int comment_end = find_comment_end(text, p, end);
+        if (comment_end < 0)
+        {
+            comment_end = end;
+            run->ends_in_comment = 1;
+        }
+        p = comment_end;
+    }
+
+    while (p < end)
+    {
+        char c = text[p];
+        int start = p;
+        int kind;
+        int length;
+        TokenValue value;
+        const char *message = NULL;
+        value.int_value = 0;
+
+        if (c == ' ' || c == '\t' || c == '\n')
+        {
+            p = skip_spaces(text, p + 1, end);
+            continue;
+        }
+
+        if (c == '/' && p + 1 < end && text[p + 1] == '/')
+        {
+            p = find_byte(text, p + 2, end, '\n');
+            if (ctx != NULL && ctx->trace != NULL)
+            {
+                fast_trace(ctx, COMMENT, text, start, p - start);
+            }
+            continue;
+        }
+
+        if (c == '/' && p + 1 < end && text[p + 1] == '*')
+        {
+            int comment_end = find_comment_end(text, p + 2, end);
+            if (comment_end < 0)
+            {
+                /* Still open at the end of the range; the caller decides */
+                run->ends_in_comment = 1;
+                run->comment_start = start;
+                p = end;
+                break;
+            }
+            p = comment_end;
+            if (ctx != NULL && ctx->trace != NULL)
+            {
+                trace_token(ctx->trace, ctx->lines, COMMENT, "/* ... */", start, p - start);
+            }
+            continue;
+        }
+
+        if (run->follow != NULL && converges(run, start))
+        {
+            break;
+        }
+
+        if (is_letter(c))
+        {
+            p = skip_alnum(text, p + 1, end);
+            kind = keyword_lookup(text + start, p - start);
+        }
+        else if (is_digit(c))
+        {
+            int rule;
+            p += scan_number(text, p, end, &rule);
+            if (rule == NUM_FLOAT)
+            {
+                kind = FLOAT_LIT;
+                if (parse_float_literal(text + start, p - start, &value.float_value) != 0)
+                {
+                    kind = INVALID_TOKEN;
+                    message = "Float literal out of range";
+                }
+            }
+            else if (rule == NUM_INTEGER)
+            {
+                kind = INTEGER_LIT;
+                if (parse_int_literal(text + start, p - start, &value.int_value) != 0)
+                {
+                    kind = INVALID_TOKEN;
+                    message = "Integer literal out of range";
+                }
+            }
+            else
+            {
+                kind = INVALID_TOKEN;
+                message = num_rule_messages[rule];
+            }
+        }
+        else if (c == '.')
+        {
+            /* "." ties with \.[0-9]* at length one and wins by rule order */
+            p = skip_digits(text, p + 1, end);
+            if (p == start + 1)
+            {
+                kind = DOT;
+            }
+            else
+            {
+                kind = INVALID_TOKEN;
+                message = "Invalid float literal (missing integer part)";
+            }
+        }
+        else if (c == '"')
+        {
+            int q = find_either(text, p + 1, end, '"', '\n');
+            if (q < end && text[q] == '"')
+            {
+                kind = STRING_LIT;
+                p = q + 1;
+            }
+            else
+            {
+                kind = INVALID_TOKEN;
+                message = "Unrecognized character";
+                p++;
+            }
+        }
+        else if ((kind = scan_operator(text, p, end, &length)) != 0)
+        {
+            p += length;
+        }
+        else
+        {
+            kind = INVALID_TOKEN;
+            message = (c != '\0' && strchr("@#$%^&`~|\\", c) != NULL) ? "Invalid character" : "Unrecognized character";
+            p++;
+        }
+
+        if (message != NULL)
+        {
+            report_error(run, text, start, p - start, message);
+        }
+        else if (ctx != NULL && ctx->trace != NULL)
+        {
+            fast_trace(ctx, kind, text, start, p - start);
+        }
+
+        token_buffer_push(tokens, kind, start, p - start, value);
+    }
+}
+
+static void report_unterminated_comment(CompileContext *ctx, int start, int size)
+{
+    if (!ctx->lex_quiet)
+    {
+        trace_error(ctx->trace, ctx->lines, "/*", start, size - start, "Unterminated block comment");
+    }
+    ctx->error_count++;
+}
+
+int fast_lex_all(CompileContext *ctx, TokenBuffer *tokens, const char *text, int size)
+{
+    LexRun run;
+    lex_run_init(&run, ctx, tokens);
+    lex_range(&run, text, 0, size, 0);
+    if (run.ends_in_comment)
+    {
+        report_unterminated_comment(ctx, run.comment_start, size);
+    }
+
+    token_buffer_push(tokens, 0, size, 0, (TokenValue){0});
+    return tokens->count - 1;
+}
+
+/* ---- incremental driver ----
+   No token can contain a newline, so a token's extent depends only on the
+   text up to the end of its line. Relexing restarts at the last old token
+   that starts before the edited line, which is known to lie outside any
+   block comment, and stops at the first token past the edit that starts
+   where an old token started. */
+
+/* Index of the first token of buf starting at or after offset */
+static int first_token_at(const TokenBuffer *buf, int offset)
+{
+    int lo = 0;
+    int hi = buf->count - 1; /* never the end-of-input token */
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if ((int)buf->start[mid] < offset)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int fast_relex(CompileContext *ctx, const TokenBuffer *old, const TokenEdit *edit, const char *text, int size,
+               TokenBuffer *tokens, TokenRange *changed)
+{
+    int shift = edit->inserted - edit->removed;
+    int line_start = edit->offset;
+    while (line_start > 0 && text[line_start - 1] != '\n')
+    {
+        line_start--;
+    }
+
+    int keep = first_token_at(old, line_start) - 1;
+    int begin = 0;
+    if (keep < 0)
+    {
+        keep = 0;
+    }
+    else
+    {
+        begin = (int)old->start[keep];
+    }
+    token_buffer_append(tokens, old, 0, keep, 0);
+
+    LexRun run;
+    lex_run_init(&run, ctx, tokens);
+    run.follow = old;
+    run.follow_index = keep;
+    run.follow_shift = shift;
+    run.sync_from = edit->offset + edit->inserted;
+    lex_range(&run, text, begin, size, 0);
+
+    changed->first = keep;
+    changed->new_end = tokens->count;
+    if (run.synced_at >= 0)
+    {
+        changed->old_end = run.synced_at;
+        token_buffer_append(tokens, old, run.synced_at, old->count, shift);
+    }
+    else
+    {
+        if (run.ends_in_comment)
+        {
+            report_unterminated_comment(ctx, run.comment_start, size);
+        }
+        changed->old_end = old->count - 1;
+        token_buffer_push(tokens, 0, size, 0, (TokenValue){0});
+    }
+    return tokens->count - 1;
+}
+
+/* ---- parallel driver ----
+   The file is cut after newlines, so the only lexer state that can cross
+   a cut is an open block comment. Every chunk is lexed from both possible
+   start states at once; a sequential pass then follows the real state
+   from the first chunk onwards and stitches the matching runs together. */
+
+#define PARALLEL_MIN_CHUNK (64 * 1024)
+
+typedef struct LexChunk
+{
+    const char *text;
+    int begin;
+    int end;
+    TokenBuffer tokens[2];
+    LexRun runs[2]; /* [0] starts outside a comment, [1] inside one */
+} LexChunk;
+
+/* Adds a chunk run's tokens from index from and its errors from offset
+   from_offset to the final stream */
+static void append_run(CompileContext *ctx, TokenBuffer *tokens, const char *text, const LexRun *run, int from,
+                       int from_offset)
+{
+    token_buffer_append(tokens, run->tokens, from, run->tokens->count, 0);
+    for (int i = 0; i < run->error_count; i++)
+    {
+        const LexError *e = &run->errors[i];
+        if (e->start >= from_offset)
+        {
+            fast_error(ctx, text, e->start, e->length, e->message);
+        }
+    }
+}
+
+static void *lex_chunk_worker(void *arg)
+{
+    LexChunk *chunk = (LexChunk *)arg;
+    int states = chunk->begin == 0 ? 1 : 2;
+
+    for (int state = 0; state < states; state++)
+    {
+        int hint = state == 0 ? (chunk->end - chunk->begin) / 4 : 16;
+        token_buffer_init(&chunk->tokens[state], chunk->text, hint);
+        lex_run_init(&chunk->runs[state], NULL, &chunk->tokens[state]);
+        if (state == 1)
+        {
+            chunk->runs[1].follow = &chunk->tokens[0];
+        }
+        lex_range(&chunk->runs[state], chunk->text, chunk->begin, chunk->end, state);
+    }
+    return NULL;
+}
+
+int fast_lex_parallel(CompileContext *ctx, TokenBuffer *tokens, const char *text, int size, int jobs)
+{
+    if (jobs > size / PARALLEL_MIN_CHUNK)
+    {
+        jobs = size / PARALLEL_MIN_CHUNK;
+    }
+    if (jobs < 2 || ctx->trace != NULL)
+    {
+        return fast_lex_all(ctx, tokens, text, size);
+    }
+
+    LexChunk *chunks = (LexChunk *)calloc(jobs, sizeof(LexChunk));
+    int chunk_count = 0;
+    int begin = 0;
+    for (int k = 1; k <= jobs && begin < size; k++)
+    {
+        int end = size;
+        if (k < jobs)
+        {
+            /* A line longer than a chunk pushes the boundary past the
+               target; the chunk still ends at a newline */
+            int target = (int)((long long)size * k / jobs);
+            end = find_byte(text, target > begin ? target : begin, size, '\n');
+            end = end < size ? end + 1 : size;
+        }
+        if (end <= begin)
+        {
+            continue;
+        }
+        chunks[chunk_count].text = text;
+        chunks[chunk_count].begin = begin;
+        chunks[chunk_count].end = end;
+        chunk_count++;
+        begin = end;
+    }
+
+    pthread_t *workers = (pthread_t *)malloc(chunk_count * sizeof(pthread_t));
+    int *started = (int *)calloc(chunk_count, sizeof(int));
+    for (int k = 1; k < chunk_count; k++)
+    {
+        started[k] = pthread_create(&workers[k], NULL, lex_chunk_worker, &chunks[k]) == 0;
+    }
+    lex_chunk_worker(&chunks[0]);
+    for (int k = 1; k < chunk_count; k++)
+    {
+        if (started[k])
+        {
+            pthread_join(workers[k], NULL);
+        }
+        else
+        {
+            lex_chunk_worker(&chunks[k]);
+        }
+    }
+
+    int in_comment = 0;
+    int comment_start = 0;
+    for (int k = 0; k < chunk_count; k++)
+    {
+        LexRun *run = &chunks[k].runs[in_comment];
+        append_run(ctx, tokens, text, run, 0, 0);
+        if (run->synced_at >= 0)
+        {
+            /* The speculative run converged; the outside run supplies the rest */
+            LexRun *rest = &chunks[k].runs[0];
+            append_run(ctx, tokens, text, rest, run->synced_at, rest->tokens->start[run->synced_at]);
+            run = rest;
+        }
+        if (run->ends_in_comment && run->comment_start >= 0)
+        {
+            comment_start = run->comment_start;
+        }
+        in_comment = run->ends_in_comment;
+    }
+    if (in_comment)
+    {
+        report_unterminated_comment(ctx, comment_start, size);
+    }
+    token_buffer_push(tokens, 0, size, 0, (TokenValue){0});
+
+    for (int k = 0; k < chunk_count; k++)
+    {
+        for (int state = 0; state < 2; state++)
+        {
+            if (chunks[k].runs[state].tokens != NULL)
+            {
+                token_buffer_free(&chunks[k].tokens[state]);
+                free(chunks[k].runs[state].errors);
+            }
+        }
+    }
+    free(started);
+    free(workers);
+    free(chunks);
+    return tokens->count - 1;
+}
@@ -0,0 +1,42 @@
+#ifndef FAST_LEXER_H
+#define FAST_LEXER_H
+
+#include "compile_context.h"
+
+/* Hand-written scanner that produces the same tokens and lexical errors
+   as the flex rules in lex_a.l. text must be followed by at least
+   SOURCE_PADDING readable bytes, since runs are scanned a vector at a time.
+   Errors and trace output go to ctx and are located through ctx->lines. */
+int fast_lex_all(CompileContext *ctx, TokenBuffer *tokens, const char *text, int size);
+
+/* Same tokens and errors as fast_lex_all, lexing up to jobs line-aligned
+   chunks on their own threads. Small inputs and traced runs fall back to
+   the sequential scanner. */
+int fast_lex_parallel(CompileContext *ctx, TokenBuffer *tokens, const char *text, int size, int jobs);
+
+/* One contiguous change: removed bytes at offset were replaced by inserted bytes */
+typedef struct TokenEdit
+{
+    int offset;
+    int removed;
+    int inserted;
+} TokenEdit;
+
+/* Tokens [first, old_end) of the old stream became [first, new_end) of the
+   new one; the tokens after them are the old ones, moved by the edit. */
+typedef struct TokenRange
+{
+    int first;
+    int old_end;
+    int new_end;
+} TokenRange;
+
+/* Re-lexes text, which is old->text with edit applied and padded like any
+   other source, into tokens (initialised on text by the caller). Only the
+   stretch between the last safe restart point before the edit and the
+   point where the new tokens line up with the old ones again is scanned;
+   only errors found there are reported. */
+int fast_relex(CompileContext *ctx, const TokenBuffer *old, const TokenEdit *edit, const char *text, int size,
+               TokenBuffer *tokens, TokenRange *changed);
+
+#endif
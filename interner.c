@@ -0,0 +1,147 @@
+#include "interner.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_INITIAL_CAPACITY 256
+
+const char NAME_INTEGER[] = "integer";
+const char NAME_FLOAT[] = "float";
+const char NAME_STRING[] = "string";
+const char NAME_VOID[] = "void";
+const char NAME_BOOLEAN[] = "boolean";
+const char NAME_ERROR_TYPE[] = "error_type";
+const char NAME_CONSTRUCTOR[] = "constructor";
+const char NAME_GLOBAL[] = "global";
+const char NAME_STAT_BLOCK[] = "stat_block";
+
+static const char *const predefined_names[] = {
+    NAME_INTEGER, NAME_FLOAT, NAME_STRING, NAME_VOID, NAME_BOOLEAN,
+    NAME_ERROR_TYPE, NAME_CONSTRUCTOR, NAME_GLOBAL, NAME_STAT_BLOCK};
+
+typedef struct InternSlot
+{
+    const char *text; /* NULL for an empty slot */
+    unsigned int hash;
+    int length;
+} InternSlot;
+
+/* FNV-1a */
+static unsigned int intern_hash(const char *text, int length)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void intern_insert(Interner *in, const char *text, unsigned int hash, int length)
+{
+    unsigned int mask = (unsigned int)in->capacity - 1;
+    unsigned int i = hash & mask;
+    while (in->slots[i].text != NULL)
+    {
+        i = (i + 1) & mask;
+    }
+    in->slots[i].text = text;
+    in->slots[i].hash = hash;
+    in->slots[i].length = length;
+    in->count++;
+}
+
+static void intern_grow(Interner *in)
+{
+    InternSlot *old = in->slots;
+    int old_capacity = in->capacity;
+
+    in->capacity = old_capacity * 2;
+    in->slots = (InternSlot *)calloc(in->capacity, sizeof(InternSlot));
+    in->count = 0;
+    for (int i = 0; i < old_capacity; i++)
+    {
+        if (old[i].text != NULL)
+        {
+            intern_insert(in, old[i].text, old[i].hash, old[i].length);
+        }
+    }
+    free(old);
+}
+
+void interner_init(Interner *in)
+{
+    arena_init(&in->text);
+    in->capacity = INTERN_INITIAL_CAPACITY;
+    in->slots = (InternSlot *)calloc(in->capacity, sizeof(InternSlot));
+    in->count = 0;
+
+    for (size_t i = 0; i < sizeof(predefined_names) / sizeof(predefined_names[0]); i++)
+    {
+        int length = (int)strlen(predefined_names[i]);
+        intern_insert(in, predefined_names[i], intern_hash(predefined_names[i], length), length);
+    }
+}
+
+static const char *intern_find(const Interner *in, const char *text, unsigned int hash, int length)
+{
+    unsigned int mask = (unsigned int)in->capacity - 1;
+    for (unsigned int i = hash & mask; in->slots[i].text != NULL; i = (i + 1) & mask)
+    {
+        const InternSlot *slot = &in->slots[i];
+        if (slot->hash == hash && slot->length == length && memcmp(slot->text, text, length) == 0)
+        {
+            return slot->text;
+        }
+    }
+    return NULL;
+}
+
+const char *intern(Interner *in, const char *text, int length)
+{
+    unsigned int hash = intern_hash(text, length);
+    const char *found = intern_find(in, text, hash, length);
+    if (found != NULL)
+    {
+        return found;
+    }
+
+    if (2 * (in->count + 1) > in->capacity)
+    {
+        intern_grow(in);
+    }
+    const char *copy = arena_strndup(&in->text, text, length);
+    intern_insert(in, copy, hash, length);
+    return copy;
+}
+
+const char *intern_cached(Interner *cache, SharedInterner *shared, const char *text, int length)
+{
+    unsigned int hash = intern_hash(text, length);
+    const char *found = intern_find(cache, text, hash, length);
+    if (found != NULL)
+    {
+        return found;
+    }
+
+    pthread_mutex_lock(&shared->lock);
+    found = intern(shared->strings, text, length);
+    pthread_mutex_unlock(&shared->lock);
+
+    /* The cache keeps the shared pointer rather than a copy */
+    if (2 * (cache->count + 1) > cache->capacity)
+    {
+        intern_grow(cache);
+    }
+    intern_insert(cache, found, hash, length);
+    return found;
+}
+
+void interner_free(Interner *in)
+{
+    arena_free(&in->text);
+    free(in->slots);
+    in->slots = NULL;
+    in->capacity = 0;
+    in->count = 0;
+}
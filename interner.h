@@ -0,0 +1,50 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <pthread.h>
+#include "arena.h"
+
+/* Strings every interner starts with. Interning the same text returns
+   these very arrays, so the front end compares against them with ==. */
+extern const char NAME_INTEGER[];
+extern const char NAME_FLOAT[];
+extern const char NAME_STRING[];
+extern const char NAME_VOID[];
+extern const char NAME_BOOLEAN[];
+extern const char NAME_ERROR_TYPE[];
+extern const char NAME_CONSTRUCTOR[];
+extern const char NAME_GLOBAL[];
+extern const char NAME_STAT_BLOCK[];
+
+struct InternSlot;
+
+/* Per-compilation string table. Equal texts intern to the same
+   NUL-terminated pointer, which stays valid until interner_free, so
+   interned names are compared with == and never freed one by one. */
+typedef struct Interner
+{
+    Arena text;               /* the string bytes */
+    struct InternSlot *slots; /* open addressing, power-of-two size */
+    int capacity;
+    int count;
+} Interner;
+
+void interner_init(Interner *in);
+
+const char *intern(Interner *in, const char *text, int length);
+
+void interner_free(Interner *in);
+
+/* An interner several threads add to, one at a time */
+typedef struct SharedInterner
+{
+    Interner *strings;
+    pthread_mutex_t lock;
+} SharedInterner;
+
+/* Interns text in shared. cache is an interner of the calling thread that
+   remembers the shared pointers it has been given, so the lock is only
+   taken for texts the thread has not seen yet. */
+const char *intern_cached(Interner *cache, SharedInterner *shared, const char *text, int length);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <string.h>
+#include "tokens.h"
+
+/* Perfect hash over the reserved words (including the word operators
+   "or", "and" and "not"). The constants were chosen offline so that
+   every keyword lands in its own slot of a 64-entry table; a lookup is
+   one hash, one length check and one memcmp. */
+
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 11
+#define KEYWORD_TABLE_SIZE 64
+
+#define KEYWORD_HASH(s, len) \
+    ((3u * (unsigned char)(s)[0] + 7u * (unsigned char)(s)[1] + (unsigned)(len)) & (KEYWORD_TABLE_SIZE - 1))
+
+struct KeywordSlot
+{
+    const char *name;
+    int length;
+    int token;
+};
+
+static const struct KeywordSlot keyword_table[KEYWORD_TABLE_SIZE] = {
+    [2] = {"while", 5, WHILE_KW},
+    [4] = {"integer", 7, INTEGER_KW},
+    [7] = {"if", 2, IF_KW},
+    [8] = {"write", 5, WRITE_KW},
+    [9] = {"public", 6, PUBLIC_KW},
+    [11] = {"string", 6, STRING_KW},
+    [18] = {"local", 5, LOCAL_KW},
+    [22] = {"not", 3, NOT_OP},
+    [24] = {"attribute", 9, ATTRIBUTE_KW},
+    [29] = {"read", 4, READ_KW},
+    [31] = {"return", 6, RETURN_KW},
+    [32] = {"self", 4, SELF_KW},
+    [34] = {"class", 5, CLASS_KW},
+    [35] = {"isa", 3, ISA_KW},
+    [39] = {"else", 4, ELSE_KW},
+    [40] = {"and", 3, AND_OP},
+    [41] = {"func", 4, FUNC_KW},
+    [43] = {"float", 5, FLOAT_KW},
+    [45] = {"or", 2, OR_OP},
+    [47] = {"void", 4, VOID_KW},
+    [53] = {"private", 7, PRIVATE_KW},
+    [56] = {"then", 4, THEN_KW},
+    [59] = {"construct", 9, CONSTRUCT_KW},
+    [61] = {"constructor", 11, CONSTRUCTOR_KW},
+    [63] = {"implement", 9, IMPLEMENT_KW},
+};
+
+/* Returns the keyword's token code, or IDENTIFIER if the word is not reserved */
+static inline int keyword_lookup(const char *word, int length)
+{
+    if (length < KEYWORD_MIN_LEN || length > KEYWORD_MAX_LEN)
+    {
+        return IDENTIFIER;
+    }
+
+    const struct KeywordSlot *slot = &keyword_table[KEYWORD_HASH(word, length)];
+    if (slot->length == length && memcmp(slot->name, word, length) == 0)
+    {
+        return slot->token;
+    }
+    return IDENTIFIER;
+}
+
+#endif
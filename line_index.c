@@ -0,0 +1,81 @@
+#include "line_index.h"
+#include "vec.h"
+#include <stdlib.h>
+
+static void line_index_push(LineIndex *index, int *capacity, unsigned int start)
+{
+    if (index->count == *capacity)
+    {
+        *capacity *= 2;
+        index->starts = (unsigned int *)realloc(index->starts, *capacity * sizeof(unsigned int));
+    }
+    index->starts[index->count++] = start;
+}
+
+void line_index_build(LineIndex *index, const char *text, int size)
+{
+    int capacity = size / 32 + 16;
+    index->starts = (unsigned int *)malloc(capacity * sizeof(unsigned int));
+    index->count = 0;
+    line_index_push(index, &capacity, 0);
+
+    int p = 0;
+#ifdef VEC_WIDTH
+    vec_t newline = vec_set1('\n');
+    for (; p + VEC_WIDTH <= size; p += VEC_WIDTH)
+    {
+        unsigned int hits = vec_mask(vec_eq(vec_load(text + p), newline));
+        while (hits != 0)
+        {
+            line_index_push(index, &capacity, (unsigned int)(p + __builtin_ctz(hits) + 1));
+            hits &= hits - 1;
+        }
+    }
+#endif
+    for (; p < size; p++)
+    {
+        if (text[p] == '\n')
+        {
+            line_index_push(index, &capacity, (unsigned int)(p + 1));
+        }
+    }
+}
+
+void line_index_free(LineIndex *index)
+{
+    free(index->starts);
+    index->starts = NULL;
+    index->count = 0;
+}
+
+/* Index of the last line starting at or before offset */
+static int line_index_find(const LineIndex *index, unsigned int offset)
+{
+    int lo = 0;
+    int hi = index->count - 1;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (index->starts[mid] <= offset)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+void line_index_locate(const LineIndex *index, unsigned int offset, int *line, int *col)
+{
+    int i = line_index_find(index, offset);
+    *line = i + 1;
+    *col = (int)(offset - index->starts[i]) + 1;
+}
+
+int line_index_line(const LineIndex *index, unsigned int offset)
+{
+    return line_index_find(index, offset) + 1;
+}
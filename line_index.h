@@ -0,0 +1,22 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+/* Byte offset at which every line of a source starts. Tokens and AST
+   nodes only carry offsets; lines and columns are looked up here when a
+   message or trace record actually needs them. */
+typedef struct LineIndex
+{
+    unsigned int *starts; /* starts[0] is always 0 */
+    int count;
+} LineIndex;
+
+void line_index_build(LineIndex *index, const char *text, int size);
+
+void line_index_free(LineIndex *index);
+
+/* 1-based line and column of offset; tabs count as one column */
+void line_index_locate(const LineIndex *index, unsigned int offset, int *line, int *col);
+
+int line_index_line(const LineIndex *index, unsigned int offset);
+
+#endif
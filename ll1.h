@@ -0,0 +1,56 @@
+#ifndef LL1_H
+#define LL1_H
+
+#include "ast.h"
+#include "compile_context.h"
+
+/* Interface between the tables ll1gen writes to ll1_tables.h and the
+   driver in parser.c. A stack symbol is a kind in the high bits and a
+   token, nonterminal, external or production index in the low ones. */
+
+#define LL1_TOKEN 0x0000       /* match the token */
+#define LL1_CAPTURE 0x1000     /* keep the token as a value, then match it */
+#define LL1_NONTERMINAL 0x2000 /* predict and expand a production */
+#define LL1_EXTERN 0x3000      /* call a hand-written parse function */
+#define LL1_LIST 0x4000        /* repeat a nonterminal into a list value */
+#define LL1_LIST_NEXT 0x5000   /* driver only: predict the next list item */
+#define LL1_LIST_APPEND 0x6000 /* driver only: link the parsed item */
+#define LL1_REDUCE 0x7000      /* driver only: run a production's action */
+#define LL1_LIST_CLOSE 0x8000  /* driver only: match the brace after a %sync list */
+
+#define LL1_KIND(symbol) ((symbol) & 0xF000)
+#define LL1_INDEX(symbol) ((symbol) & 0x0FFF)
+
+/* A value produced while a production is expanded */
+typedef union LLValue
+{
+    struct ASTNode *node;
+    struct
+    {
+        const char *name; /* interned for identifiers only */
+        unsigned int offset;
+        TokenValue value;
+    } token;
+    struct
+    {
+        struct ASTNode *head;
+        struct ASTNode *last;
+    } list;
+} LLValue;
+
+typedef struct LLProduction
+{
+    unsigned short first; /* index of the right-hand side in ll1_rhs */
+    unsigned char length;
+    unsigned char action; /* 0 when the values are passed up unchanged */
+} LLProduction;
+
+/* Builds a node from the production's values; start is the offset of the
+   token the production was predicted on */
+typedef struct ASTNode *(*LLAction)(CompileContext *ctx, const LLValue *values, unsigned int start);
+
+typedef struct ASTNode *(*LLExtern)(CompileContext *ctx);
+
+typedef void (*LLErrorHook)(CompileContext *ctx);
+
+#endif
@@ -0,0 +1,537 @@
+/* Generated by ll1gen from grammar.ll1; do not edit */
+
+#ifndef LL1_TABLES_H
+#define LL1_TABLES_H
+
+#include "ll1.h"
+
+enum
+{
+    NT_PROG,
+    NT_CLASS_OR_IMPL_OR_FUNC,
+    NT_CLASS_DECL,
+    NT_ISA_OPT,
+    NT_INHERITANCE,
+    NT_VISIBILITY_MEMBERS,
+    NT_VISIBILITY,
+    NT_MEMBER_DECL,
+    NT_ATTRIBUTE_DECL,
+    NT_IMPL_DEF,
+    NT_FUNC_DEF,
+    NT_FUNC_HEAD,
+    NT_RETURN_TYPE,
+    NT_TYPE,
+    NT_F_PARAMS,
+    NT_PARAM_TAIL,
+    NT_PARAM,
+    NT_FUNC_BODY,
+    NT_VAR_DECL_OR_STMT,
+    NT_VAR_DECL,
+    NT_ARRAY_SIZE,
+    NT_SIZE_OPT,
+    NT_STATEMENT,
+    NT_THEN_KW,
+    NT_STAT_BLOCK,
+    NT_BLOCK,
+    NT_ELSE_OPT,
+    NT_ELSE_BODY,
+    LL1_NONTERMINAL_COUNT
+};
+
+#define LL1_START NT_PROG
+
+enum
+{
+    EXTERN_EXPR,
+    EXTERN_VARIABLE,
+    EXTERN_ASSIGN_OR_CALL,
+    LL1_EXTERN_COUNT
+};
+
+/* FIRST and FOLLOW sets
+   prog (nullable)
+     FIRST: CLASS_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+     FOLLOW: $end
+   classOrImplOrFunc
+     FIRST: CLASS_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+     FOLLOW: $end CLASS_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+   classDecl
+     FIRST: CLASS_KW
+     FOLLOW: $end CLASS_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+   isaOpt (nullable)
+     FIRST: ISA_KW
+     FOLLOW: LBRACE COMMA
+   inheritance
+     FIRST: COMMA
+     FOLLOW: LBRACE COMMA
+   visibilityMembers (nullable)
+     FIRST: PUBLIC_KW PRIVATE_KW
+     FOLLOW: RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW FUNC_KW CONSTRUCTOR_KW
+   visibility
+     FIRST: PUBLIC_KW PRIVATE_KW
+     FOLLOW: RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW FUNC_KW CONSTRUCTOR_KW
+   memberDecl
+     FIRST: ATTRIBUTE_KW FUNC_KW CONSTRUCTOR_KW
+     FOLLOW: RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW FUNC_KW CONSTRUCTOR_KW
+   attributeDecl
+     FIRST: ATTRIBUTE_KW
+     FOLLOW: RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW FUNC_KW CONSTRUCTOR_KW
+   implDef
+     FIRST: IMPLEMENT_KW
+     FOLLOW: $end CLASS_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+   funcDef
+     FIRST: FUNC_KW CONSTRUCTOR_KW
+     FOLLOW: $end CLASS_KW RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+   funcHead
+     FIRST: FUNC_KW CONSTRUCTOR_KW
+     FOLLOW: LBRACE
+   returnType
+     FIRST: VOID_KW INTEGER_KW FLOAT_KW STRING_KW
+     FOLLOW: LBRACE
+   type
+     FIRST: INTEGER_KW FLOAT_KW STRING_KW
+     FOLLOW: LBRACE COMMA RPAREN SEMICOLON LBRACKET
+   fParams (nullable)
+     FIRST: IDENTIFIER
+     FOLLOW: RPAREN
+   paramTail
+     FIRST: COMMA
+     FOLLOW: COMMA RPAREN
+   param
+     FIRST: IDENTIFIER
+     FOLLOW: COMMA RPAREN
+   funcBody
+     FIRST: LBRACE
+     FOLLOW: $end CLASS_KW RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW IMPLEMENT_KW FUNC_KW CONSTRUCTOR_KW
+   varDeclOrStmt
+     FIRST: IDENTIFIER LOCAL_KW IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW
+     FOLLOW: IDENTIFIER RBRACE LOCAL_KW IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW
+   varDecl
+     FIRST: IDENTIFIER
+     FOLLOW: IDENTIFIER RBRACE PUBLIC_KW PRIVATE_KW ATTRIBUTE_KW FUNC_KW CONSTRUCTOR_KW LOCAL_KW IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW
+   arraySize
+     FIRST: LBRACKET
+     FOLLOW: COMMA RPAREN SEMICOLON LBRACKET
+   sizeOpt (nullable)
+     FIRST: INTEGER_LIT
+     FOLLOW: RBRACKET
+   statement
+     FIRST: IDENTIFIER IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW
+     FOLLOW: IDENTIFIER RBRACE LOCAL_KW SEMICOLON IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW ELSE_KW
+   thenKw
+     FIRST: THEN_KW
+     FOLLOW: IDENTIFIER LBRACE RBRACE LOCAL_KW SEMICOLON IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW ELSE_KW
+   statBlock (nullable)
+     FIRST: IDENTIFIER LBRACE IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW
+     FOLLOW: IDENTIFIER RBRACE LOCAL_KW SEMICOLON IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW ELSE_KW
+   block
+     FIRST: LBRACE
+     FOLLOW: IDENTIFIER RBRACE LOCAL_KW SEMICOLON IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW ELSE_KW
+   elseOpt (nullable)
+     FIRST: ELSE_KW
+     FOLLOW: IDENTIFIER RBRACE LOCAL_KW SEMICOLON IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW ELSE_KW
+   elseBody
+     FIRST: IDENTIFIER LBRACE IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW
+     FOLLOW: IDENTIFIER RBRACE LOCAL_KW SEMICOLON IF_KW WHILE_KW READ_KW WRITE_KW RETURN_KW ELSE_KW
+ */
+
+struct ASTNode *parse_expr(CompileContext *ctx);
+struct ASTNode *parse_variable(CompileContext *ctx);
+struct ASTNode *parse_assignOrCall(CompileContext *ctx);
+static struct ASTNode *reduce_prog(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_class_decl(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_isa(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_null(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_id(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_visibility_members(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_public(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_private(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_attribute_decl(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_impl_def(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_func_def(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_func_head(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_constructor_head(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_void_type(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_integer_type(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_float_type(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_string_type(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_params(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_var_decl(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_func_body(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_int_lit(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_if(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_while(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_read(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_write(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_return(CompileContext *ctx, const LLValue *values, unsigned int start);
+static struct ASTNode *reduce_stat_block(CompileContext *ctx, const LLValue *values, unsigned int start);
+static void unexpected_statement(CompileContext *ctx);
+static void unexpected_statement(CompileContext *ctx);
+
+static const LLExtern ll1_externs[LL1_EXTERN_COUNT] = {
+    parse_expr,
+    parse_variable,
+    parse_assignOrCall,
+};
+
+/* Indexed by LLProduction.action */
+static const LLAction ll1_actions[] = {
+    NULL,
+    reduce_prog,
+    reduce_class_decl,
+    reduce_isa,
+    reduce_null,
+    reduce_id,
+    reduce_visibility_members,
+    reduce_public,
+    reduce_private,
+    reduce_attribute_decl,
+    reduce_impl_def,
+    reduce_func_def,
+    reduce_func_head,
+    reduce_constructor_head,
+    reduce_void_type,
+    reduce_integer_type,
+    reduce_float_type,
+    reduce_string_type,
+    reduce_params,
+    reduce_var_decl,
+    reduce_func_body,
+    reduce_int_lit,
+    reduce_if,
+    reduce_while,
+    reduce_read,
+    reduce_write,
+    reduce_return,
+    reduce_stat_block,
+};
+
+static const char *const ll1_error_messages[LL1_NONTERMINAL_COUNT] = {
+    [NT_CLASS_OR_IMPL_OR_FUNC] = "Expected class, implement, or func",
+    [NT_VISIBILITY] = "Expected public or private",
+    [NT_MEMBER_DECL] = "Expected func, attribute or constructor",
+    [NT_FUNC_HEAD] = "Expected func or constructor",
+    [NT_RETURN_TYPE] = "Expected integer, float, or id",
+    [NT_TYPE] = "Expected integer, float, or id",
+    [NT_VAR_DECL_OR_STMT] = "Expected local variable declaration or statement",
+    [NT_THEN_KW] = "Syntax error: expected 'then' after if condition",
+};
+
+static const LLErrorHook ll1_error_hooks[LL1_NONTERMINAL_COUNT] = {
+    [NT_STATEMENT] = unexpected_statement,
+    [NT_ELSE_BODY] = unexpected_statement,
+};
+
+/* List items error recovery may resume at */
+static const unsigned char ll1_sync[LL1_NONTERMINAL_COUNT] = {
+    [NT_CLASS_OR_IMPL_OR_FUNC] = 1,
+    [NT_MEMBER_DECL] = 1,
+    [NT_FUNC_DEF] = 1,
+    [NT_VAR_DECL_OR_STMT] = 1,
+    [NT_STATEMENT] = 1,
+};
+
+/* Values each nonterminal leaves on the stack */
+static const unsigned char ll1_arity[LL1_NONTERMINAL_COUNT] = {
+    [NT_PROG] = 1,
+    [NT_CLASS_OR_IMPL_OR_FUNC] = 1,
+    [NT_CLASS_DECL] = 1,
+    [NT_ISA_OPT] = 1,
+    [NT_INHERITANCE] = 1,
+    [NT_VISIBILITY_MEMBERS] = 1,
+    [NT_VISIBILITY] = 1,
+    [NT_MEMBER_DECL] = 1,
+    [NT_ATTRIBUTE_DECL] = 1,
+    [NT_IMPL_DEF] = 1,
+    [NT_FUNC_DEF] = 1,
+    [NT_FUNC_HEAD] = 1,
+    [NT_RETURN_TYPE] = 1,
+    [NT_TYPE] = 1,
+    [NT_F_PARAMS] = 1,
+    [NT_PARAM_TAIL] = 1,
+    [NT_PARAM] = 1,
+    [NT_FUNC_BODY] = 1,
+    [NT_VAR_DECL_OR_STMT] = 1,
+    [NT_VAR_DECL] = 1,
+    [NT_ARRAY_SIZE] = 1,
+    [NT_SIZE_OPT] = 1,
+    [NT_STATEMENT] = 1,
+    [NT_THEN_KW] = 0,
+    [NT_STAT_BLOCK] = 1,
+    [NT_BLOCK] = 1,
+    [NT_ELSE_OPT] = 1,
+    [NT_ELSE_BODY] = 1,
+};
+
+static const unsigned short ll1_rhs[] = {
+    /* 1 prog: { classOrImplOrFunc } #prog */
+    LL1_LIST | NT_CLASS_OR_IMPL_OR_FUNC,
+    /* 2 classOrImplOrFunc: classDecl */
+    LL1_NONTERMINAL | NT_CLASS_DECL,
+    /* 3 classOrImplOrFunc: implDef */
+    LL1_NONTERMINAL | NT_IMPL_DEF,
+    /* 4 classOrImplOrFunc: funcDef */
+    LL1_NONTERMINAL | NT_FUNC_DEF,
+    /* 5 classDecl: CLASS_KW IDENTIFIER@ isaOpt { inheritance } LBRACE visibilityMembers RBRACE #class_decl */
+    LL1_TOKEN | CLASS_KW,
+    LL1_CAPTURE | IDENTIFIER,
+    LL1_NONTERMINAL | NT_ISA_OPT,
+    LL1_LIST | NT_INHERITANCE,
+    LL1_TOKEN | LBRACE,
+    LL1_NONTERMINAL | NT_VISIBILITY_MEMBERS,
+    LL1_TOKEN | RBRACE,
+    /* 6 isaOpt: ISA_KW IDENTIFIER@ { inheritance } #isa */
+    LL1_TOKEN | ISA_KW,
+    LL1_CAPTURE | IDENTIFIER,
+    LL1_LIST | NT_INHERITANCE,
+    /* 7 isaOpt: #null */
+    /* 8 inheritance: COMMA IDENTIFIER@ #id */
+    LL1_TOKEN | COMMA,
+    LL1_CAPTURE | IDENTIFIER,
+    /* 9 visibilityMembers: visibility { memberDecl } visibilityMembers { memberDecl } visibilityMembers #visibility_members */
+    LL1_NONTERMINAL | NT_VISIBILITY,
+    LL1_LIST | NT_MEMBER_DECL,
+    LL1_NONTERMINAL | NT_VISIBILITY_MEMBERS,
+    LL1_LIST | NT_MEMBER_DECL,
+    LL1_NONTERMINAL | NT_VISIBILITY_MEMBERS,
+    /* 10 visibilityMembers: #null */
+    /* 11 visibility: PUBLIC_KW #public */
+    LL1_TOKEN | PUBLIC_KW,
+    /* 12 visibility: PRIVATE_KW #private */
+    LL1_TOKEN | PRIVATE_KW,
+    /* 13 memberDecl: funcDef */
+    LL1_NONTERMINAL | NT_FUNC_DEF,
+    /* 14 memberDecl: attributeDecl */
+    LL1_NONTERMINAL | NT_ATTRIBUTE_DECL,
+    /* 15 attributeDecl: ATTRIBUTE_KW varDecl #attribute_decl */
+    LL1_TOKEN | ATTRIBUTE_KW,
+    LL1_NONTERMINAL | NT_VAR_DECL,
+    /* 16 implDef: IMPLEMENT_KW IDENTIFIER@ LBRACE { funcDef } RBRACE #impl_def */
+    LL1_TOKEN | IMPLEMENT_KW,
+    LL1_CAPTURE | IDENTIFIER,
+    LL1_TOKEN | LBRACE,
+    LL1_LIST | NT_FUNC_DEF,
+    LL1_TOKEN | RBRACE,
+    /* 17 funcDef: funcHead funcBody #func_def */
+    LL1_NONTERMINAL | NT_FUNC_HEAD,
+    LL1_NONTERMINAL | NT_FUNC_BODY,
+    /* 18 funcHead: FUNC_KW IDENTIFIER@ LPAREN fParams RPAREN ARROW returnType #func_head */
+    LL1_TOKEN | FUNC_KW,
+    LL1_CAPTURE | IDENTIFIER,
+    LL1_TOKEN | LPAREN,
+    LL1_NONTERMINAL | NT_F_PARAMS,
+    LL1_TOKEN | RPAREN,
+    LL1_TOKEN | ARROW,
+    LL1_NONTERMINAL | NT_RETURN_TYPE,
+    /* 19 funcHead: CONSTRUCTOR_KW LPAREN fParams RPAREN #constructor_head */
+    LL1_TOKEN | CONSTRUCTOR_KW,
+    LL1_TOKEN | LPAREN,
+    LL1_NONTERMINAL | NT_F_PARAMS,
+    LL1_TOKEN | RPAREN,
+    /* 20 returnType: VOID_KW #void_type */
+    LL1_TOKEN | VOID_KW,
+    /* 21 returnType: type */
+    LL1_NONTERMINAL | NT_TYPE,
+    /* 22 type: INTEGER_KW #integer_type */
+    LL1_TOKEN | INTEGER_KW,
+    /* 23 type: FLOAT_KW #float_type */
+    LL1_TOKEN | FLOAT_KW,
+    /* 24 type: STRING_KW #string_type */
+    LL1_TOKEN | STRING_KW,
+    /* 25 fParams: param { paramTail } #params */
+    LL1_NONTERMINAL | NT_PARAM,
+    LL1_LIST | NT_PARAM_TAIL,
+    /* 26 fParams: #null */
+    /* 27 paramTail: COMMA param */
+    LL1_TOKEN | COMMA,
+    LL1_NONTERMINAL | NT_PARAM,
+    /* 28 param: IDENTIFIER@ COLON type { arraySize } #var_decl */
+    LL1_CAPTURE | IDENTIFIER,
+    LL1_TOKEN | COLON,
+    LL1_NONTERMINAL | NT_TYPE,
+    LL1_LIST | NT_ARRAY_SIZE,
+    /* 29 funcBody: LBRACE { varDeclOrStmt } RBRACE #func_body */
+    LL1_TOKEN | LBRACE,
+    LL1_LIST | NT_VAR_DECL_OR_STMT,
+    LL1_TOKEN | RBRACE,
+    /* 30 varDeclOrStmt: LOCAL_KW varDecl */
+    LL1_TOKEN | LOCAL_KW,
+    LL1_NONTERMINAL | NT_VAR_DECL,
+    /* 31 varDeclOrStmt: statement */
+    LL1_NONTERMINAL | NT_STATEMENT,
+    /* 32 varDecl: IDENTIFIER@ COLON type { arraySize } SEMICOLON #var_decl */
+    LL1_CAPTURE | IDENTIFIER,
+    LL1_TOKEN | COLON,
+    LL1_NONTERMINAL | NT_TYPE,
+    LL1_LIST | NT_ARRAY_SIZE,
+    LL1_TOKEN | SEMICOLON,
+    /* 33 arraySize: LBRACKET sizeOpt RBRACKET */
+    LL1_TOKEN | LBRACKET,
+    LL1_NONTERMINAL | NT_SIZE_OPT,
+    LL1_TOKEN | RBRACKET,
+    /* 34 sizeOpt: INTEGER_LIT@ #int_lit */
+    LL1_CAPTURE | INTEGER_LIT,
+    /* 35 sizeOpt: #null */
+    /* 36 statement: IF_KW LPAREN expr RPAREN thenKw statBlock elseOpt #if */
+    LL1_TOKEN | IF_KW,
+    LL1_TOKEN | LPAREN,
+    LL1_EXTERN | EXTERN_EXPR,
+    LL1_TOKEN | RPAREN,
+    LL1_NONTERMINAL | NT_THEN_KW,
+    LL1_NONTERMINAL | NT_STAT_BLOCK,
+    LL1_NONTERMINAL | NT_ELSE_OPT,
+    /* 37 statement: WHILE_KW LPAREN expr RPAREN statBlock SEMICOLON #while */
+    LL1_TOKEN | WHILE_KW,
+    LL1_TOKEN | LPAREN,
+    LL1_EXTERN | EXTERN_EXPR,
+    LL1_TOKEN | RPAREN,
+    LL1_NONTERMINAL | NT_STAT_BLOCK,
+    LL1_TOKEN | SEMICOLON,
+    /* 38 statement: READ_KW LPAREN variable RPAREN SEMICOLON #read */
+    LL1_TOKEN | READ_KW,
+    LL1_TOKEN | LPAREN,
+    LL1_EXTERN | EXTERN_VARIABLE,
+    LL1_TOKEN | RPAREN,
+    LL1_TOKEN | SEMICOLON,
+    /* 39 statement: WRITE_KW LPAREN expr RPAREN SEMICOLON #write */
+    LL1_TOKEN | WRITE_KW,
+    LL1_TOKEN | LPAREN,
+    LL1_EXTERN | EXTERN_EXPR,
+    LL1_TOKEN | RPAREN,
+    LL1_TOKEN | SEMICOLON,
+    /* 40 statement: RETURN_KW expr SEMICOLON #return */
+    LL1_TOKEN | RETURN_KW,
+    LL1_EXTERN | EXTERN_EXPR,
+    LL1_TOKEN | SEMICOLON,
+    /* 41 statement: assignOrCall */
+    LL1_EXTERN | EXTERN_ASSIGN_OR_CALL,
+    /* 42 thenKw: THEN_KW */
+    LL1_TOKEN | THEN_KW,
+    /* 43 statBlock: block */
+    LL1_NONTERMINAL | NT_BLOCK,
+    /* 44 statBlock: statement */
+    LL1_NONTERMINAL | NT_STATEMENT,
+    /* 45 statBlock: #null */
+    /* 46 block: LBRACE { statement } RBRACE #stat_block */
+    LL1_TOKEN | LBRACE,
+    LL1_LIST | NT_STATEMENT,
+    LL1_TOKEN | RBRACE,
+    /* 47 elseOpt: ELSE_KW elseBody */
+    LL1_TOKEN | ELSE_KW,
+    LL1_NONTERMINAL | NT_ELSE_BODY,
+    /* 48 elseOpt: #null */
+    /* 49 elseBody: block */
+    LL1_NONTERMINAL | NT_BLOCK,
+    /* 50 elseBody: statement */
+    LL1_NONTERMINAL | NT_STATEMENT,
+};
+
+/* Production 0 stands for no prediction */
+static const LLProduction ll1_productions[] = {
+    {0, 0, 0},
+    {0, 1, 1},
+    {1, 1, 0},
+    {2, 1, 0},
+    {3, 1, 0},
+    {4, 7, 2},
+    {11, 3, 3},
+    {14, 0, 4},
+    {14, 2, 5},
+    {16, 5, 6},
+    {21, 0, 4},
+    {21, 1, 7},
+    {22, 1, 8},
+    {23, 1, 0},
+    {24, 1, 0},
+    {25, 2, 9},
+    {27, 5, 10},
+    {32, 2, 11},
+    {34, 7, 12},
+    {41, 4, 13},
+    {45, 1, 14},
+    {46, 1, 0},
+    {47, 1, 15},
+    {48, 1, 16},
+    {49, 1, 17},
+    {50, 2, 18},
+    {52, 0, 4},
+    {52, 2, 0},
+    {54, 4, 19},
+    {58, 3, 20},
+    {61, 2, 0},
+    {63, 1, 0},
+    {64, 5, 19},
+    {69, 3, 0},
+    {72, 1, 21},
+    {73, 0, 4},
+    {73, 7, 22},
+    {80, 6, 23},
+    {86, 5, 24},
+    {91, 5, 25},
+    {96, 3, 26},
+    {99, 1, 0},
+    {100, 1, 0},
+    {101, 1, 0},
+    {102, 1, 0},
+    {103, 0, 4},
+    {103, 3, 27},
+    {106, 2, 0},
+    {108, 0, 4},
+    {108, 1, 0},
+    {109, 1, 0},
+};
+
+/* Production entered on a token the table does not predict */
+static const unsigned char ll1_fallback[LL1_NONTERMINAL_COUNT] = {
+    [NT_PROG] = 1,
+    [NT_CLASS_DECL] = 5,
+    [NT_ISA_OPT] = 7,
+    [NT_INHERITANCE] = 8,
+    [NT_VISIBILITY_MEMBERS] = 10,
+    [NT_ATTRIBUTE_DECL] = 15,
+    [NT_IMPL_DEF] = 16,
+    [NT_FUNC_DEF] = 17,
+    [NT_F_PARAMS] = 26,
+    [NT_PARAM_TAIL] = 27,
+    [NT_PARAM] = 28,
+    [NT_FUNC_BODY] = 29,
+    [NT_VAR_DECL] = 32,
+    [NT_ARRAY_SIZE] = 33,
+    [NT_SIZE_OPT] = 35,
+    [NT_STAT_BLOCK] = 45,
+    [NT_BLOCK] = 46,
+    [NT_ELSE_OPT] = 48,
+};
+
+static const unsigned char ll1_predict[LL1_NONTERMINAL_COUNT][LAST_KEYWORD + 1] = {
+    [NT_PROG] = {[CLASS_KW] = 1, [IMPLEMENT_KW] = 1, [FUNC_KW] = 1, [CONSTRUCTOR_KW] = 1},
+    [NT_CLASS_OR_IMPL_OR_FUNC] = {[CLASS_KW] = 2, [IMPLEMENT_KW] = 3, [FUNC_KW] = 4, [CONSTRUCTOR_KW] = 4},
+    [NT_CLASS_DECL] = {[CLASS_KW] = 5},
+    [NT_ISA_OPT] = {[ISA_KW] = 6},
+    [NT_INHERITANCE] = {[COMMA] = 8},
+    [NT_VISIBILITY_MEMBERS] = {[PUBLIC_KW] = 9, [PRIVATE_KW] = 9},
+    [NT_VISIBILITY] = {[PUBLIC_KW] = 11, [PRIVATE_KW] = 12},
+    [NT_MEMBER_DECL] = {[ATTRIBUTE_KW] = 14, [FUNC_KW] = 13, [CONSTRUCTOR_KW] = 13},
+    [NT_ATTRIBUTE_DECL] = {[ATTRIBUTE_KW] = 15},
+    [NT_IMPL_DEF] = {[IMPLEMENT_KW] = 16},
+    [NT_FUNC_DEF] = {[FUNC_KW] = 17, [CONSTRUCTOR_KW] = 17},
+    [NT_FUNC_HEAD] = {[FUNC_KW] = 18, [CONSTRUCTOR_KW] = 19},
+    [NT_RETURN_TYPE] = {[VOID_KW] = 20, [INTEGER_KW] = 21, [FLOAT_KW] = 21, [STRING_KW] = 21},
+    [NT_TYPE] = {[INTEGER_KW] = 22, [FLOAT_KW] = 23, [STRING_KW] = 24},
+    [NT_F_PARAMS] = {[IDENTIFIER] = 25},
+    [NT_PARAM_TAIL] = {[COMMA] = 27},
+    [NT_PARAM] = {[IDENTIFIER] = 28},
+    [NT_FUNC_BODY] = {[LBRACE] = 29},
+    [NT_VAR_DECL_OR_STMT] = {[IDENTIFIER] = 31, [LOCAL_KW] = 30, [IF_KW] = 31, [WHILE_KW] = 31, [READ_KW] = 31, [WRITE_KW] = 31, [RETURN_KW] = 31},
+    [NT_VAR_DECL] = {[IDENTIFIER] = 32},
+    [NT_ARRAY_SIZE] = {[LBRACKET] = 33},
+    [NT_SIZE_OPT] = {[INTEGER_LIT] = 34},
+    [NT_STATEMENT] = {[IDENTIFIER] = 41, [IF_KW] = 36, [WHILE_KW] = 37, [READ_KW] = 38, [WRITE_KW] = 39, [RETURN_KW] = 40},
+    [NT_THEN_KW] = {[THEN_KW] = 42},
+    [NT_STAT_BLOCK] = {[IDENTIFIER] = 44, [LBRACE] = 43, [IF_KW] = 44, [WHILE_KW] = 44, [READ_KW] = 44, [WRITE_KW] = 44, [RETURN_KW] = 44},
+    [NT_BLOCK] = {[LBRACE] = 46},
+    [NT_ELSE_OPT] = {[ELSE_KW] = 47},
+    [NT_ELSE_BODY] = {[IDENTIFIER] = 50, [LBRACE] = 49, [IF_KW] = 50, [WHILE_KW] = 50, [READ_KW] = 50, [WRITE_KW] = 50, [RETURN_KW] = 50},
+};
+
+#endif
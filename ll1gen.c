@@ -0,0 +1,1136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* Reads an LL(1) grammar (see grammar.ll1), computes FIRST and FOLLOW
+   sets, checks that every alternative can be predicted from one token of
+   lookahead and writes the prediction and production tables the driver
+   in parser.c runs on.
+
+   usage: ll1gen grammar.ll1 ll1_tables.h */
+
+#define MAX_SYMBOLS 256
+#define MAX_PRODUCTIONS 255 /* production numbers are stored in a byte */
+#define MAX_RHS 16
+#define MAX_ACTIONS 255
+
+typedef enum
+{
+    SYM_TOKEN,
+    SYM_NONTERMINAL,
+    SYM_EXTERN
+} SymbolKind;
+
+typedef enum
+{
+    ITEM_TOKEN,
+    ITEM_CAPTURE,
+    ITEM_NONTERMINAL,
+    ITEM_EXTERN,
+    ITEM_LIST
+} ItemKind;
+
+typedef struct Symbol
+{
+    char *name;
+    SymbolKind kind;
+    int defined;
+    int used;
+
+    /* Nonterminals */
+    int nullable;
+    int arity; /* values left on the stack; -1 until known, -2 while computed */
+    unsigned char first[MAX_SYMBOLS];
+    unsigned char follow[MAX_SYMBOLS];
+    char *error_message;
+    char *error_hook;
+    int sync;   /* %sync: error recovery may resume at an item of its lists */
+    int listed; /* repeated by some list */
+
+    /* Externals */
+    char *function;
+} Symbol;
+
+typedef struct Item
+{
+    ItemKind kind;
+    int symbol;
+} Item;
+
+typedef struct Production
+{
+    int lhs;
+    Item rhs[MAX_RHS];
+    int length;
+    int action; /* index into actions, -1 for none */
+    int line;
+} Production;
+
+typedef struct Grammar
+{
+    Symbol symbols[MAX_SYMBOLS];
+    int symbol_count;
+    Production productions[MAX_PRODUCTIONS + 1]; /* 0 is unused */
+    int production_count;
+    char *actions[MAX_ACTIONS];
+    int action_count;
+    int expected_conflicts;
+    int conflicts;
+
+    /* Nonterminals and externals in order of definition */
+    int nonterminals[MAX_SYMBOLS];
+    int nonterminal_count;
+    int externs[MAX_SYMBOLS];
+    int extern_count;
+
+    unsigned char predict[MAX_SYMBOLS][MAX_SYMBOLS]; /* nonterminal, token */
+    int fallback[MAX_SYMBOLS];
+} Grammar;
+
+typedef enum
+{
+    TOK_END,
+    TOK_NAME,
+    TOK_CAPTURE,
+    TOK_ACTION,
+    TOK_DIRECTIVE,
+    TOK_STRING,
+    TOK_PUNCT
+} LexKind;
+
+typedef struct Lexer
+{
+    const char *path;
+    const char *p;
+    int line;
+    LexKind kind;
+    char text[256];
+} Lexer;
+
+static void fatal(const Lexer *lex, const char *msg, const char *detail)
+{
+    if (lex != NULL)
+    {
+        fprintf(stderr, "%s:%d: %s%s%s\n", lex->path, lex->line, msg, detail ? ": " : "", detail ? detail : "");
+    }
+    else
+    {
+        fprintf(stderr, "ll1gen: %s%s%s\n", msg, detail ? ": " : "", detail ? detail : "");
+    }
+    exit(1);
+}
+
+static char *copy_string(const char *s)
+{
+    char *copy = (char *)malloc(strlen(s) + 1);
+    strcpy(copy, s);
+    return copy;
+}
+
+static void next(Lexer *lex)
+{
+    for (;;)
+    {
+        while (isspace((unsigned char)*lex->p))
+        {
+            if (*lex->p == '\n')
+            {
+                lex->line++;
+            }
+            lex->p++;
+        }
+        if (lex->p[0] != '/' || lex->p[1] != '*')
+        {
+            break;
+        }
+        const char *end = strstr(lex->p + 2, "*/");
+        if (end == NULL)
+        {
+            fatal(lex, "unterminated comment", NULL);
+        }
+        for (; lex->p < end; lex->p++)
+        {
+            if (*lex->p == '\n')
+            {
+                lex->line++;
+            }
+        }
+        lex->p = end + 2;
+    }
+
+    const char *p = lex->p;
+    int length = 0;
+    if (*p == '\0')
+    {
+        lex->kind = TOK_END;
+        lex->text[0] = '\0';
+        return;
+    }
+    if (*p == '"')
+    {
+        p++;
+        while (*p != '"' && *p != '\0' && *p != '\n' && length < (int)sizeof(lex->text) - 1)
+        {
+            lex->text[length++] = *p++;
+        }
+        if (*p != '"')
+        {
+            fatal(lex, "unterminated string", NULL);
+        }
+        lex->text[length] = '\0';
+        lex->kind = TOK_STRING;
+        lex->p = p + 1;
+        return;
+    }
+
+    lex->kind = TOK_NAME;
+    if (*p == '#' || *p == '%')
+    {
+        lex->kind = *p == '#' ? TOK_ACTION : TOK_DIRECTIVE;
+        p++;
+    }
+    else if (strchr(":|;{}", *p) != NULL)
+    {
+        lex->kind = TOK_PUNCT;
+        lex->text[0] = *p;
+        lex->text[1] = '\0';
+        lex->p = p + 1;
+        return;
+    }
+
+    while ((isalnum((unsigned char)*p) || *p == '_') && length < (int)sizeof(lex->text) - 1)
+    {
+        lex->text[length++] = *p++;
+    }
+    lex->text[length] = '\0';
+    if (length == 0)
+    {
+        char bad[2] = {*p, '\0'};
+        fatal(lex, "unexpected character", bad);
+    }
+    if (lex->kind == TOK_NAME && *p == '@')
+    {
+        lex->kind = TOK_CAPTURE;
+        p++;
+    }
+    lex->p = p;
+}
+
+static int is_punct(const Lexer *lex, char c)
+{
+    return lex->kind == TOK_PUNCT && lex->text[0] == c;
+}
+
+static void expect_punct(Lexer *lex, char c)
+{
+    if (!is_punct(lex, c))
+    {
+        char expected[2] = {c, '\0'};
+        fatal(lex, "expected", expected);
+    }
+    next(lex);
+}
+
+static int is_token_name(const char *name)
+{
+    for (; *name != '\0'; name++)
+    {
+        if (!isupper((unsigned char)*name) && !isdigit((unsigned char)*name) && *name != '_')
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int find_symbol(Grammar *g, const char *name)
+{
+    for (int i = 0; i < g->symbol_count; i++)
+    {
+        if (strcmp(g->symbols[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Tokens are recognised by their capitalised names; anything else is a
+   nonterminal, defined by a rule or an %extern */
+static int intern_symbol(Grammar *g, const Lexer *lex, const char *name)
+{
+    int index = find_symbol(g, name);
+    if (index >= 0)
+    {
+        return index;
+    }
+    if (g->symbol_count == MAX_SYMBOLS)
+    {
+        fatal(lex, "too many symbols", NULL);
+    }
+    Symbol *s = &g->symbols[g->symbol_count];
+    memset(s, 0, sizeof(*s));
+    s->name = copy_string(name);
+    s->kind = is_token_name(name) ? SYM_TOKEN : SYM_NONTERMINAL;
+    s->arity = -1;
+    return g->symbol_count++;
+}
+
+static int intern_action(Grammar *g, const Lexer *lex, const char *name)
+{
+    for (int i = 0; i < g->action_count; i++)
+    {
+        if (strcmp(g->actions[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    if (g->action_count == MAX_ACTIONS)
+    {
+        fatal(lex, "too many actions", NULL);
+    }
+    g->actions[g->action_count] = copy_string(name);
+    return g->action_count++;
+}
+
+static void parse_directive(Grammar *g, Lexer *lex)
+{
+    char directive[256];
+    strcpy(directive, lex->text);
+    next(lex);
+
+    if (strcmp(directive, "expect") == 0)
+    {
+        if (lex->kind != TOK_NAME || !isdigit((unsigned char)lex->text[0]))
+        {
+            fatal(lex, "expected a conflict count", NULL);
+        }
+        g->expected_conflicts = atoi(lex->text);
+        next(lex);
+        return;
+    }
+
+    if (lex->kind != TOK_NAME || is_token_name(lex->text))
+    {
+        fatal(lex, "expected a nonterminal after", directive);
+    }
+    Symbol *s = &g->symbols[intern_symbol(g, lex, lex->text)];
+    next(lex);
+
+    if (strcmp(directive, "extern") == 0)
+    {
+        if (s->defined)
+        {
+            fatal(lex, "defined twice", s->name);
+        }
+        if (lex->kind != TOK_NAME)
+        {
+            fatal(lex, "expected a function name", NULL);
+        }
+        s->kind = SYM_EXTERN;
+        s->defined = 1;
+        s->arity = 1;
+        s->function = copy_string(lex->text);
+        g->externs[g->extern_count++] = (int)(s - g->symbols);
+        next(lex);
+        while (lex->kind == TOK_NAME && is_token_name(lex->text))
+        {
+            int token = intern_symbol(g, lex, lex->text);
+            g->symbols[token].used = 1;
+            s->first[token] = 1;
+            next(lex);
+        }
+    }
+    else if (strcmp(directive, "error") == 0)
+    {
+        if (lex->kind == TOK_STRING)
+        {
+            s->error_message = copy_string(lex->text);
+        }
+        else if (lex->kind == TOK_NAME)
+        {
+            s->error_hook = copy_string(lex->text);
+        }
+        else
+        {
+            fatal(lex, "expected a message or hook", NULL);
+        }
+        next(lex);
+    }
+    else if (strcmp(directive, "sync") == 0)
+    {
+        s->sync = 1;
+    }
+    else
+    {
+        fatal(lex, "unknown directive", directive);
+    }
+}
+
+static void parse_item(Grammar *g, Lexer *lex, Production *p)
+{
+    if (p->length == MAX_RHS)
+    {
+        fatal(lex, "production too long", NULL);
+    }
+    Item *item = &p->rhs[p->length++];
+
+    if (is_punct(lex, '{'))
+    {
+        next(lex);
+        if (lex->kind != TOK_NAME || is_token_name(lex->text))
+        {
+            fatal(lex, "a list repeats a single nonterminal", NULL);
+        }
+        item->kind = ITEM_LIST;
+        item->symbol = intern_symbol(g, lex, lex->text);
+        next(lex);
+        expect_punct(lex, '}');
+    }
+    else if (lex->kind == TOK_CAPTURE)
+    {
+        if (!is_token_name(lex->text))
+        {
+            fatal(lex, "only tokens can be captured", lex->text);
+        }
+        item->kind = ITEM_CAPTURE;
+        item->symbol = intern_symbol(g, lex, lex->text);
+        next(lex);
+    }
+    else if (lex->kind == TOK_NAME)
+    {
+        item->symbol = intern_symbol(g, lex, lex->text);
+        item->kind = is_token_name(lex->text) ? ITEM_TOKEN : ITEM_NONTERMINAL;
+        next(lex);
+    }
+    else
+    {
+        fatal(lex, "unexpected", lex->text);
+    }
+    g->symbols[item->symbol].used = 1;
+}
+
+static void parse_rule(Grammar *g, Lexer *lex)
+{
+    if (is_token_name(lex->text))
+    {
+        fatal(lex, "a rule must define a nonterminal", lex->text);
+    }
+    int lhs = intern_symbol(g, lex, lex->text);
+    Symbol *s = &g->symbols[lhs];
+    if (s->defined)
+    {
+        fatal(lex, "defined twice", s->name);
+    }
+    s->defined = 1;
+    g->nonterminals[g->nonterminal_count++] = lhs;
+    next(lex);
+    expect_punct(lex, ':');
+
+    for (;;)
+    {
+        if (g->production_count == MAX_PRODUCTIONS)
+        {
+            fatal(lex, "too many productions", NULL);
+        }
+        Production *p = &g->productions[++g->production_count];
+        p->lhs = lhs;
+        p->length = 0;
+        p->action = -1;
+        p->line = lex->line;
+
+        while (!is_punct(lex, '|') && !is_punct(lex, ';') && lex->kind != TOK_ACTION)
+        {
+            if (lex->kind == TOK_END)
+            {
+                fatal(lex, "missing ';' after rule", s->name);
+            }
+            parse_item(g, lex, p);
+        }
+        if (lex->kind == TOK_ACTION)
+        {
+            p->action = intern_action(g, lex, lex->text);
+            next(lex);
+        }
+
+        if (is_punct(lex, ';'))
+        {
+            next(lex);
+            return;
+        }
+        expect_punct(lex, '|');
+    }
+}
+
+static void parse_grammar(Grammar *g, Lexer *lex)
+{
+    /* Token 0 is the end of input */
+    intern_symbol(g, lex, "0");
+
+    next(lex);
+    while (lex->kind != TOK_END)
+    {
+        if (lex->kind == TOK_DIRECTIVE)
+        {
+            parse_directive(g, lex);
+        }
+        else if (lex->kind == TOK_NAME)
+        {
+            parse_rule(g, lex);
+        }
+        else
+        {
+            fatal(lex, "expected a rule or directive", lex->text);
+        }
+    }
+
+    if (g->nonterminal_count == 0)
+    {
+        fatal(NULL, "the grammar has no rules", NULL);
+    }
+    g->symbols[g->nonterminals[0]].used = 1;
+    for (int i = 0; i < g->symbol_count; i++)
+    {
+        Symbol *s = &g->symbols[i];
+        if (s->kind == SYM_NONTERMINAL && !s->defined)
+        {
+            fatal(NULL, "undefined nonterminal", s->name);
+        }
+        if (s->kind != SYM_TOKEN && !s->used)
+        {
+            fprintf(stderr, "ll1gen: warning: %s is never used\n", s->name);
+        }
+    }
+}
+
+static int union_into(unsigned char *to, const unsigned char *from)
+{
+    int changed = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++)
+    {
+        if (from[i] && !to[i])
+        {
+            to[i] = 1;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+/* FIRST of rhs[from..]; returns whether the whole suffix can be empty */
+static int sequence_first(const Grammar *g, const Production *p, int from, unsigned char *first)
+{
+    for (int i = from; i < p->length; i++)
+    {
+        const Item *item = &p->rhs[i];
+        const Symbol *s = &g->symbols[item->symbol];
+        switch (item->kind)
+        {
+        case ITEM_TOKEN:
+        case ITEM_CAPTURE:
+            first[item->symbol] = 1;
+            return 0;
+        case ITEM_EXTERN:
+            union_into(first, s->first);
+            return 0;
+        case ITEM_NONTERMINAL:
+            union_into(first, s->first);
+            if (!s->nullable)
+            {
+                return 0;
+            }
+            break;
+        case ITEM_LIST:
+            union_into(first, s->first);
+            break;
+        }
+    }
+    return 1;
+}
+
+static void compute_sets(Grammar *g)
+{
+    /* Externals were read as nonterminals until their %extern was seen */
+    for (int i = 1; i <= g->production_count; i++)
+    {
+        Production *p = &g->productions[i];
+        for (int j = 0; j < p->length; j++)
+        {
+            if (p->rhs[j].kind == ITEM_NONTERMINAL && g->symbols[p->rhs[j].symbol].kind == SYM_EXTERN)
+            {
+                p->rhs[j].kind = ITEM_EXTERN;
+            }
+            if (p->rhs[j].kind == ITEM_LIST && g->symbols[p->rhs[j].symbol].kind != SYM_NONTERMINAL)
+            {
+                fatal(NULL, "a list repeats a grammar rule", g->symbols[p->rhs[j].symbol].name);
+            }
+            if (p->rhs[j].kind == ITEM_LIST)
+            {
+                g->symbols[p->rhs[j].symbol].listed = 1;
+            }
+        }
+    }
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        if (s->sync && !s->listed)
+        {
+            fatal(NULL, "%sync names a rule no list repeats", s->name);
+        }
+    }
+
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int i = 1; i <= g->production_count; i++)
+        {
+            Production *p = &g->productions[i];
+            Symbol *lhs = &g->symbols[p->lhs];
+            unsigned char first[MAX_SYMBOLS] = {0};
+            int nullable = sequence_first(g, p, 0, first);
+            changed |= union_into(lhs->first, first);
+            if (nullable && !lhs->nullable)
+            {
+                lhs->nullable = 1;
+                changed = 1;
+            }
+        }
+    }
+
+    g->symbols[g->nonterminals[0]].follow[0] = 1;
+    changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int i = 1; i <= g->production_count; i++)
+        {
+            Production *p = &g->productions[i];
+            for (int j = 0; j < p->length; j++)
+            {
+                const Item *item = &p->rhs[j];
+                if (item->kind != ITEM_NONTERMINAL && item->kind != ITEM_LIST)
+                {
+                    continue;
+                }
+                Symbol *s = &g->symbols[item->symbol];
+                unsigned char rest[MAX_SYMBOLS] = {0};
+                int nullable = sequence_first(g, p, j + 1, rest);
+                if (item->kind == ITEM_LIST)
+                {
+                    union_into(rest, s->first);
+                }
+                changed |= union_into(s->follow, rest);
+                if (nullable)
+                {
+                    changed |= union_into(s->follow, g->symbols[p->lhs].follow);
+                }
+            }
+        }
+    }
+}
+
+static void report_conflict(Grammar *g, int verbose, const char *where, int token, const char *resolution)
+{
+    g->conflicts++;
+    if (verbose)
+    {
+        fprintf(stderr, "ll1gen: conflict in %s on %s, %s\n", where, g->symbols[token].name, resolution);
+    }
+}
+
+/* Conflicts are resolved towards consuming input: an earlier alternative
+   over a later one, any alternative over the empty one, and one more
+   list item over ending the list */
+static void fill_predictions(Grammar *g, int verbose)
+{
+    g->conflicts = 0;
+    memset(g->predict, 0, sizeof(g->predict));
+    memset(g->fallback, 0, sizeof(g->fallback));
+
+    for (int i = 1; i <= g->production_count; i++)
+    {
+        Production *p = &g->productions[i];
+        Symbol *lhs = &g->symbols[p->lhs];
+        unsigned char first[MAX_SYMBOLS] = {0};
+        if (sequence_first(g, p, 0, first))
+        {
+            if (g->fallback[p->lhs] != 0)
+            {
+                fatal(NULL, "more than one empty alternative in", lhs->name);
+            }
+            g->fallback[p->lhs] = i;
+        }
+        for (int t = 0; t < g->symbol_count; t++)
+        {
+            if (!first[t])
+            {
+                continue;
+            }
+            if (g->predict[p->lhs][t] != 0)
+            {
+                report_conflict(g, verbose, lhs->name, t, "the earlier alternative is taken");
+                continue;
+            }
+            g->predict[p->lhs][t] = (unsigned char)i;
+        }
+
+        for (int j = 0; j < p->length; j++)
+        {
+            if (p->rhs[j].kind != ITEM_LIST)
+            {
+                continue;
+            }
+            const Symbol *item = &g->symbols[p->rhs[j].symbol];
+            unsigned char rest[MAX_SYMBOLS] = {0};
+            if (sequence_first(g, p, j + 1, rest))
+            {
+                union_into(rest, lhs->follow);
+            }
+            for (int t = 0; t < g->symbol_count; t++)
+            {
+                if (rest[t] && item->first[t])
+                {
+                    char where[300];
+                    sprintf(where, "list of %s in %s at line %d", item->name, lhs->name, p->line);
+                    report_conflict(g, verbose, where, t, "the list continues");
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        int nt = g->nonterminals[i];
+        const Symbol *s = &g->symbols[nt];
+        if (g->fallback[nt] == 0)
+        {
+            continue;
+        }
+        for (int t = 0; t < g->symbol_count; t++)
+        {
+            if (s->follow[t] && g->predict[nt][t] != 0)
+            {
+                report_conflict(g, verbose, s->name, t, "the non-empty alternative is taken");
+            }
+        }
+    }
+}
+
+static void build_predictions(Grammar *g)
+{
+    /* The conflicts are only listed when their number is not the one the
+       grammar expects */
+    fill_predictions(g, 0);
+    if (g->conflicts != g->expected_conflicts)
+    {
+        fill_predictions(g, 1);
+        fprintf(stderr, "ll1gen: %d conflicts, %d expected\n", g->conflicts, g->expected_conflicts);
+        exit(1);
+    }
+
+    /* Without an error to report, a nonterminal that has a single
+       alternative is entered on any token, like a hand-written function
+       that starts by matching */
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        int nt = g->nonterminals[i];
+        const Symbol *s = &g->symbols[nt];
+        if (g->fallback[nt] != 0 || s->error_message != NULL || s->error_hook != NULL)
+        {
+            continue;
+        }
+        int only = 0;
+        for (int p = 1; p <= g->production_count; p++)
+        {
+            if (g->productions[p].lhs == nt)
+            {
+                only = only == 0 ? p : -1;
+            }
+        }
+        if (only > 0)
+        {
+            g->fallback[nt] = only;
+        }
+    }
+}
+
+static int item_arity(Grammar *g, const Item *item);
+
+static int symbol_arity(Grammar *g, int nt)
+{
+    Symbol *s = &g->symbols[nt];
+    if (s->arity >= 0)
+    {
+        return s->arity;
+    }
+    if (s->arity == -2)
+    {
+        fatal(NULL, "cannot count the values of", s->name);
+    }
+    s->arity = -2;
+
+    int arity = -1;
+    for (int i = 1; i <= g->production_count; i++)
+    {
+        Production *p = &g->productions[i];
+        if (p->lhs != nt)
+        {
+            continue;
+        }
+        int count = 0;
+        if (p->action >= 0)
+        {
+            count = 1;
+        }
+        else
+        {
+            for (int j = 0; j < p->length; j++)
+            {
+                count += item_arity(g, &p->rhs[j]);
+            }
+        }
+        if (arity >= 0 && count != arity)
+        {
+            fprintf(stderr, "ll1gen: line %d: ", p->line);
+            fatal(NULL, "alternatives leave different numbers of values in", s->name);
+        }
+        arity = count;
+    }
+    s->arity = arity;
+    return arity;
+}
+
+static int item_arity(Grammar *g, const Item *item)
+{
+    switch (item->kind)
+    {
+    case ITEM_TOKEN:
+        return 0;
+    case ITEM_NONTERMINAL:
+        return symbol_arity(g, item->symbol);
+    default:
+        return 1;
+    }
+}
+
+static void check_arity(Grammar *g)
+{
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        symbol_arity(g, g->nonterminals[i]);
+    }
+    for (int i = 1; i <= g->production_count; i++)
+    {
+        const Production *p = &g->productions[i];
+        for (int j = 0; j < p->length; j++)
+        {
+            if (p->rhs[j].kind == ITEM_LIST && symbol_arity(g, p->rhs[j].symbol) != 1)
+            {
+                fatal(NULL, "a list item must leave one value", g->symbols[p->rhs[j].symbol].name);
+            }
+        }
+    }
+}
+
+/* classOrImplOrFunc -> CLASS_OR_IMPL_OR_FUNC */
+static void constant_name(char *out, const char *prefix, const char *name)
+{
+    out += sprintf(out, "%s", prefix);
+    for (const char *p = name; *p != '\0'; p++)
+    {
+        if (isupper((unsigned char)*p) && p != name && !isupper((unsigned char)p[-1]))
+        {
+            *out++ = '_';
+        }
+        *out++ = (char)toupper((unsigned char)*p);
+    }
+    *out = '\0';
+}
+
+static void write_set(FILE *out, const Grammar *g, const unsigned char *set)
+{
+    for (int t = 0; t < g->symbol_count; t++)
+    {
+        if (set[t])
+        {
+            fprintf(out, " %s", t == 0 ? "$end" : g->symbols[t].name);
+        }
+    }
+}
+
+static void write_item(FILE *out, const Grammar *g, const Item *item)
+{
+    char name[300];
+    const char *symbol = g->symbols[item->symbol].name;
+    switch (item->kind)
+    {
+    case ITEM_TOKEN:
+        fprintf(out, "LL1_TOKEN | %s", symbol);
+        break;
+    case ITEM_CAPTURE:
+        fprintf(out, "LL1_CAPTURE | %s", symbol);
+        break;
+    case ITEM_NONTERMINAL:
+        constant_name(name, "NT_", symbol);
+        fprintf(out, "LL1_NONTERMINAL | %s", name);
+        break;
+    case ITEM_EXTERN:
+        constant_name(name, "EXTERN_", symbol);
+        fprintf(out, "LL1_EXTERN | %s", name);
+        break;
+    case ITEM_LIST:
+        constant_name(name, "NT_", symbol);
+        fprintf(out, "LL1_LIST | %s", name);
+        break;
+    }
+}
+
+static void write_production_comment(FILE *out, const Grammar *g, const Production *p)
+{
+    fprintf(out, "%s:", g->symbols[p->lhs].name);
+    for (int j = 0; j < p->length; j++)
+    {
+        const Item *item = &p->rhs[j];
+        const char *symbol = g->symbols[item->symbol].name;
+        if (item->kind == ITEM_LIST)
+        {
+            fprintf(out, " { %s }", symbol);
+        }
+        else
+        {
+            fprintf(out, " %s%s", symbol, item->kind == ITEM_CAPTURE ? "@" : "");
+        }
+    }
+    if (p->action >= 0)
+    {
+        fprintf(out, " #%s", g->actions[p->action]);
+    }
+}
+
+static void write_tables(const Grammar *g, const char *grammar_path, FILE *out)
+{
+    char name[300];
+
+    fprintf(out, "/* Generated by ll1gen from %s; do not edit */\n\n", grammar_path);
+    fprintf(out, "#ifndef LL1_TABLES_H\n#define LL1_TABLES_H\n\n#include \"ll1.h\"\n\n");
+
+    fprintf(out, "enum\n{\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        constant_name(name, "NT_", g->symbols[g->nonterminals[i]].name);
+        fprintf(out, "    %s,\n", name);
+    }
+    fprintf(out, "    LL1_NONTERMINAL_COUNT\n};\n\n");
+    constant_name(name, "NT_", g->symbols[g->nonterminals[0]].name);
+    fprintf(out, "#define LL1_START %s\n\n", name);
+
+    fprintf(out, "enum\n{\n");
+    for (int i = 0; i < g->extern_count; i++)
+    {
+        constant_name(name, "EXTERN_", g->symbols[g->externs[i]].name);
+        fprintf(out, "    %s,\n", name);
+    }
+    fprintf(out, "    LL1_EXTERN_COUNT\n};\n\n");
+
+    fprintf(out, "/* FIRST and FOLLOW sets\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        fprintf(out, "   %s%s\n     FIRST:", s->name, s->nullable ? " (nullable)" : "");
+        write_set(out, g, s->first);
+        fprintf(out, "\n     FOLLOW:");
+        write_set(out, g, s->follow);
+        fprintf(out, "\n");
+    }
+    fprintf(out, " */\n\n");
+
+    for (int i = 0; i < g->extern_count; i++)
+    {
+        fprintf(out, "struct ASTNode *%s(CompileContext *ctx);\n", g->symbols[g->externs[i]].function);
+    }
+    for (int i = 0; i < g->action_count; i++)
+    {
+        fprintf(out, "static struct ASTNode *reduce_%s(CompileContext *ctx, const LLValue *values, unsigned int start);\n",
+                g->actions[i]);
+    }
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        if (s->error_hook != NULL)
+        {
+            fprintf(out, "static void %s(CompileContext *ctx);\n", s->error_hook);
+        }
+    }
+
+    fprintf(out, "\nstatic const LLExtern ll1_externs[LL1_EXTERN_COUNT] = {\n");
+    for (int i = 0; i < g->extern_count; i++)
+    {
+        fprintf(out, "    %s,\n", g->symbols[g->externs[i]].function);
+    }
+    fprintf(out, "};\n\n/* Indexed by LLProduction.action */\nstatic const LLAction ll1_actions[] = {\n    NULL,\n");
+    for (int i = 0; i < g->action_count; i++)
+    {
+        fprintf(out, "    reduce_%s,\n", g->actions[i]);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const char *const ll1_error_messages[LL1_NONTERMINAL_COUNT] = {\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        if (s->error_message != NULL)
+        {
+            constant_name(name, "NT_", s->name);
+            fprintf(out, "    [%s] = \"%s\",\n", name, s->error_message);
+        }
+    }
+    fprintf(out, "};\n\nstatic const LLErrorHook ll1_error_hooks[LL1_NONTERMINAL_COUNT] = {\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        if (s->error_hook != NULL)
+        {
+            constant_name(name, "NT_", s->name);
+            fprintf(out, "    [%s] = %s,\n", name, s->error_hook);
+        }
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* List items error recovery may resume at */\n");
+    fprintf(out, "static const unsigned char ll1_sync[LL1_NONTERMINAL_COUNT] = {\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        if (s->sync)
+        {
+            constant_name(name, "NT_", s->name);
+            fprintf(out, "    [%s] = 1,\n", name);
+        }
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Values each nonterminal leaves on the stack */\n");
+    fprintf(out, "static const unsigned char ll1_arity[LL1_NONTERMINAL_COUNT] = {\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        const Symbol *s = &g->symbols[g->nonterminals[i]];
+        constant_name(name, "NT_", s->name);
+        fprintf(out, "    [%s] = %d,\n", name, s->arity);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const unsigned short ll1_rhs[] = {\n");
+    int offset = 0;
+    for (int i = 1; i <= g->production_count; i++)
+    {
+        const Production *p = &g->productions[i];
+        fprintf(out, "    /* %d ", i);
+        write_production_comment(out, g, p);
+        fprintf(out, " */\n");
+        for (int j = 0; j < p->length; j++)
+        {
+            fprintf(out, "    ");
+            write_item(out, g, &p->rhs[j]);
+            fprintf(out, ",\n");
+        }
+        offset += p->length;
+    }
+    if (offset == 0)
+    {
+        fprintf(out, "    0\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Production 0 stands for no prediction */\n");
+    fprintf(out, "static const LLProduction ll1_productions[] = {\n    {0, 0, 0},\n");
+    offset = 0;
+    for (int i = 1; i <= g->production_count; i++)
+    {
+        const Production *p = &g->productions[i];
+        fprintf(out, "    {%d, %d, %d},\n", offset, p->length, p->action + 1);
+        offset += p->length;
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "/* Production entered on a token the table does not predict */\n");
+    fprintf(out, "static const unsigned char ll1_fallback[LL1_NONTERMINAL_COUNT] = {\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        int nt = g->nonterminals[i];
+        if (g->fallback[nt] != 0)
+        {
+            constant_name(name, "NT_", g->symbols[nt].name);
+            fprintf(out, "    [%s] = %d,\n", name, g->fallback[nt]);
+        }
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const unsigned char ll1_predict[LL1_NONTERMINAL_COUNT][LAST_KEYWORD + 1] = {\n");
+    for (int i = 0; i < g->nonterminal_count; i++)
+    {
+        int nt = g->nonterminals[i];
+        constant_name(name, "NT_", g->symbols[nt].name);
+        fprintf(out, "    [%s] = {", name);
+        const char *separator = "";
+        for (int t = 1; t < g->symbol_count; t++)
+        {
+            if (g->predict[nt][t] != 0)
+            {
+                fprintf(out, "%s[%s] = %d", separator, g->symbols[t].name, g->predict[nt][t]);
+                separator = ", ";
+            }
+        }
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n\n#endif\n");
+}
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = (char *)malloc((size_t)size + 1);
+    if (fread(text, 1, (size_t)size, file) != (size_t)size)
+    {
+        perror(path);
+        exit(1);
+    }
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s grammar.ll1 ll1_tables.h\n", argv[0]);
+        return 2;
+    }
+
+    static Grammar g;
+    Lexer lex = {argv[1], read_file(argv[1]), 1, TOK_END, ""};
+    parse_grammar(&g, &lex);
+    compute_sets(&g);
+    build_predictions(&g);
+    check_arity(&g);
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    write_tables(&g, argv[1], out);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include <float.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Conversion of the lexer's {integer} and {float_num} matches. Both run
+   once, at lex time, over text that the rules have already validated, and
+   return nonzero when the literal does not fit its type. */
+
+static inline int parse_int_literal(const char *text, int length, int *value)
+{
+    unsigned long long result = 0;
+    for (int i = 0; i < length; i++)
+    {
+        result = result * 10 + (unsigned)(text[i] - '0');
+        if (result > INT_MAX)
+        {
+            return 1;
+        }
+    }
+    *value = (int)result;
+    return 0;
+}
+
+/* Powers of ten that a double holds exactly */
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/* Correctly rounded double, then narrowed like the old atof call. When the
+   digits fit in 53 bits and the scale is an exact power of ten, one multiply
+   or divide gives the exact rounding; everything else goes to strtod. */
+static inline int parse_float_literal(const char *text, int length, float *value)
+{
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+    int i = 0;
+
+    for (; i < length && text[i] != '.'; i++)
+    {
+        mantissa = mantissa * 10 + (unsigned)(text[i] - '0');
+        digits += mantissa != 0;
+    }
+    for (i++; i < length && text[i] != 'e' && text[i] != 'E'; i++)
+    {
+        mantissa = mantissa * 10 + (unsigned)(text[i] - '0');
+        digits += mantissa != 0;
+        scale--;
+    }
+    if (i < length)
+    {
+        int negative = text[++i] == '-';
+        int exponent = 0;
+        for (i += text[i] == '-' || text[i] == '+'; i < length && exponent < 100000; i++)
+        {
+            exponent = exponent * 10 + (text[i] - '0');
+        }
+        scale += negative ? -exponent : exponent;
+    }
+
+    double result;
+    if (digits <= 15 && scale >= -22 && scale <= 22)
+    {
+        result = (double)mantissa;
+        result = scale < 0 ? result / exact_powers_of_ten[-scale] : result * exact_powers_of_ten[scale];
+    }
+    else
+    {
+        char buffer[128];
+        char *copy = length < (int)sizeof(buffer) ? buffer : (char *)malloc(length + 1);
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+        result = strtod(copy, NULL);
+        if (copy != buffer)
+        {
+            free(copy);
+        }
+    }
+
+    /* digits counts from the first nonzero digit, so it is zero only for 0.0 */
+    if (result > FLT_MAX || (digits > 0 && (float)result == 0.0f))
+    {
+        return 1;
+    }
+    *value = (float)result;
+    return 0;
+}
+
+#endif
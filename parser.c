@@ -1,1269 +1,2447 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 #include "tokens.h"
 
 #include "ast.h"
 #include "symbol_table.h"
 #include "semantic.h"
+#include "compact_ast.h"
 #include "error_logger.h"
+#include "token_trace.h"
+#include "source.h"
+#include "token_buffer.h"
+#include "fast_lexer.h"
+#include "compile_context.h"
+#include "token_ring.h"
+#include "snapshot.h"
+#include "ast_stats.h"
+#include "ll1_tables.h"
+
+typedef enum
+{
+    LEXER_FLEX,
+    LEXER_FAST,
+    LEXER_PARALLEL
+} LexerEngine;
 
-extern int yylex();
-extern char *yytext;
-extern int yylineno;
-extern FILE *yyin;
-extern int error_count;
-
-int lookahead;
-char current_lexeme[100];
-
-void match(int expected);
-void advance();
-void error(const char *msg);
-
-struct ASTNode *parse_prog();
-struct ASTNode *parse_classOrImplOrFuncList();
-struct ASTNode *parse_classOrImplOrFunc();
-
-struct ASTNode *parse_classDecl();
-struct ASTNode *parse_isaOpt();
-struct ASTNode *parse_inheritanceList();
-struct ASTNode *parse_visibilityMemberDeclList();
-struct ASTNode *parse_visibility();
-struct ASTNode *parse_memberDeclList();
-struct ASTNode *parse_memberDecl();
-struct ASTNode *parse_funcDecl();
-struct ASTNode *parse_attributeDecl();
-
-struct ASTNode *parse_implDef();
-struct ASTNode *parse_funcDefList();
-
-struct ASTNode *parse_funcDef();
-struct ASTNode *parse_funcHead();
-struct ASTNode *parse_returnType();
-struct ASTNode *parse_type();
-struct ASTNode *parse_funcBody();
-struct ASTNode *parse_VarDeclOrStmtList();
-struct ASTNode *parse_VarDeclOrStmt();
-struct ASTNode *parse_localVarDecl();
-struct ASTNode *parse_varDecl();
-struct ASTNode *parse_arraySizeList();
-struct ASTNode *parse_arraySize();
-
-struct ASTNode *parse_statement();
-struct ASTNode *parse_assignStat();
-struct ASTNode *parse_statBlock();
-struct ASTNode *parse_statementList();
-
-struct ASTNode *parse_expr();
-struct ASTNode *parse_exprRest(struct ASTNode *left_arith);
-void parse_relOp();
+typedef struct CompileOptions
+{
+    int use_mmap;
+    int pipeline;
+    LexerEngine lexer;
+    int lex_jobs;
+    int parse_jobs;
+    int show_time;
+    int verbose;
+    TraceMode trace_mode;
+    const char *trace_path;
+    int ast_cache;
+    const char *ast_cache_dir; /* NULL keeps snapshots next to their sources */
+    int stream;
+    int share_exprs; /* build repeated expressions once; see compact_ast_build_shared */
+    int stats;       /* metrics, name uses and lint, in the first pass's walk */
+    int time_hooks;  /* cost of each hook of that walk */
+} CompileOptions;
+
+/* Tokens buffered between the lexer thread and the parser */
+#define PIPELINE_RING_SIZE 4096
+
+/* A flex scanner running on its own thread, feeding the parser through a
+   ring. It has its own context so the two threads never share counters. */
+typedef struct Pipeline
+{
+    CompileContext lex_ctx;
+    TokenRing ring;
+    pthread_t thread;
+    int token_count;
+} Pipeline;
+
+/* Files waiting to be compiled; each worker claims the next one under lock */
+typedef struct CompileQueue
+{
+    char **paths;
+    int count;
+    int next;
+    int failures;
+    const CompileOptions *options;
+    pthread_mutex_t lock;
+} CompileQueue;
+
+void match(CompileContext *ctx, int expected);
+void advance(CompileContext *ctx);
+void error(CompileContext *ctx, const char *msg);
+
+struct ASTNode *parse_prog(CompileContext *ctx);
+struct ASTNode *parse_prog_parallel(CompileContext *ctx, int jobs);
+struct ASTNode *parse_top_level_decl(CompileContext *ctx);
+struct ASTNode *parse_assignOrCall(CompileContext *ctx);
+
+struct ASTNode *parse_expr(CompileContext *ctx);
+struct ASTNode *parse_arithExpr(CompileContext *ctx);
+struct ASTNode *parse_binary(CompileContext *ctx, int min_prec);
+
+struct ASTNode *parse_factor(CompileContext *ctx);
+struct ASTNode *parse_sign(CompileContext *ctx);
+
+struct ASTNode *parse_variable(CompileContext *ctx);
+struct ASTNode *parse_idnestList(CompileContext *ctx);
+struct ASTNode *parse_indiceList(CompileContext *ctx);
+struct ASTNode *parse_indice(CompileContext *ctx);
+
+struct ASTNode *parse_functionCall(CompileContext *ctx);
+struct ASTNode *parse_idOrSelf(CompileContext *ctx);
+
+struct ASTNode *parse_aParams(CompileContext *ctx);
+struct ASTNode *parse_aParamsTailList(CompileContext *ctx);
+struct ASTNode *parse_aParamsTail(CompileContext *ctx);
+
+/* Takes the next token off the pipeline ring; the end-of-input token is
+   never popped, so the lexer thread's last push is always observable */
+static void advance_ring(CompileContext *ctx)
+{
+    if (ctx->cursor >= 0 && ctx->lookahead == 0)
+    {
+        return;
+    }
+    const TokenRecord *next = token_ring_peek(ctx->ring, 0);
+    ctx->cursor++;
+    ctx->lookahead = next->kind;
+    ctx->current_token.text = ctx->ring->text + next->start;
+    ctx->current_token.offset = (int)next->start;
+    ctx->current_token.length = (int)next->len;
+    ctx->current_token.value = next->value;
+    if (next->kind != 0)
+    {
+        token_ring_pop(ctx->ring);
+    }
+}
 
-struct ASTNode *parse_arithExpr();
-struct ASTNode *parse_arithExprPrime(struct ASTNode *left_term);
-void parse_addOp();
+void advance(CompileContext *ctx)
+{
+    if (ctx->ring != NULL)
+    {
+        advance_ring(ctx);
+        return;
+    }
 
-struct ASTNode *parse_term();
-struct ASTNode *parse_termPrime(struct ASTNode *left_factor);
-void parse_multOp();
+    TokenBuffer *tokens = &ctx->tokens;
+    if (ctx->cursor < tokens->count - 1)
+    {
+        ctx->cursor++;
+    }
+    ctx->lookahead = tokens->kind[ctx->cursor];
+    ctx->current_token = token_view_at(tokens, ctx->cursor);
+}
 
-struct ASTNode *parse_factor();
-struct ASTNode *parse_sign();
+/* The current lexeme as an interned string, shared by every node naming it */
+static const char *lexeme_intern(CompileContext *ctx)
+{
+    if (ctx->shared_strings != NULL)
+    {
+        return intern_cached(&ctx->strings, ctx->shared_strings, ctx->current_token.text, ctx->current_token.length);
+    }
+    return intern(&ctx->strings, ctx->current_token.text, ctx->current_token.length);
+}
 
-struct ASTNode *parse_variable();
-struct ASTNode *parse_idnestList();
-struct ASTNode *parse_indiceList();
-struct ASTNode *parse_indice();
+/* Lists are built with a loop that links each item at tail, so long lists
+   take no stack per element. A missing item ends the list. */
+static int list_append(struct ASTNode ***tail, struct ASTNode *item)
+{
+    **tail = item;
+    if (item == NULL)
+    {
+        return 0;
+    }
+    *tail = &item->next;
+    return 1;
+}
 
-struct ASTNode *parse_functionCall();
-struct ASTNode *parse_idOrSelf();
+/* Syntax errors of a parse worker, held until the main thread reaches
+   them in source order */
+typedef struct SyntaxLog
+{
+    char *text;
+    int length;
+    int capacity;
+} SyntaxLog;
 
-struct ASTNode *parse_fParams();
-struct ASTNode *parse_fParamsTailList();
-struct ASTNode *parse_fParamsTail();
+#define SYNTAX_ERROR_FORMAT "Syntax error at line %d: %s. Found token: %d (%.*s)\n"
 
-struct ASTNode *parse_aParams();
-struct ASTNode *parse_aParamsTailList();
-struct ASTNode *parse_aParamsTail();
+/* Tokens that must match after a recovery before another error is
+   reported; errors in between are most likely caused by the first one */
+#define SYNTAX_QUIET_TOKENS 3
 
-void advance()
+/* Reports the error and leaves the parser in panic mode, in which further
+   errors go unreported until the driver has skipped to a point it can
+   resume at */
+void error(CompileContext *ctx, const char *msg)
 {
-    lookahead = yylex();
-    if (lookahead != 0)
+    ctx->errors_seen++;
+    if (ctx->panic)
     {
-        strcpy(current_lexeme, yytext);
+        return;
     }
+    ctx->panic = 1;
+    if (ctx->error_quiet > 0)
+    {
+        return;
+    }
+    ctx->error_quiet = SYNTAX_QUIET_TOKENS;
+
+    int line = line_index_line(ctx->lines, (unsigned int)ctx->current_token.offset);
+    SyntaxLog *log = ctx->syntax_log;
+    if (log == NULL)
+    {
+        fprintf(stderr, SYNTAX_ERROR_FORMAT, line, msg, ctx->lookahead, ctx->current_token.length,
+                ctx->current_token.text);
+    }
+    else
+    {
+        int needed = snprintf(NULL, 0, SYNTAX_ERROR_FORMAT, line, msg, ctx->lookahead, ctx->current_token.length,
+                              ctx->current_token.text);
+        if (log->length + needed + 1 > log->capacity)
+        {
+            log->capacity = 2 * log->capacity + needed + 1;
+            log->text = (char *)realloc(log->text, log->capacity);
+        }
+        log->length += snprintf(log->text + log->length, needed + 1, SYNTAX_ERROR_FORMAT, line, msg, ctx->lookahead,
+                                ctx->current_token.length, ctx->current_token.text);
+    }
+    ctx->error_count++;
 }
 
-void error(const char *msg)
+/* Tokens recovery resynchronizes on */
+static int is_sync_token(int token)
 {
-    fprintf(stderr, "Syntax error at line %d: %s. Found token: %d (%s)\n", yylineno, msg, lookahead, current_lexeme);
-    error_count++;
+    return token == 0 || token == SEMICOLON || token == LBRACE || token == RBRACE || IS_KEYWORD_TOKEN(token);
 }
 
-void match(int expected)
+/* A mismatch consumes nothing. In panic mode a hand-written function may
+   still take the tokens it expects, but not one recovery stops at. */
+void match(CompileContext *ctx, int expected)
 {
-    if (lookahead == expected)
+    if (ctx->lookahead == expected && !(ctx->panic && is_sync_token(expected)))
     {
-        advance();
+        if (ctx->error_quiet > 0)
+        {
+            ctx->error_quiet--;
+        }
+        advance(ctx);
     }
-    else
+    else if (ctx->lookahead != expected)
     {
         char msg[100];
-        sprintf(msg, "expected %d, found %d", expected, lookahead);
-        error(msg);
-
-        advance();
+        sprintf(msg, "expected %d, found %d", expected, ctx->lookahead);
+        error(ctx, msg);
     }
 }
 
-int is_keyword_str(const char *word)
+/* Wall-clock milliseconds; CPU time would hide the parallel lexer's speedup */
+static double now_ms()
 {
-    char *keywords[] = {
-        "class", "isa", "implement", "public", "private", "attribute",
-        "func", "constructor", "void", "integer", "float", "local",
-        "if", "then", "else", "while", "read", "write", "return",
-        "self", "not", "or", "and", NULL};
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
 
-    for (int i = 0; keywords[i] != NULL; i++)
+/* Lexes the whole source with the chosen engine; -1 if no scanner could be made */
+static int lex_source(CompileContext *ctx, TokenBuffer *tokens, SourceBuffer *source, LexerEngine lexer,
+                      int lex_jobs)
+{
+    token_buffer_init(tokens, source->data, (int)(source->size / 4));
+    switch (lexer)
     {
-        if (strcmp(word, keywords[i]) == 0)
+    case LEXER_FAST:
+        return fast_lex_all(ctx, tokens, source->data, (int)source->size);
+    case LEXER_PARALLEL:
+        return fast_lex_parallel(ctx, tokens, source->data, (int)source->size, lex_jobs);
+    default:
+        if (lexer_init(ctx) != 0)
         {
-            return 1;
+            fprintf(stderr, "Error: Could not create scanner\n");
+            return -1;
         }
+        lexer_scan_memory(ctx, source->data, (int)source->size);
+        return lex_all(ctx, tokens);
     }
-    return 0;
 }
 
-int main(int argc, char *argv[])
+/* Diffs one engine's token stream and error count against the flex scanner's */
+static int compare_with_flex(SourceBuffer *source, const LineIndex *lines, const TokenBuffer *flex_tokens,
+                             int flex_errors, LexerEngine lexer, int lex_jobs, const char *name)
 {
-    if (argc < 2)
-    {
-        fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
-        return 1;
-    }
+    CompileContext ctx;
+    TokenBuffer tokens;
+
+    compile_context_init(&ctx);
+    ctx.lines = lines;
+    lex_source(&ctx, &tokens, source, lexer, lex_jobs);
 
-    FILE *input_file = fopen(argv[1], "r");
-    if (!input_file)
+    int differs = token_buffer_diff(flex_tokens, &tokens, stdout);
+    if (flex_errors != ctx.error_count)
     {
-        fprintf(stderr, "Error: Cannot open file %s\n", argv[1]);
-        return 1;
+        printf("Lexical error counts differ: flex %d, %s %d\n", flex_errors, name, ctx.error_count);
+        differs = 1;
     }
-    yyin = input_file;
-
-    printf("--- Starting Parse (Building AST) ---\n");
-    advance();
-    struct ASTNode *ast_root = parse_prog();
-
-    if (lookahead != 0)
+    if (!differs)
     {
-        error("Unexpected tokens at end of input");
+        printf("Lexer engines flex and %s agree on %d tokens\n", name, flex_tokens->count - 1);
     }
 
-    if (error_count > 0)
-    {
-        printf("\nTotal syntax errors found: %d. Semantic analysis aborted.\n", error_count);
-        fclose(input_file);
+    token_buffer_free(&tokens);
+    compile_context_free(&ctx);
+    return differs;
+}
+
+/* Runs every lexer engine over the same source and diffs their token streams */
+static int compare_lexers(SourceBuffer *source, int lex_jobs)
+{
+    CompileContext flex_ctx;
+    TokenBuffer flex_tokens;
+    LineIndex lines;
+
+    line_index_build(&lines, source->data, (int)source->size);
+    compile_context_init(&flex_ctx);
+    flex_ctx.lines = &lines;
+    if (lex_source(&flex_ctx, &flex_tokens, source, LEXER_FLEX, 0) < 0)
+    {
+        token_buffer_free(&flex_tokens);
+        compile_context_free(&flex_ctx);
+        line_index_free(&lines);
         return 1;
     }
 
-    printf("--- Parse successful. Starting Semantic Analysis... ---\n");
+    int differs = compare_with_flex(source, &lines, &flex_tokens, flex_ctx.error_count, LEXER_FAST, 0, "fast");
+    differs |= compare_with_flex(source, &lines, &flex_tokens, flex_ctx.error_count, LEXER_PARALLEL, lex_jobs,
+                                 "parallel");
 
-    SymbolTable *table = create_symbol_table();
+    token_buffer_free(&flex_tokens);
+    compile_context_free(&flex_ctx);
+    line_index_free(&lines);
+    return differs;
+}
 
-    printf("--- Running Pass 1: Building Symbol Table ---\n");
-    build_symbol_table_pass(ast_root, table);
+/* Edits --relex-diff makes, each to the text the one before left. Block
+   comment delimiters are among the insertions and the removals, so edits
+   open and close comments that reach far beyond them. */
+#define RELEX_EDITS 2000
+#define RELEX_MAX_REMOVED 8
+#define RELEX_MAX_INSERTED 8 /* no less than the longest of relex_insertions */
 
-    printf("--- Running Pass 2: Type Checking ---\n");
-    type_check_pass(ast_root, table);
+static const char *const relex_insertions[] = {"/*", "*/", "x", "abc1", " ", "\n", "42", "1.5e3", "\"", ";", "}",
+                                               "func", "// "};
+#define RELEX_INSERTION_COUNT (sizeof(relex_insertions) / sizeof(relex_insertions[0]))
 
-    print_symbol_table_to_file(table, "symbol_table.txt");
-    print_errors_to_file("semantic_errors.txt");
+/* Deterministic, so a failing edit can be found again */
+static unsigned int relex_random(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 16;
+}
 
-    int semantic_errors = get_semantic_error_count();
-    if (semantic_errors > 0)
+/* Offset of the first comment delimiter at or after from, wrapping around; -1 if there is none */
+static int find_delimiter(const char *text, int size, int from)
+{
+    for (int i = 0; i < size - 1; i++)
     {
-        printf("\nSemantic analysis found %d errors.\n", semantic_errors);
+        int p = (from + i) % (size - 1);
+        if ((text[p] == '/' && text[p + 1] == '*') || (text[p] == '*' && text[p + 1] == '/'))
+        {
+            return p;
+        }
     }
-    else
+    return -1;
+}
+
+/* Applies a series of edits to the source and checks that fast_relex
+   gives, after each, the tokens a full fast_lex_all of the edited text
+   does. Stops at the first difference. */
+static int compare_relex(SourceBuffer *source)
+{
+    int capacity = (int)source->size + RELEX_EDITS * RELEX_MAX_INSERTED + SOURCE_PADDING;
+    char *texts[2];
+    texts[0] = (char *)calloc(capacity, 1);
+    texts[1] = (char *)calloc(capacity, 1);
+    memcpy(texts[0], source->data, source->size);
+    int size = (int)source->size;
+
+    CompileContext ctx;
+    compile_context_init(&ctx);
+    ctx.lex_quiet = 1;
+    TokenBuffer old;
+    token_buffer_init(&old, texts[0], size / 4);
+    fast_lex_all(&ctx, &old, texts[0], size);
+
+    unsigned int state = 1;
+    int differs = 0;
+    for (int k = 0; k < RELEX_EDITS && !differs; k++)
+    {
+        const char *old_text = texts[k & 1];
+        char *text = texts[(k + 1) & 1];
+        TokenEdit edit;
+        const char *inserted = "";
+        edit.offset = size > 0 ? (int)(relex_random(&state) % (unsigned int)(size + 1)) : 0;
+        edit.removed = 0;
+        switch (relex_random(&state) % 3)
+        {
+        case 0:
+            inserted = relex_insertions[relex_random(&state) % RELEX_INSERTION_COUNT];
+            break;
+        case 1:
+        {
+            int delimiter = find_delimiter(old_text, size, edit.offset);
+            if (delimiter >= 0)
+            {
+                edit.offset = delimiter;
+                edit.removed = 2;
+            }
+            else
+            {
+                inserted = "/*";
+            }
+            break;
+        }
+        default:
+            edit.removed = 1 + (int)(relex_random(&state) % RELEX_MAX_REMOVED);
+            if (edit.removed > size - edit.offset)
+            {
+                edit.removed = size - edit.offset;
+            }
+            break;
+        }
+        edit.inserted = (int)strlen(inserted);
+
+        memcpy(text, old_text, edit.offset);
+        memcpy(text + edit.offset, inserted, edit.inserted);
+        memcpy(text + edit.offset + edit.inserted, old_text + edit.offset + edit.removed,
+               size - edit.offset - edit.removed);
+        size += edit.inserted - edit.removed;
+        memset(text + size, 0, SOURCE_PADDING);
+
+        TokenBuffer relexed;
+        TokenBuffer full;
+        TokenRange changed;
+        token_buffer_init(&relexed, text, old.count + 16);
+        fast_relex(&ctx, &old, &edit, text, size, &relexed, &changed);
+        token_buffer_init(&full, text, old.count + 16);
+        fast_lex_all(&ctx, &full, text, size);
+
+        differs = token_buffer_diff(&full, &relexed, stdout);
+        if (differs)
+        {
+            printf("Relexing differs from a full lex after edit %d: %d bytes at offset %d replaced by \"%s\"\n",
+                   k + 1, edit.removed, edit.offset, inserted);
+        }
+        token_buffer_free(&relexed);
+        token_buffer_free(&old);
+        old = full;
+    }
+    if (!differs)
     {
-        printf("\nSemantic analysis completed with no errors.\n");
+        printf("Relexing agrees with a full lex after each of %d edits\n", RELEX_EDITS);
     }
 
-    fclose(input_file);
-
-    free_symbol_table(table);
-
-    return (semantic_errors > 0 || error_count > 0) ? 1 : 0;
+    token_buffer_free(&old);
+    compile_context_free(&ctx);
+    free(texts[0]);
+    free(texts[1]);
+    return differs;
 }
 
-struct ASTNode *parse_prog()
+static void *lexer_thread_main(void *arg)
 {
-
-    struct ASTNode *list = parse_classOrImplOrFuncList();
-
-    return create_node(NODE_PROG, list, NULL);
+    Pipeline *pipeline = (Pipeline *)arg;
+    pipeline->token_count = lex_to_ring(&pipeline->lex_ctx, &pipeline->ring);
+    return NULL;
 }
 
-struct ASTNode *parse_classOrImplOrFuncList()
+/* Starts lexing source on a new thread and points ctx's parser at the ring */
+static int pipeline_start(Pipeline *pipeline, CompileContext *ctx, SourceBuffer *source)
 {
-    if (lookahead == KEYWORD &&
-        (strcmp(current_lexeme, "class") == 0 ||
-         strcmp(current_lexeme, "implement") == 0 ||
-         strcmp(current_lexeme, "func") == 0 ||
-         strcmp(current_lexeme, "constructor") == 0))
+    compile_context_init(&pipeline->lex_ctx);
+    pipeline->lex_ctx.lines = ctx->lines;
+    if (lexer_init(&pipeline->lex_ctx) != 0)
     {
-
-        struct ASTNode *head = parse_classOrImplOrFunc();
-        if (head)
-        {
-            head->next = parse_classOrImplOrFuncList();
-        }
-        return head;
+        fprintf(stderr, "Error: Could not create scanner\n");
+        return 1;
     }
-    else
+    lexer_scan_memory(&pipeline->lex_ctx, source->data, (int)source->size);
+    token_ring_init(&pipeline->ring, source->data, PIPELINE_RING_SIZE);
+    pipeline->token_count = 0;
+    pipeline->lex_ctx.trace = ctx->trace;
+    pipeline->lex_ctx.lex_quiet = ctx->lex_quiet;
+
+    if (pthread_create(&pipeline->thread, NULL, lexer_thread_main, pipeline) != 0)
     {
+        fprintf(stderr, "Error: Could not start lexer thread\n");
+        pipeline->lex_ctx.trace = NULL;
+        token_ring_free(&pipeline->ring);
+        compile_context_free(&pipeline->lex_ctx);
+        return 1;
+    }
+    ctx->trace = NULL;
+    ctx->ring = &pipeline->ring;
+    return 0;
+}
 
-        return NULL;
+/* Lets the lexer run to the end of input, then folds its errors into ctx */
+static int pipeline_finish(Pipeline *pipeline, CompileContext *ctx)
+{
+    while (ctx->lookahead != 0)
+    {
+        advance(ctx);
     }
+    pthread_join(pipeline->thread, NULL);
+
+    ctx->ring = NULL;
+    ctx->error_count += pipeline->lex_ctx.error_count;
+    token_ring_free(&pipeline->ring);
+    compile_context_free(&pipeline->lex_ctx);
+    return pipeline->token_count;
 }
 
-struct ASTNode *parse_classOrImplOrFunc()
+/* Lexes and parses source into tree; lines and the rest of ctx are set up
+   here. Returns the number of syntax errors, whose constructs the tree
+   holds as error nodes, or -1, with the error reported, when there is no
+   tree. */
+static int parse_source(const char *label, const CompileOptions *options, CompileContext *ctx,
+                        SourceBuffer *source, LineIndex *lines, CompactAst *tree)
 {
-    if (lookahead == KEYWORD)
+    line_index_build(lines, source->data, (int)source->size);
+    ctx->lines = lines;
+    if (options->trace_mode != TRACE_OFF)
     {
-        if (strcmp(current_lexeme, "class") == 0)
+        ctx->trace = trace_open(options->trace_mode, options->trace_path);
+        if (ctx->trace == NULL)
         {
-            return parse_classDecl();
+            line_index_free(lines);
+            return -1;
         }
-        else if (strcmp(current_lexeme, "implement") == 0)
+    }
+
+    Pipeline pipeline;
+    int token_count = 0;
+    double lex_ms = 0.0;
+    if (options->pipeline)
+    {
+        if (pipeline_start(&pipeline, ctx, source) != 0)
         {
-            return parse_implDef();
+            line_index_free(lines);
+            return -1;
         }
-        else if (strcmp(current_lexeme, "func") == 0 || strcmp(current_lexeme, "constructor") == 0)
+    }
+    else
+    {
+        double lex_start = now_ms();
+        token_count = lex_source(ctx, &ctx->tokens, source, options->lexer, options->lex_jobs);
+        lex_ms = now_ms() - lex_start;
+        trace_close(ctx->trace);
+        ctx->trace = NULL;
+        if (token_count < 0)
         {
-            return parse_funcDef();
+            line_index_free(lines);
+            return -1;
         }
     }
 
-    error("Expected class, implement, or func");
-    return NULL;
-}
-
-struct ASTNode *parse_classDecl()
-{
+    if (options->verbose)
+    {
+        printf("--- Starting Parse (Building AST) ---\n");
+    }
+    double parse_start = now_ms();
+    advance(ctx);
+    struct ASTNode *ast_root = options->parse_jobs > 1 ? parse_prog_parallel(ctx, options->parse_jobs)
+                                                       : parse_prog(ctx);
 
-    match(KEYWORD);
-    char *id = strdup(current_lexeme);
-    match(IDENTIFIER);
-    struct ASTNode *isa = parse_isaOpt();
-    struct ASTNode *inherit = parse_inheritanceList();
-    match(LBRACE);
-    struct ASTNode *members = parse_visibilityMemberDeclList();
-    match(RBRACE);
+    if (ctx->lookahead != 0)
+    {
+        error(ctx, "Unexpected tokens at end of input");
+    }
+    if (options->pipeline)
+    {
+        token_count = pipeline_finish(&pipeline, ctx);
+    }
+    double parse_ms = now_ms() - parse_start;
 
-    return create_class_decl(id, isa, inherit, members);
-}
+    if (options->show_time && options->pipeline)
+    {
+        printf("%sLexing and parsing (pipelined): %.3f ms (%d tokens)\n", label, parse_ms, token_count);
+    }
+    else if (options->show_time)
+    {
+        printf("%sLexing: %.3f ms (%d tokens), Parsing: %.3f ms\n", label, lex_ms, token_count, parse_ms);
+    }
+    if (options->show_time)
+    {
+        printf("%sAST arena: %d nodes, %.1f KB used of %.1f KB in %d blocks\n", label,
+               ctx->ast.allocations, ctx->ast.used / 1024.0, ctx->ast.reserved / 1024.0, ctx->ast.blocks);
+    }
 
-struct ASTNode *parse_isaOpt()
-{
-    if (lookahead == KEYWORD && strcmp(current_lexeme, "isa") == 0)
+    if (ctx->error_count > 0)
+    {
+        printf("\n%sTotal syntax errors found: %d. Semantic analysis skips the functions they are in.\n",
+               label, ctx->error_count);
+    }
+    else if (options->verbose)
     {
+        printf("--- Parse successful. Starting Semantic Analysis... ---\n");
+    }
 
-        match(KEYWORD);
-        struct ASTNode *id_node = create_id_node(current_lexeme);
-        match(IDENTIFIER);
-        struct ASTNode *inherit = parse_inheritanceList();
-        id_node->next = inherit;
-        return id_node;
+    /* The passes read the index form; the pointer tree is released */
+    double build_start = now_ms();
+    if (options->share_exprs)
+    {
+        compact_ast_build_shared(tree, ast_root, lines);
     }
     else
     {
-
-        return NULL;
+        compact_ast_build(tree, ast_root);
     }
+    if (options->show_time)
+    {
+        printf("%sCompact AST: %d nodes, %.1f KB (pointer AST %.1f KB), built in %.3f ms\n", label,
+               tree->count - 1, compact_ast_bytes(tree) / 1024.0, ctx->ast.used / 1024.0, now_ms() - build_start);
+    }
+    if (options->show_time && options->share_exprs)
+    {
+        printf("%sShared expressions: %d uses reuse an identical node\n", label, tree->shared);
+    }
+    arena_free(&ctx->ast);
+    return ctx->error_count;
 }
 
-struct ASTNode *parse_inheritanceList()
+/* State of a streaming compilation between its two passes over the file */
+typedef struct StreamState
+{
+    SymbolTable *table;
+    const LineIndex *lines;
+    unsigned char *redeclared; /* per top-level function, from the first pass */
+    int function_count;
+    int function_capacity;
+    int next;
+    ErrorLog declare_errors;
+    ErrorLog build_errors;
+    ErrorLog check_errors;
+    FILE *spills[2]; /* build and check errors, in the order they are written */
+    ScopeSpill scopes;
+    int share_exprs;
+} StreamState;
+
+typedef void (*StreamVisit)(StreamState *state, CompactAst *tree);
+
+/* Lexes and parses the whole file, one top-level declaration at a time,
+   handing each function definition to visit before its tree is freed.
+   Returns the syntax error count. */
+static int stream_functions(CompileContext *ctx, SourceBuffer *source, StreamVisit visit, StreamState *state)
 {
-    if (lookahead == COMMA)
+    Pipeline pipeline;
+    if (pipeline_start(&pipeline, ctx, source) != 0)
     {
-
-        match(COMMA);
-        struct ASTNode *head = create_id_node(current_lexeme);
-        match(IDENTIFIER);
-        head->next = parse_inheritanceList();
-        return head;
+        return -1;
     }
-    else
+
+    ctx->cursor = -1;
+    advance(ctx);
+    struct ASTNode *item;
+    while ((item = parse_top_level_decl(ctx)) != NULL)
     {
+        if (item->type == NODE_FUNC_DEF)
+        {
+            CompactAst tree;
+            if (state->share_exprs)
+            {
+                compact_ast_build_shared(&tree, item, state->lines);
+            }
+            else
+            {
+                compact_ast_build(&tree, item);
+            }
+            visit(state, &tree);
+            compact_ast_free(&tree);
+        }
+        arena_free(&ctx->ast);
+        arena_init(&ctx->ast);
+    }
 
-        return NULL;
+    if (ctx->lookahead != 0)
+    {
+        error(ctx, "Unexpected tokens at end of input");
     }
+    pipeline_finish(&pipeline, ctx);
+    return ctx->error_count;
 }
 
-struct ASTNode *parse_visibilityMemberDeclList()
+/* First pass: every function is declared before any body is checked. Only
+   whether a declaration failed is kept; the error itself is reported
+   again, in its place, by the second pass. */
+static void stream_declare(StreamState *state, CompactAst *tree)
 {
-    if (lookahead == KEYWORD &&
-        (strcmp(current_lexeme, "public") == 0 || strcmp(current_lexeme, "private") == 0))
+    state->table->errors = &state->declare_errors;
+    declare_function(tree, tree->root, state->table);
+
+    if (state->function_count == state->function_capacity)
     {
+        state->function_capacity *= 2;
+        state->redeclared = (unsigned char *)realloc(state->redeclared, state->function_capacity);
+    }
+    state->redeclared[state->function_count++] = state->declare_errors.count > 0;
+    error_log_free(&state->declare_errors);
+}
 
-        struct ASTNode *visibility = parse_visibility();
-        struct ASTNode *members = parse_memberDeclList();
-        struct ASTNode *rest = parse_visibilityMemberDeclList();
+/* Second pass: both semantic passes over one function, whose scopes and
+   errors are then written out and freed. Errors of the first pass still
+   all come before those of the second. */
+static void stream_check(StreamState *state, CompactAst *tree)
+{
+    SymbolTable *table = state->table;
+    set_current_scope(table, table->global_scope);
+    table->errors = &state->build_errors;
+    if (state->redeclared[state->next++])
+    {
+        declare_function(tree, tree->root, table);
+    }
+    build_function_scope(tree, tree->root, table);
+    resolve_names_pass(tree, table);
 
-        struct ASTNode *head = parse_memberDeclList();
-        struct ASTNode *tail = parse_visibilityMemberDeclList();
+    table->errors = &state->check_errors;
+    type_check_pass(tree, tree->root, table);
 
-        if (head == NULL)
-            return tail;
-        struct ASTNode *current = head;
-        while (current->next != NULL)
-        {
-            current = current->next;
-        }
-        current->next = tail;
-        return head;
-    }
-    else
+    error_log_spill(&state->build_errors, state->lines, state->spills[0]);
+    error_log_spill(&state->check_errors, state->lines, state->spills[1]);
+    Scope *scope = tree->scopes[((AstFuncDef *)ast_record(tree, tree->root))->scope];
+    if (scope != NULL)
     {
-
-        return NULL;
+        spill_scope(table, scope, &state->scopes);
     }
 }
 
-struct ASTNode *parse_visibility()
+/* Compiles a file without ever holding all of its tree, scopes or error
+   messages: the first pass declares the functions, the second lexes and
+   parses the file again and checks one function at a time. What stays
+   is the function signatures, the interned names and the line starts. */
+static int compile_file_streaming(const char *input_path, const char *label, const CompileOptions *options,
+                                  const char *symbol_path, const char *error_path)
 {
-    if (lookahead == KEYWORD)
+    /* Mapped, so the text is paged in from the file rather than copied */
+    SourceBuffer source;
+    if (source_open(&source, input_path, 1) != 0)
+    {
+        fprintf(stderr, "Error: Cannot open file %s\n", input_path);
+        return 1;
+    }
+
+    LineIndex lines;
+    line_index_build(&lines, source.data, (int)source.size);
+
+    CompileContext ctx;
+    compile_context_init(&ctx);
+    ctx.lines = &lines;
+
+    StreamState state;
+    memset(&state, 0, sizeof(state));
+    state.table = create_symbol_table(&ctx.errors);
+    state.lines = &lines;
+    state.share_exprs = options->share_exprs;
+    state.function_capacity = 64;
+    state.redeclared = (unsigned char *)malloc(state.function_capacity);
+    error_log_init(&state.declare_errors);
+    error_log_init(&state.build_errors);
+    error_log_init(&state.check_errors);
+
+    int status = 1;
+    if (options->verbose)
     {
-        if (strcmp(current_lexeme, "public") == 0)
+        printf("--- Starting Parse (Building AST) ---\n");
+    }
+    double declare_start = now_ms();
+    int syntax_errors = stream_functions(&ctx, &source, stream_declare, &state);
+    double declare_ms = now_ms() - declare_start;
+    if (syntax_errors > 0)
+    {
+        printf("\n%sTotal syntax errors found: %d. Semantic analysis skips the functions they are in.\n",
+               label, syntax_errors);
+    }
+    if (syntax_errors >= 0)
+    {
+        state.spills[0] = tmpfile();
+        state.spills[1] = tmpfile();
+        int failed = state.spills[0] == NULL || state.spills[1] == NULL || scope_spill_init(&state.scopes) != 0;
+        if (failed)
         {
-            match(KEYWORD);
-            return create_visibility_node("public");
+            fprintf(stderr, "Error: Could not create temporary files\n");
         }
-        else if (strcmp(current_lexeme, "private") == 0)
+        else if (options->verbose)
         {
-            match(KEYWORD);
-            return create_visibility_node("private");
+            if (syntax_errors == 0)
+            {
+                printf("--- Parse successful. Starting Semantic Analysis... ---\n");
+            }
+            printf("--- Running Pass 1 and Pass 2 one function at a time ---\n");
         }
-    }
-    error("Expected public or private");
-    return NULL;
-}
 
-struct ASTNode *parse_memberDeclList()
-{
-    if (lookahead == KEYWORD && (strcmp(current_lexeme, "func") == 0 ||
-                                 strcmp(current_lexeme, "attribute") == 0 ||
-                                 strcmp(current_lexeme, "constructor") == 0))
-    {
+        /* The lexical and syntax errors were reported by the first pass */
+        SyntaxLog repeated = {NULL, 0, 0};
+        ctx.syntax_log = &repeated;
+        ctx.lex_quiet = 1;
+        double check_start = now_ms();
+        if (!failed)
+        {
+            failed = stream_functions(&ctx, &source, stream_check, &state) < 0;
+        }
+        ctx.syntax_log = NULL;
+        free(repeated.text);
+        if (!failed && options->show_time)
+        {
+            printf("%sStreaming: declaring %d functions: %.3f ms, checking: %.3f ms\n", label,
+                   state.function_count, declare_ms, now_ms() - check_start);
+        }
 
-        struct ASTNode *head = parse_memberDecl();
-        if (head)
+        if (!failed)
         {
-            head->next = parse_memberDeclList();
+            print_spilled_symbol_table_to_file(state.table, &state.scopes, symbol_path);
+            int semantic_errors = state.build_errors.count + state.check_errors.count;
+            print_spilled_errors_to_file(state.spills, 2, semantic_errors, error_path);
+            if (semantic_errors > 0)
+            {
+                printf("\n%sSemantic analysis found %d errors.\n", label, semantic_errors);
+            }
+            else
+            {
+                printf("\n%sSemantic analysis completed with no errors.\n", label);
+                status = syntax_errors > 0;
+            }
         }
-        return head;
     }
-    else
-    {
 
-        return NULL;
+    for (int i = 0; i < 2; i++)
+    {
+        if (state.spills[i] != NULL)
+        {
+            fclose(state.spills[i]);
+        }
     }
+    scope_spill_free(&state.scopes);
+    free(state.redeclared);
+    free_symbol_table(state.table);
+    source_close(&source);
+    compile_context_free(&ctx);
+    line_index_free(&lines);
+    return status;
 }
 
-struct ASTNode *parse_memberDecl()
+/* Compiles one file start to finish; everything it touches lives in its own
+   context, so calls for different files may run concurrently. label
+   starts each summary line printed, and is empty for a lone input. */
+static int compile_file(const char *input_path, const char *label, const CompileOptions *options,
+                        const char *symbol_path, const char *error_path)
 {
-    if (lookahead == KEYWORD)
+    if (options->stream)
     {
-        if (strcmp(current_lexeme, "func") == 0 ||
-            strcmp(current_lexeme, "constructor") == 0)
-        {
+        return compile_file_streaming(input_path, label, options, symbol_path, error_path);
+    }
 
-            return parse_funcDef();
+    SourceBuffer source;
+    if (source_open(&source, input_path, options->use_mmap) != 0)
+    {
+        fprintf(stderr, "Error: Cannot open file %s\n", input_path);
+        return 1;
+    }
+
+    CompileContext ctx;
+    compile_context_init(&ctx);
+    LineIndex lines;
+    CompactAst tree;
+
+    /* An unchanged source is not lexed or parsed again */
+    char *snapshot_file = NULL;
+    unsigned long long source_hash = 0;
+    Snapshot snapshot;
+    int from_snapshot = 0;
+    if (options->ast_cache)
+    {
+        double load_start = now_ms();
+        source_hash = snapshot_hash(source.data, source.size);
+        snapshot_file = snapshot_path(input_path, options->ast_cache_dir, source_hash);
+        from_snapshot = snapshot_load(&snapshot, snapshot_file, source_hash, source.size, &ctx.strings, &tree,
+                                      &lines) == 0;
+        if (from_snapshot && options->verbose)
+        {
+            printf("--- Loaded AST snapshot %s ---\n", snapshot_file);
         }
-        else if (strcmp(current_lexeme, "attribute") == 0)
+        if (from_snapshot && options->show_time)
         {
+            printf("%sAST snapshot: %.3f ms (%d nodes)\n", label, now_ms() - load_start, tree.count - 1);
+        }
+    }
 
-            return parse_attributeDecl();
+    int syntax_errors = 0;
+    if (!from_snapshot)
+    {
+        syntax_errors = parse_source(label, options, &ctx, &source, &lines, &tree);
+        if (syntax_errors < 0)
+        {
+            source_close(&source);
+            compile_context_free(&ctx);
+            free(snapshot_file);
+            return 1;
+        }
+        /* Only a clean parse is saved, so its errors are reported again */
+        if (snapshot_file != NULL && syntax_errors == 0 &&
+            snapshot_save(snapshot_file, source_hash, source.size, &tree, &lines) != 0)
+        {
+            fprintf(stderr, "Warning: Could not write AST snapshot %s\n", snapshot_file);
         }
     }
-    error("Expected func, attribute or constructor");
-    return NULL;
-}
+    source_close(&source);
+    free(snapshot_file);
+    ctx.lines = &lines;
 
-struct ASTNode *parse_funcDecl()
-{
+    SymbolTable *table = create_symbol_table(&ctx.errors);
+
+    if (options->verbose)
+    {
+        printf("--- Running Pass 1: Building Symbol Table ---\n");
+    }
+    double semantic_start = now_ms();
+    AstWalk walk;
+    ast_walk_init(&walk);
+    ast_walk_add(&walk, &symbol_table_visitor, table);
+    AstStats stats;
+    if (options->stats)
+    {
+        ast_stats_init(&stats, &tree);
+        ast_stats_add(&stats, &walk);
+    }
+    if (options->time_hooks)
+    {
+        ast_walk_measure(&walk);
+    }
+    ast_walk_run(&walk, &tree, tree.root);
 
-    struct ASTNode *head = parse_funcHead();
-    match(SEMICOLON);
+    double resolve_start = now_ms();
+    resolve_names_pass(&tree, table);
 
-    return create_node(NODE_FUNC_DECL, head, NULL);
+    if (options->verbose)
+    {
+        printf("--- Running Pass 2: Type Checking ---\n");
+    }
+    double check_start = now_ms();
+    type_check_pass(&tree, tree.root, table);
+    if (options->show_time)
+    {
+        printf("%sSymbol table: %.3f ms, name resolution: %.3f ms, type checking: %.3f ms\n", label,
+               resolve_start - semantic_start, check_start - resolve_start, now_ms() - check_start);
+    }
+    if (options->time_hooks)
+    {
+        printf("%sHook costs of the first pass:\n", label);
+        ast_walk_report(&walk, stdout);
+    }
+    ast_walk_free(&walk);
+    if (options->stats)
+    {
+        ast_stats_report(&stats, &tree, &lines, label, stdout);
+        ast_stats_free(&stats);
+    }
+
+    print_symbol_table_to_file(table, symbol_path);
+    print_errors_to_file(&ctx.errors, &lines, error_path);
+
+    int semantic_errors = get_semantic_error_count(&ctx.errors);
+    if (semantic_errors > 0)
+    {
+        printf("\n%sSemantic analysis found %d errors.\n", label, semantic_errors);
+    }
+    else
+    {
+        printf("\n%sSemantic analysis completed with no errors.\n", label);
+    }
+
+    free_symbol_table(table);
+    if (from_snapshot)
+    {
+        snapshot_close(&snapshot, &tree);
+    }
+    else
+    {
+        compact_ast_free(&tree);
+    }
+    compile_context_free(&ctx);
+    line_index_free(&lines);
+
+    return syntax_errors > 0 || semantic_errors > 0 ? 1 : 0;
 }
 
-struct ASTNode *parse_attributeDecl()
+/* Output files for one of several inputs are named after the input */
+static char *output_path(const char *input_path, const char *suffix)
 {
+    size_t length = strlen(input_path) + strlen(suffix) + 2;
+    char *path = (char *)malloc(length);
+    snprintf(path, length, "%s.%s", input_path, suffix);
+    return path;
+}
 
-    match(KEYWORD);
-    struct ASTNode *var_decl = parse_varDecl();
-
-    return create_node(NODE_ATTRIBUTE_DECL, var_decl, NULL);
+/* "<input>: ", which starts each summary line of a file compiled along
+   with others, so lines printed by different workers can be told apart */
+static char *summary_label(const char *input_path)
+{
+    size_t length = strlen(input_path) + 3;
+    char *label = (char *)malloc(length);
+    snprintf(label, length, "%s: ", input_path);
+    return label;
 }
 
-struct ASTNode *parse_implDef()
+static void *compile_worker(void *arg)
 {
+    CompileQueue *queue = (CompileQueue *)arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next < queue->count ? queue->next++ : -1;
+        pthread_mutex_unlock(&queue->lock);
+        if (index < 0)
+        {
+            break;
+        }
 
-    match(KEYWORD);
-    char *id = strdup(current_lexeme);
-    match(IDENTIFIER);
-    match(LBRACE);
-    struct ASTNode *func_list = parse_funcDefList();
-    match(RBRACE);
+        const char *input_path = queue->paths[index];
+        char *symbol_path = output_path(input_path, "symbol_table.txt");
+        char *error_path = output_path(input_path, "semantic_errors.txt");
+        char *label = summary_label(input_path);
+        int status = compile_file(input_path, label, queue->options, symbol_path, error_path);
+        free(symbol_path);
+        free(error_path);
+        free(label);
 
-    return create_impl_def(id, func_list);
+        if (status != 0)
+        {
+            pthread_mutex_lock(&queue->lock);
+            queue->failures++;
+            pthread_mutex_unlock(&queue->lock);
+        }
+    }
+    return NULL;
 }
 
-struct ASTNode *parse_funcDefList()
+/* Compiles every file on a pool of jobs threads; returns the failure count */
+static int compile_files(char **paths, int count, const CompileOptions *options, int jobs)
 {
-    if (lookahead == KEYWORD &&
-        (strcmp(current_lexeme, "func") == 0 || strcmp(current_lexeme, "constructor") == 0))
-    {
+    CompileQueue queue;
+    queue.paths = paths;
+    queue.count = count;
+    queue.next = 0;
+    queue.failures = 0;
+    queue.options = options;
+    pthread_mutex_init(&queue.lock, NULL);
 
-        struct ASTNode *head = parse_funcDef();
-        if (head)
+    if (jobs > count)
+    {
+        jobs = count;
+    }
+    pthread_t *workers = (pthread_t *)malloc(jobs * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; i < jobs; i++)
+    {
+        if (pthread_create(&workers[started], NULL, compile_worker, &queue) == 0)
         {
-            head->next = parse_funcDefList();
+            started++;
         }
-        return head;
     }
-    else
+    if (started == 0)
     {
-
-        return NULL;
+        compile_worker(&queue);
     }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    free(workers);
+    pthread_mutex_destroy(&queue.lock);
+    return queue.failures;
 }
 
-struct ASTNode *parse_funcDef()
+static void usage(const char *prog)
 {
-
-    struct ASTNode *head = parse_funcHead();
-    struct ASTNode *body = parse_funcBody();
-
-    return create_func_def(head, body);
+    fprintf(stderr, "Usage: %s [--mmap] [--time] [--pipeline] [--lexer=flex|fast|parallel] [--lex-jobs=<n>] [--parse-jobs=<n>] [--lex-diff] [--relex-diff] [--trace[=text|binary]] [--trace-out=<file>] [--ast-cache[=<dir>]] [--stream] [--share-exprs] [--stats] [--time-hooks] [--jobs=<n>] <input_file>...\n", prog);
 }
 
-struct ASTNode *parse_funcHead()
+int main(int argc, char *argv[])
 {
-    int is_ctor = 0;
-    char *id = NULL;
-    struct ASTNode *params = NULL;
-    struct ASTNode *ret_type = NULL;
+    char **input_paths = (char **)malloc(argc * sizeof(char *));
+    int input_count = 0;
+    int lex_diff = 0;
+    int relex_diff = 0;
+    int jobs = 1;
+    CompileOptions options;
+    options.use_mmap = 0;
+    options.pipeline = 0;
+    options.lexer = LEXER_FLEX;
+    options.lex_jobs = 4;
+    options.parse_jobs = 1;
+    options.show_time = 0;
+    options.verbose = 1;
+    options.trace_mode = TRACE_OFF;
+    options.trace_path = NULL;
+    options.ast_cache = 0;
+    options.ast_cache_dir = NULL;
+    options.stream = 0;
+    options.share_exprs = 0;
+    options.stats = 0;
+    options.time_hooks = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--mmap") == 0)
+        {
+            options.use_mmap = 1;
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0)
+        {
+            options.pipeline = 1;
+        }
+        else if (strcmp(argv[i], "--time") == 0)
+        {
+            options.show_time = 1;
+        }
+        else if (strcmp(argv[i], "--lexer=flex") == 0)
+        {
+            options.lexer = LEXER_FLEX;
+        }
+        else if (strcmp(argv[i], "--lexer=fast") == 0)
+        {
+            options.lexer = LEXER_FAST;
+        }
+        else if (strcmp(argv[i], "--lexer=parallel") == 0)
+        {
+            options.lexer = LEXER_PARALLEL;
+        }
+        else if (strncmp(argv[i], "--lex-jobs=", 11) == 0)
+        {
+            options.lex_jobs = atoi(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--parse-jobs=", 13) == 0)
+        {
+            options.parse_jobs = atoi(argv[i] + 13);
+        }
+        else if (strcmp(argv[i], "--lex-diff") == 0)
+        {
+            lex_diff = 1;
+        }
+        else if (strcmp(argv[i], "--relex-diff") == 0)
+        {
+            relex_diff = 1;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 || strcmp(argv[i], "--trace=text") == 0)
+        {
+            options.trace_mode = TRACE_TEXT;
+        }
+        else if (strcmp(argv[i], "--trace=binary") == 0)
+        {
+            options.trace_mode = TRACE_BINARY;
+        }
+        else if (strncmp(argv[i], "--trace-out=", 12) == 0)
+        {
+            options.trace_path = argv[i] + 12;
+        }
+        else if (strcmp(argv[i], "--ast-cache") == 0)
+        {
+            options.ast_cache = 1;
+        }
+        else if (strncmp(argv[i], "--ast-cache=", 12) == 0)
+        {
+            options.ast_cache = 1;
+            options.ast_cache_dir = argv[i] + 12;
+        }
+        else if (strcmp(argv[i], "--stream") == 0)
+        {
+            options.stream = 1;
+        }
+        else if (strcmp(argv[i], "--share-exprs") == 0)
+        {
+            options.share_exprs = 1;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            options.stats = 1;
+        }
+        else if (strcmp(argv[i], "--time-hooks") == 0)
+        {
+            options.time_hooks = 1;
+        }
+        else if (strncmp(argv[i], "--jobs=", 7) == 0)
+        {
+            jobs = atoi(argv[i] + 7);
+            if (jobs < 1)
+            {
+                jobs = 1;
+            }
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            usage(argv[0]);
+            free(input_paths);
+            return 1;
+        }
+        else
+        {
+            input_paths[input_count++] = argv[i];
+        }
+    }
 
-    if (lookahead == KEYWORD && strcmp(current_lexeme, "func") == 0)
+    if (input_count == 0)
     {
+        usage(argv[0]);
+        free(input_paths);
+        return 1;
+    }
 
-        match(KEYWORD);
-        id = strdup(current_lexeme);
-        match(IDENTIFIER);
-        match(LPAREN);
-        params = parse_fParams();
-        match(RPAREN);
-        match(ARROW);
-        ret_type = parse_returnType();
+    if (input_count > 1 && (lex_diff || relex_diff || options.trace_mode != TRACE_OFF))
+    {
+        fprintf(stderr, "Error: --lex-diff, --relex-diff and --trace take a single input file\n");
+        free(input_paths);
+        return 1;
     }
-    else if (lookahead == KEYWORD && strcmp(current_lexeme, "constructor") == 0)
+
+    if (options.pipeline && options.lexer != LEXER_FLEX)
     {
+        fprintf(stderr, "Error: --pipeline runs the flex lexer\n");
+        free(input_paths);
+        return 1;
+    }
 
-        is_ctor = 1;
-        match(KEYWORD);
-        id = strdup("constructor");
-        match(LPAREN);
-        params = parse_fParams();
-        match(RPAREN);
+    if (options.pipeline && options.parse_jobs > 1)
+    {
+        fprintf(stderr, "Error: --parse-jobs needs the whole token stream and cannot be used with --pipeline\n");
+        free(input_paths);
+        return 1;
+    }
 
-        ret_type = create_type_node("void");
+    if (options.ast_cache && options.trace_mode != TRACE_OFF)
+    {
+        fprintf(stderr, "Error: --ast-cache may skip lexing and cannot be used with --trace\n");
+        free(input_paths);
+        return 1;
+    }
+
+    if (options.stream && (options.lexer != LEXER_FLEX || options.parse_jobs > 1 || options.ast_cache ||
+                           options.trace_mode != TRACE_OFF))
+    {
+        fprintf(stderr, "Error: --stream lexes with flex twice and cannot be combined with --lexer, --parse-jobs, --ast-cache or --trace\n");
+        free(input_paths);
+        return 1;
+    }
+
+    if (options.trace_mode == TRACE_BINARY && options.trace_path == NULL)
+    {
+        options.trace_path = "token_trace.bin";
+    }
+
+    int status;
+    if (lex_diff || relex_diff)
+    {
+        SourceBuffer source;
+        if (source_open(&source, input_paths[0], options.use_mmap) != 0)
+        {
+            fprintf(stderr, "Error: Cannot open file %s\n", input_paths[0]);
+            free(input_paths);
+            return 1;
+        }
+        status = lex_diff ? compare_lexers(&source, options.lex_jobs) : compare_relex(&source);
+        source_close(&source);
+    }
+    else if (input_count == 1)
+    {
+        status = compile_file(input_paths[0], "", &options, "symbol_table.txt", "semantic_errors.txt");
     }
     else
     {
-        error("Expected func or constructor");
-        return NULL;
+        options.verbose = 0;
+        status = compile_files(input_paths, input_count, &options, jobs) > 0 ? 1 : 0;
     }
 
-    return create_func_head(is_ctor, id, params, ret_type);
+    free(input_paths);
+    return status;
 }
 
-struct ASTNode *parse_returnType()
+/* Stacks of the table-driven parser; nesting in the input grows these
+   arrays rather than the C stack */
+typedef struct LLFrame
 {
-    if (lookahead == KEYWORD && strcmp(current_lexeme, "void") == 0)
-    {
+    int base;           /* first value of the production being expanded */
+    unsigned int start; /* offset of the token it was predicted on */
+    int errors;         /* errors_seen when it was expanded */
+} LLFrame;
+
+/* An item of a %sync list being parsed, with the stack depths to restore
+   when error recovery abandons the item. A list that has ended keeps a
+   point until its closing brace matches, so a stray token before the
+   brace reopens the list rather than abandoning what encloses it. */
+typedef struct LLPoint
+{
+    int nonterminal;
+    int symbols;
+    int values;
+    int frames;
+    unsigned int start;
+    int reopen; /* the list had ended; its brace is pushed back on resuming */
+} LLPoint;
+
+typedef struct LLStack
+{
+    unsigned short *symbols;
+    int symbol_count;
+    int symbol_capacity;
+
+    LLValue *values;
+    int value_count;
+    int value_capacity;
 
-        match(KEYWORD);
-        return create_type_node("void");
+    LLFrame *frames;
+    int frame_count;
+    int frame_capacity;
+
+    LLPoint *points;
+    int point_count;
+    int point_capacity;
+} LLStack;
+
+static void ll1_reserve_symbols(LLStack *stack, int needed)
+{
+    if (stack->symbol_count + needed > stack->symbol_capacity)
+    {
+        stack->symbol_capacity = 2 * stack->symbol_capacity + needed;
+        stack->symbols = (unsigned short *)realloc(stack->symbols, stack->symbol_capacity * sizeof(unsigned short));
     }
-    else
+}
+
+static LLValue *ll1_push_value(LLStack *stack)
+{
+    if (stack->value_count == stack->value_capacity)
     {
+        stack->value_capacity *= 2;
+        stack->values = (LLValue *)realloc(stack->values, stack->value_capacity * sizeof(LLValue));
+    }
+    return &stack->values[stack->value_count++];
+}
 
-        return parse_type();
+static void ll1_push_point(CompileContext *ctx, LLStack *stack, int nonterminal, int reopen)
+{
+    if (stack->point_count == stack->point_capacity)
+    {
+        stack->point_capacity *= 2;
+        stack->points = (LLPoint *)realloc(stack->points, stack->point_capacity * sizeof(LLPoint));
+    }
+    LLPoint *point = &stack->points[stack->point_count++];
+    point->nonterminal = nonterminal;
+    point->symbols = stack->symbol_count;
+    point->values = stack->value_count;
+    point->frames = stack->frame_count;
+    point->start = ctx->current_token.offset;
+    point->reopen = reopen;
+}
+
+/* Drops everything above point i and leaves an error node as its item */
+static void ll1_resume(CompileContext *ctx, LLStack *stack, int i)
+{
+    const LLPoint *point = &stack->points[i];
+    stack->symbol_count = point->symbols;
+    stack->value_count = point->values;
+    stack->frame_count = point->frames;
+    stack->point_count = i + 1;
+    ll1_push_value(stack)->node = create_node(&ctx->ast, NODE_ERROR, NULL, NULL, point->start);
+    if (point->reopen)
+    {
+        ll1_reserve_symbols(stack, 2);
+        stack->symbols[stack->symbol_count++] = (unsigned short)(LL1_TOKEN | RBRACE);
+        stack->symbols[stack->symbol_count++] = (unsigned short)(LL1_LIST_APPEND | point->nonterminal);
     }
 }
 
-struct ASTNode *parse_type()
+/* Panic-mode recovery: skips tokens until one that can end or start an
+   item of an enclosing %sync list, then abandons the items inside it. A
+   braced group is skipped whole, so its contents are not mistaken for
+   the items of the list around it. */
+static void ll1_recover(CompileContext *ctx, LLStack *stack)
 {
-    if (lookahead == KEYWORD)
+    ctx->panic = 0;
+    for (;;)
     {
-        if (strcmp(current_lexeme, "integer") == 0)
+        int token = ctx->lookahead;
+        if (token == 0)
+        {
+            /* A reopened list would only wait for its brace again */
+            int i = stack->point_count - 1;
+            while (i >= 0 && stack->points[i].reopen)
+            {
+                i--;
+            }
+            if (i >= 0)
+            {
+                ll1_resume(ctx, stack, i);
+            }
+            return;
+        }
+        if (token == LBRACE)
         {
-            match(KEYWORD);
-            return create_type_node("integer");
+            int depth = 0;
+            do
+            {
+                depth += ctx->lookahead == LBRACE ? 1 : ctx->lookahead == RBRACE ? -1 : 0;
+                advance(ctx);
+            } while (depth > 0 && ctx->lookahead != 0);
+            continue;
         }
-        else if (strcmp(current_lexeme, "float") == 0)
+
+        /* ';' and '}' end an item of a list nested in a declaration */
+        if ((token == SEMICOLON || token == RBRACE) && stack->point_count > 1)
         {
-            match(KEYWORD);
-            return create_type_node("float");
+            if (token == SEMICOLON)
+            {
+                advance(ctx);
+            }
+            ll1_resume(ctx, stack, stack->point_count - 1);
+            return;
         }
-        else if (strcmp(current_lexeme, "string") == 0)
+        if (IS_KEYWORD_TOKEN(token))
         {
-            match(KEYWORD);
-            return create_type_node("string");
+            for (int i = stack->point_count - 1; i >= 0; i--)
+            {
+                if (ll1_predict[stack->points[i].nonterminal][token] != 0)
+                {
+                    ll1_resume(ctx, stack, i);
+                    return;
+                }
+            }
         }
+        advance(ctx);
     }
-
-    error("Expected integer, float, or id");
-    return NULL;
 }
 
-struct ASTNode *parse_funcBody()
+/* Reports tokens between top-level declarations that cannot start one,
+   then skips them, braced groups whole as in recovery, so the program
+   goes on with the next class, implement, func or constructor */
+static void skip_to_top_level_decl(CompileContext *ctx)
 {
-
-    match(LBRACE);
-    struct ASTNode *list = parse_VarDeclOrStmtList();
-    match(RBRACE);
-    return create_node(NODE_FUNC_BODY, list, NULL);
+    error(ctx, ll1_error_messages[NT_CLASS_OR_IMPL_OR_FUNC]);
+    while (ctx->lookahead != 0 && ll1_predict[NT_CLASS_OR_IMPL_OR_FUNC][ctx->lookahead] == 0)
+    {
+        int depth = 0;
+        do
+        {
+            depth += ctx->lookahead == LBRACE ? 1 : ctx->lookahead == RBRACE ? -1 : 0;
+            advance(ctx);
+        } while (depth > 0 && ctx->lookahead != 0);
+    }
+    ctx->panic = 0;
 }
 
-struct ASTNode *parse_VarDeclOrStmtList()
+/* Replaces a nonterminal by the right-hand side the lookahead predicts,
+   pushed in reverse so its first symbol is on top. When nothing is
+   predicted the error is reported and NULLs stand in for its values. */
+static void ll1_expand(CompileContext *ctx, LLStack *stack, int nonterminal)
 {
-    if (lookahead == KEYWORD &&
-            (strcmp(current_lexeme, "local") == 0 ||
-             strcmp(current_lexeme, "if") == 0 ||
-             strcmp(current_lexeme, "while") == 0 ||
-             strcmp(current_lexeme, "read") == 0 ||
-             strcmp(current_lexeme, "write") == 0 ||
-             strcmp(current_lexeme, "self") == 0 ||
-             strcmp(current_lexeme, "return") == 0) ||
-        lookahead == IDENTIFIER)
+    int production = ll1_predict[nonterminal][ctx->lookahead];
+    if (production == 0)
+    {
+        production = ll1_fallback[nonterminal];
+    }
+    if (nonterminal == NT_CLASS_OR_IMPL_OR_FUNC)
+    {
+        /* Errors reported for a declaration do not depend on the one before */
+        ctx->error_quiet = 0;
+    }
+    if (production == 0)
     {
+        if (ll1_error_hooks[nonterminal] != NULL)
+        {
+            ll1_error_hooks[nonterminal](ctx);
+        }
+        else
+        {
+            error(ctx, ll1_error_messages[nonterminal] != NULL ? ll1_error_messages[nonterminal] : "Unexpected token");
+        }
+        for (int i = 0; i < ll1_arity[nonterminal]; i++)
+        {
+            ll1_push_value(stack)->node = NULL;
+        }
+        return;
+    }
 
-        struct ASTNode *head = parse_VarDeclOrStmt();
-        if (head)
+    const LLProduction *p = &ll1_productions[production];
+    ll1_reserve_symbols(stack, p->length + 1);
+    if (p->action != 0)
+    {
+        if (stack->frame_count == stack->frame_capacity)
         {
-            head->next = parse_VarDeclOrStmtList();
+            stack->frame_capacity *= 2;
+            stack->frames = (LLFrame *)realloc(stack->frames, stack->frame_capacity * sizeof(LLFrame));
         }
-        return head;
+        stack->frames[stack->frame_count].base = stack->value_count;
+        stack->frames[stack->frame_count].start = ctx->current_token.offset;
+        stack->frames[stack->frame_count].errors = ctx->errors_seen;
+        stack->frame_count++;
+        stack->symbols[stack->symbol_count++] = (unsigned short)(LL1_REDUCE | p->action);
     }
-    else
+    for (int i = p->length - 1; i >= 0; i--)
     {
-
-        return NULL;
+        stack->symbols[stack->symbol_count++] = ll1_rhs[p->first + i];
     }
 }
 
-struct ASTNode *parse_VarDeclOrStmt()
+/* Runs the tables generated from grammar.ll1 from the nonterminal start.
+   Expressions are left to the hand-written functions the grammar names as
+   externals. After a syntax error the parse resumes at the next item of
+   the innermost %sync list. A %sync start counts as an item, so a parse
+   from it gives the error node the list around it would have. */
+static struct ASTNode *ll1_parse(CompileContext *ctx, int start)
 {
-    if (lookahead == KEYWORD && strcmp(current_lexeme, "local") == 0)
-    {
+    LLStack stack;
+    stack.symbol_capacity = 64;
+    stack.symbols = (unsigned short *)malloc(stack.symbol_capacity * sizeof(unsigned short));
+    stack.value_capacity = 64;
+    stack.values = (LLValue *)malloc(stack.value_capacity * sizeof(LLValue));
+    stack.frame_capacity = 32;
+    stack.frames = (LLFrame *)malloc(stack.frame_capacity * sizeof(LLFrame));
+    stack.point_capacity = 16;
+    stack.points = (LLPoint *)malloc(stack.point_capacity * sizeof(LLPoint));
+    stack.value_count = 0;
+    stack.frame_count = 0;
+    stack.symbol_count = 0;
+    stack.point_count = 0;
+    if (ll1_sync[start])
+    {
+        ll1_push_point(ctx, &stack, start, 0);
+    }
+    stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_NONTERMINAL | start);
+
+    while (stack.symbol_count > 0)
+    {
+        if (ctx->panic)
+        {
+            ll1_recover(ctx, &stack);
+            continue;
+        }
 
-        return parse_localVarDecl();
-    }
-    else if (lookahead == IDENTIFIER || (lookahead == KEYWORD &&
-                                         (strcmp(current_lexeme, "if") == 0 ||
-                                          strcmp(current_lexeme, "while") == 0 ||
-                                          strcmp(current_lexeme, "read") == 0 ||
-                                          strcmp(current_lexeme, "write") == 0 ||
-                                          strcmp(current_lexeme, "return") == 0 ||
-                                          strcmp(current_lexeme, "self") == 0)))
-    {
+        int symbol = stack.symbols[--stack.symbol_count];
+        int index = LL1_INDEX(symbol);
+        switch (LL1_KIND(symbol))
+        {
+        case LL1_TOKEN:
+            match(ctx, index);
+            break;
 
-        return parse_statement();
-    }
-    else
-    {
-        error("Expected local variable declaration or statement");
-        return NULL;
-    }
-}
+        case LL1_CAPTURE:
+        {
+            LLValue *value = ll1_push_value(&stack);
+            value->token.name = index == IDENTIFIER ? lexeme_intern(ctx) : NULL;
+            value->token.offset = ctx->current_token.offset;
+            value->token.value = ctx->current_token.value;
+            match(ctx, index);
+            break;
+        }
+
+        case LL1_EXTERN:
+        {
+            struct ASTNode *node = ll1_externs[index](ctx);
+            ll1_push_value(&stack)->node = node;
+            break;
+        }
+
+        case LL1_NONTERMINAL:
+            ll1_expand(ctx, &stack, index);
+            break;
+
+        case LL1_LIST:
+        {
+            LLValue *value = ll1_push_value(&stack);
+            value->list.head = NULL;
+            value->list.last = NULL;
+            ll1_reserve_symbols(&stack, 1);
+            stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_LIST_NEXT | index);
+            break;
+        }
+
+        case LL1_LIST_NEXT:
+            if (ll1_predict[index][ctx->lookahead] != 0)
+            {
+                ll1_reserve_symbols(&stack, 2);
+                stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_LIST_APPEND | index);
+                if (ll1_sync[index])
+                {
+                    ll1_push_point(ctx, &stack, index, 0);
+                }
+                stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_NONTERMINAL | index);
+            }
+            else if (ll1_sync[index] && stack.symbol_count > 0 &&
+                     stack.symbols[stack.symbol_count - 1] == (LL1_TOKEN | RBRACE))
+            {
+                stack.symbol_count--;
+                ll1_push_point(ctx, &stack, index, 1);
+                stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_LIST_CLOSE | index);
+            }
+            else if (index == NT_CLASS_OR_IMPL_OR_FUNC && ctx->lookahead != 0)
+            {
+                /* Only the end of input ends the program */
+                skip_to_top_level_decl(ctx);
+                stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_LIST_NEXT | index);
+            }
+            break;
+
+        /* The list's point is dropped once the brace has matched */
+        case LL1_LIST_CLOSE:
+            match(ctx, RBRACE);
+            if (!ctx->panic)
+            {
+                stack.point_count--;
+            }
+            break;
+
+        /* A missing item ends the list */
+        case LL1_LIST_APPEND:
+        {
+            struct ASTNode *item = stack.values[--stack.value_count].node;
+            LLValue *list = &stack.values[stack.value_count - 1];
+            if (ll1_sync[index])
+            {
+                stack.point_count--;
+            }
+            if (item == NULL)
+            {
+                break;
+            }
+            if (list->list.last == NULL)
+            {
+                list->list.head = item;
+            }
+            else
+            {
+                list->list.last->next = item;
+            }
+            list->list.last = item;
+            ll1_reserve_symbols(&stack, 1);
+            stack.symbols[stack.symbol_count++] = (unsigned short)(LL1_LIST_NEXT | index);
+            break;
+        }
 
-struct ASTNode *parse_localVarDecl()
-{
+        case LL1_REDUCE:
+        {
+            LLFrame frame = stack.frames[--stack.frame_count];
+            struct ASTNode *node = ll1_actions[index](ctx, stack.values + frame.base, frame.start);
+            if (node != NULL && node->type == NODE_FUNC_BODY && ctx->errors_seen != frame.errors)
+            {
+                /* Only functions that parsed cleanly are analysed */
+                node = create_node(&ctx->ast, NODE_ERROR, NULL, NULL, frame.start);
+            }
+            stack.value_count = frame.base;
+            ll1_push_value(&stack)->node = node;
+            break;
+        }
+        }
+    }
 
-    match(KEYWORD);
-    return parse_varDecl();
+    struct ASTNode *root = stack.values[0].node;
+    free(stack.symbols);
+    free(stack.values);
+    free(stack.frames);
+    free(stack.points);
+    return root;
 }
 
-struct ASTNode *parse_varDecl()
+struct ASTNode *parse_prog(CompileContext *ctx)
 {
-
-    char *id = strdup(current_lexeme);
-    match(IDENTIFIER);
-    match(COLON);
-    struct ASTNode *type_node = parse_type();
-    struct ASTNode *dims = parse_arraySizeList();
-    match(SEMICOLON);
-
-    return create_var_decl(id, type_node, dims);
+    return ll1_parse(ctx, LL1_START);
 }
 
-struct ASTNode *parse_arraySizeList()
+/* The next item of the program's declaration list, or NULL at its end */
+struct ASTNode *parse_top_level_decl(CompileContext *ctx)
 {
-    if (lookahead == LBRACKET)
+    if (ll1_predict[NT_CLASS_OR_IMPL_OR_FUNC][ctx->lookahead] == 0 && ctx->lookahead != 0)
     {
-
-        struct ASTNode *head = parse_arraySize();
-        if (head)
-        {
-            head->next = parse_arraySizeList();
-        }
-        return head;
+        skip_to_top_level_decl(ctx);
     }
-    else
+    if (ctx->lookahead == 0)
     {
-
         return NULL;
     }
+    return ll1_parse(ctx, NT_CLASS_OR_IMPL_OR_FUNC);
 }
 
-struct ASTNode *parse_arraySize()
-{
-
-    match(LBRACKET);
-    struct ASTNode *size_node = NULL;
-    if (lookahead == INTEGER_LIT)
-    {
-        int val = atoi(current_lexeme);
-        match(INTEGER_LIT);
-        size_node = create_int_lit(val);
-    }
-    match(RBRACKET);
+/* Declarations parsed in one go by a worker, at least this many tokens'
+   worth so a batch outweighs its arena block and hand-off */
+#ifndef PARSE_BATCH_TOKENS
+#define PARSE_BATCH_TOKENS 16384
+#endif
 
-    return size_node;
+/* One top-level declaration parsed ahead of the main thread */
+typedef struct DeclParse
+{
+    int start; /* token index of its class, implement, func or constructor */
+    int end;   /* token index the parse stopped at */
+    struct ASTNode *node;
+    int errors;
+    int quiet; /* error_quiet after it */
+    int log_start; /* its syntax errors in the batch's log */
+    int log_end;
+} DeclParse;
+
+typedef struct ParseBatch
+{
+    int first;
+    int count;
+    Arena ast;
+    SyntaxLog log;
+} ParseBatch;
+
+/* Batches waiting to be parsed; each worker claims the next one under lock */
+typedef struct ParseQueue
+{
+    const CompileContext *main;
+    SharedInterner strings;
+    DeclParse *decls;
+    ParseBatch *batches;
+    int batch_count;
+    int next;
+    pthread_mutex_t lock;
+} ParseQueue;
+
+/* Makes token index the lookahead */
+static void parse_seek(CompileContext *ctx, int index)
+{
+    ctx->cursor = index - 1;
+    advance(ctx);
 }
 
-struct ASTNode *parse_statement()
+/* Token indexes of the class, implement, func and constructor keywords
+   outside any braces. With balanced braces these are where the top-level
+   declarations start; a wrong guess only costs a re-parse. */
+static int find_top_level_decls(const TokenBuffer *tokens, int **starts)
 {
-
-    if (lookahead == KEYWORD)
+    int count = 0;
+    int capacity = 64;
+    int depth = 0;
+    *starts = (int *)malloc(capacity * sizeof(int));
+    for (int i = 0; i < tokens->count; i++)
     {
-        if (strcmp(current_lexeme, "if") == 0)
+        switch (tokens->kind[i])
         {
-
-            match(KEYWORD);
-            match(LPAREN);
-            struct ASTNode *cond = parse_expr();
-            match(RPAREN);
-            if (lookahead == KEYWORD && strcmp(current_lexeme, "then") == 0)
+        case LBRACE:
+            depth++;
+            break;
+        case RBRACE:
+            if (depth > 0)
             {
-                match(KEYWORD);
+                depth--;
             }
-            else
-            {
-                error("Syntax error: expected 'then' after if condition");
-            }
-
-            struct ASTNode *if_body = parse_statBlock();
-            struct ASTNode *else_body = NULL;
-
-            if (lookahead == KEYWORD && strcmp(current_lexeme, "else") == 0)
+            break;
+        case CLASS_KW:
+        case IMPLEMENT_KW:
+        case FUNC_KW:
+        case CONSTRUCTOR_KW:
+            if (depth == 0)
             {
-                match(KEYWORD);
-                if (lookahead == LBRACE)
-                {
-
-                    else_body = parse_statBlock();
-                }
-                else
+                if (count == capacity)
                 {
-
-                    else_body = parse_statement();
+                    capacity *= 2;
+                    *starts = (int *)realloc(*starts, capacity * sizeof(int));
                 }
+                (*starts)[count++] = i;
             }
-
-            return create_if_node(cond, if_body, else_body);
+            break;
         }
+    }
+    return count;
+}
 
-        else if (strcmp(current_lexeme, "while") == 0)
-        {
-
-            match(KEYWORD);
-            match(LPAREN);
-            struct ASTNode *cond = parse_expr();
-            match(RPAREN);
-            struct ASTNode *body = parse_statBlock();
-            match(SEMICOLON);
+static void *parse_worker(void *arg)
+{
+    ParseQueue *queue = (ParseQueue *)arg;
 
-            return create_while_node(cond, body);
-        }
+    /* Reads the main context's tokens; everything it writes is its own */
+    CompileContext ctx;
+    compile_context_init(&ctx);
+    ctx.lines = queue->main->lines;
+    ctx.tokens = queue->main->tokens;
+    ctx.shared_strings = &queue->strings;
 
-        else if (strcmp(current_lexeme, "read") == 0)
+    for (;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next < queue->batch_count ? queue->next++ : -1;
+        pthread_mutex_unlock(&queue->lock);
+        if (index < 0)
         {
-
-            match(KEYWORD);
-            match(LPAREN);
-            struct ASTNode *var = parse_variable();
-            match(RPAREN);
-            match(SEMICOLON);
-
-            return create_read_node(var);
+            break;
         }
 
-        else if (strcmp(current_lexeme, "write") == 0)
+        ParseBatch *batch = &queue->batches[index];
+        arena_init(&ctx.ast);
+        ctx.syntax_log = &batch->log;
+        for (int i = batch->first; i < batch->first + batch->count; i++)
         {
-
-            match(KEYWORD);
-            match(LPAREN);
-            struct ASTNode *expr = parse_expr();
-            match(RPAREN);
-            match(SEMICOLON);
-
-            return create_write_node(expr);
+            DeclParse *decl = &queue->decls[i];
+            parse_seek(&ctx, decl->start);
+            ctx.error_count = 0;
+            decl->log_start = batch->log.length;
+            decl->node = ll1_parse(&ctx, NT_CLASS_OR_IMPL_OR_FUNC);
+            decl->end = ctx.cursor;
+            decl->errors = ctx.error_count;
+            decl->quiet = ctx.error_quiet;
+            decl->log_end = batch->log.length;
         }
+        batch->ast = ctx.ast;
+    }
+
+    interner_free(&ctx.strings);
+    error_log_free(&ctx.errors);
+    return NULL;
+}
 
-        else if (strcmp(current_lexeme, "return") == 0)
+/* Parses the program with its top-level declarations spread over jobs
+   threads, giving the tree and errors parse_prog would. A declaration
+   parsed ahead is only used when the main thread's parse reaches its
+   first token; otherwise, as after errors that ran past it, the main
+   thread parses it itself. */
+struct ASTNode *parse_prog_parallel(CompileContext *ctx, int jobs)
+{
+    int *starts;
+    int decl_count = find_top_level_decls(&ctx->tokens, &starts);
+
+    ParseQueue queue;
+    queue.main = ctx;
+    queue.decls = (DeclParse *)malloc((decl_count + 1) * sizeof(DeclParse));
+    queue.batches = (ParseBatch *)malloc((decl_count + 1) * sizeof(ParseBatch));
+    queue.batch_count = 0;
+    queue.next = 0;
+    for (int i = 0; i < decl_count;)
+    {
+        ParseBatch *batch = &queue.batches[queue.batch_count++];
+        batch->first = i;
+        batch->count = 0;
+        arena_init(&batch->ast);
+        batch->log.text = NULL;
+        batch->log.length = 0;
+        batch->log.capacity = 0;
+        do
         {
+            queue.decls[i].start = starts[i];
+            queue.decls[i].node = NULL;
+            batch->count++;
+            i++;
+        } while (i < decl_count && starts[i] - starts[batch->first] < PARSE_BATCH_TOKENS);
+    }
+    free(starts);
 
-            match(KEYWORD);
-            struct ASTNode *expr = parse_expr();
-            match(SEMICOLON);
+    if (queue.batch_count < 2)
+    {
+        free(queue.decls);
+        free(queue.batches);
+        return parse_prog(ctx);
+    }
 
-            return create_return_node(expr);
-        }
+    if (jobs > queue.batch_count)
+    {
+        jobs = queue.batch_count;
+    }
+    queue.strings.strings = &ctx->strings;
+    pthread_mutex_init(&queue.strings.lock, NULL);
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_t *workers = (pthread_t *)malloc(jobs * sizeof(pthread_t));
+    int started = 0;
+    while (started < jobs - 1 && pthread_create(&workers[started], NULL, parse_worker, &queue) == 0)
+    {
+        started++;
+    }
+    parse_worker(&queue);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
     }
-    else if (lookahead == IDENTIFIER)
+    free(workers);
+    pthread_mutex_destroy(&queue.lock);
+    pthread_mutex_destroy(&queue.strings.lock);
+
+    /* Splice the results in as the sequential list loop would build it */
+    unsigned int start = ctx->current_token.offset;
+    struct ASTNode *head = NULL;
+    struct ASTNode **tail = &head;
+    int next = 0;
+    const ParseBatch *batch = &queue.batches[0];
+    for (;;)
     {
-        struct ASTNode *expr_node = parse_expr();
-        if (expr_node->type == NODE_FUNC_CALL)
+        if (ll1_predict[NT_CLASS_OR_IMPL_OR_FUNC][ctx->lookahead] == 0 && ctx->lookahead != 0)
         {
-            match(SEMICOLON);
-            return expr_node;
+            skip_to_top_level_decl(ctx);
         }
-        else if (expr_node->type == NODE_VARIABLE)
+        if (ctx->lookahead == 0)
         {
-            match(ASSIGN_OP);
-            struct ASTNode *rhs_expr = parse_expr();
-            match(SEMICOLON);
-            return create_assign_node(expr_node, rhs_expr);
+            break;
+        }
+        while (next < decl_count && queue.decls[next].start < ctx->cursor)
+        {
+            next++;
+        }
+
+        struct ASTNode *item;
+        if (next < decl_count && queue.decls[next].start == ctx->cursor)
+        {
+            const DeclParse *decl = &queue.decls[next];
+            while (batch->first + batch->count <= next)
+            {
+                batch++;
+            }
+            if (decl->errors > 0)
+            {
+                fwrite(batch->log.text + decl->log_start, 1, decl->log_end - decl->log_start, stderr);
+            }
+            ctx->error_count += decl->errors;
+            ctx->error_quiet = decl->quiet;
+            item = decl->node;
+            parse_seek(ctx, decl->end);
         }
         else
         {
-            error("Syntax error: Statement must be an assignment or function call");
-            return NULL;
+            item = ll1_parse(ctx, NT_CLASS_OR_IMPL_OR_FUNC);
+        }
+
+        if (!list_append(&tail, item))
+        {
+            break;
         }
     }
-    else if (lookahead == LBRACE)
-    {
-        return parse_statBlock();
-    }
-    else
+
+    for (int i = 0; i < queue.batch_count; i++)
     {
-        error("Syntax error: Unexpected token in statement");
-        advance();
-        return NULL;
+        arena_adopt(&ctx->ast, &queue.batches[i].ast);
+        free(queue.batches[i].log.text);
     }
+    free(queue.decls);
+    free(queue.batches);
 
-    return NULL;
+    return create_node(&ctx->ast, NODE_PROG, head, NULL, start);
 }
 
-struct ASTNode *parse_assignStat()
+/* Actions named in grammar.ll1; values holds one entry per captured
+   token, list, external or nonterminal of the production, in order */
+
+static struct ASTNode *reduce_prog(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
+    return create_node(&ctx->ast, NODE_PROG, values[0].list.head, NULL, start);
+}
 
-    struct ASTNode *var = parse_variable();
-    match(ASSIGN_OP);
-    struct ASTNode *expr = parse_expr();
+static struct ASTNode *reduce_class_decl(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_class_decl(&ctx->ast, values[0].token.name, values[1].node, values[2].list.head, values[3].node,
+                             start);
+}
 
-    return create_assign_node(var, expr);
+static struct ASTNode *reduce_isa(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)start;
+    struct ASTNode *id_node = create_id_node(&ctx->ast, values[0].token.name, values[0].token.offset);
+    id_node->next = values[1].list.head;
+    return id_node;
 }
 
-struct ASTNode *parse_statBlock()
+static struct ASTNode *reduce_null(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
-    if (lookahead == LBRACE)
-    {
+    (void)ctx;
+    (void)values;
+    (void)start;
+    return NULL;
+}
 
-        match(LBRACE);
-        struct ASTNode *list = parse_statementList();
-        match(RBRACE);
-        return create_node(NODE_STAT_BLOCK, list, NULL);
-    }
-    else if (lookahead == KEYWORD || lookahead == IDENTIFIER)
-    {
+static struct ASTNode *reduce_id(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)start;
+    return create_id_node(&ctx->ast, values[0].token.name, values[0].token.offset);
+}
 
-        return parse_statement();
-    }
-    else
-    {
+static struct ASTNode *reduce_visibility_members(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)ctx;
+    (void)start;
+    struct ASTNode *head = values[3].list.head;
+    struct ASTNode *tail = values[4].node;
 
-        return NULL;
+    if (head == NULL)
+        return tail;
+    struct ASTNode *current = head;
+    while (current->next != NULL)
+    {
+        current = current->next;
     }
+    current->next = tail;
+    return head;
 }
 
-struct ASTNode *parse_statementList()
+static struct ASTNode *reduce_public(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
-    if (lookahead == KEYWORD || lookahead == IDENTIFIER)
-    {
+    (void)values;
+    return create_visibility_node(&ctx->ast, "public", start);
+}
 
-        struct ASTNode *head = parse_statement();
-        if (head)
-        {
-            head->next = parse_statementList();
-        }
-        return head;
-    }
-    else
-    {
+static struct ASTNode *reduce_private(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)values;
+    return create_visibility_node(&ctx->ast, "private", start);
+}
 
-        return NULL;
-    }
+static struct ASTNode *reduce_attribute_decl(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_node(&ctx->ast, NODE_ATTRIBUTE_DECL, values[0].node, NULL, start);
 }
 
-struct ASTNode *parse_expr()
+static struct ASTNode *reduce_impl_def(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
+    return create_impl_def(&ctx->ast, values[0].token.name, values[1].list.head, start);
+}
 
-    struct ASTNode *left_arith = parse_arithExpr();
+static struct ASTNode *reduce_func_def(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_func_def(&ctx->ast, values[0].node, values[1].node, start);
+}
 
-    return parse_exprRest(left_arith);
+static struct ASTNode *reduce_func_head(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_func_head(&ctx->ast, 0, values[0].token.name, values[1].node, values[2].node, start);
 }
 
-struct ASTNode *parse_exprRest(struct ASTNode *left_arith)
+static struct ASTNode *reduce_constructor_head(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
-    if (lookahead == EQ_OP || lookahead == NE_OP || lookahead == LT_OP ||
-        lookahead == GT_OP || lookahead == LE_OP || lookahead == GE_OP)
-    {
+    struct ASTNode *ret_type = create_type_node(&ctx->ast, NAME_VOID, start);
+    return create_func_head(&ctx->ast, 1, NAME_CONSTRUCTOR, values[0].node, ret_type, start);
+}
 
-        int op = lookahead;
-        parse_relOp();
-        struct ASTNode *right_arith = parse_arithExpr();
+static struct ASTNode *reduce_void_type(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)values;
+    return create_type_node(&ctx->ast, NAME_VOID, start);
+}
 
-        return create_bin_op(op, left_arith, right_arith);
-    }
-    else
-    {
+static struct ASTNode *reduce_integer_type(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)values;
+    return create_type_node(&ctx->ast, NAME_INTEGER, start);
+}
 
-        return left_arith;
-    }
+static struct ASTNode *reduce_float_type(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)values;
+    return create_type_node(&ctx->ast, NAME_FLOAT, start);
 }
 
-void parse_relOp()
+static struct ASTNode *reduce_string_type(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
+    (void)values;
+    return create_type_node(&ctx->ast, NAME_STRING, start);
+}
 
-    switch (lookahead)
-    {
-    case EQ_OP:
-        match(EQ_OP);
-        break;
-    case NE_OP:
-        match(NE_OP);
-        break;
-    case LT_OP:
-        match(LT_OP);
-        break;
-    case GT_OP:
-        match(GT_OP);
-        break;
-    case LE_OP:
-        match(LE_OP);
-        break;
-    case GE_OP:
-        match(GE_OP);
-        break;
-    default:
-        error("Expected relational operator");
-    }
+static struct ASTNode *reduce_params(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)ctx;
+    (void)start;
+    struct ASTNode *head = values[0].node;
+    head->next = values[1].list.head;
+    return head;
 }
 
-struct ASTNode *parse_arithExpr()
+static struct ASTNode *reduce_var_decl(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
+    return create_var_decl(&ctx->ast, values[0].token.name, values[1].node, values[2].list.head, start);
+}
+
+static struct ASTNode *reduce_func_body(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_node(&ctx->ast, NODE_FUNC_BODY, values[0].list.head, NULL, start);
+}
 
-    struct ASTNode *left_term = parse_term();
+static struct ASTNode *reduce_int_lit(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    (void)start;
+    return create_int_lit(&ctx->ast, values[0].token.value.int_value, values[0].token.offset);
+}
 
-    return parse_arithExprPrime(left_term);
+static struct ASTNode *reduce_if(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_if_node(&ctx->ast, values[0].node, values[1].node, values[2].node, start);
 }
 
-struct ASTNode *parse_arithExprPrime(struct ASTNode *left_term)
+static struct ASTNode *reduce_while(CompileContext *ctx, const LLValue *values, unsigned int start)
 {
-    if (lookahead == PLUS_OP || lookahead == MINUS_OP ||
-        (lookahead == KEYWORD && strcmp(current_lexeme, "or") == 0))
-    {
+    return create_while_node(&ctx->ast, values[0].node, values[1].node, start);
+}
 
-        int op = lookahead;
-        parse_addOp();
-        struct ASTNode *right_term = parse_term();
+static struct ASTNode *reduce_read(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_read_node(&ctx->ast, values[0].node, start);
+}
 
-        struct ASTNode *new_left = create_bin_op(op, left_term, right_term);
+static struct ASTNode *reduce_write(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_write_node(&ctx->ast, values[0].node, start);
+}
 
-        return parse_arithExprPrime(new_left);
-    }
-    else
-    {
+static struct ASTNode *reduce_return(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_return_node(&ctx->ast, values[0].node, start);
+}
 
-        return left_term;
-    }
+static struct ASTNode *reduce_stat_block(CompileContext *ctx, const LLValue *values, unsigned int start)
+{
+    return create_node(&ctx->ast, NODE_STAT_BLOCK, values[0].list.head, NULL, start);
 }
 
-void parse_addOp()
+/* Keywords that cannot start a statement leave it empty without an
+   error; any other token is reported and left to recovery */
+static void unexpected_statement(CompileContext *ctx)
 {
-    if (lookahead == PLUS_OP)
+    if (IS_KEYWORD_TOKEN(ctx->lookahead))
     {
-        match(PLUS_OP);
+        return;
     }
-    else if (lookahead == MINUS_OP)
+    error(ctx, "Syntax error: Unexpected token in statement");
+}
+
+/* A statement starting with an identifier is a call or, when the
+   expression is a variable, an assignment to it */
+struct ASTNode *parse_assignOrCall(CompileContext *ctx)
+{
+    unsigned int start = ctx->current_token.offset;
+
+    struct ASTNode *expr_node = parse_expr(ctx);
+    if (expr_node->type == NODE_FUNC_CALL)
     {
-        match(MINUS_OP);
+        match(ctx, SEMICOLON);
+        return expr_node;
     }
-    else if (lookahead == KEYWORD && strcmp(current_lexeme, "or") == 0)
+    else if (expr_node->type == NODE_VARIABLE)
     {
-        match(KEYWORD);
+        match(ctx, ASSIGN_OP);
+        struct ASTNode *rhs_expr = parse_expr(ctx);
+        match(ctx, SEMICOLON);
+        return create_assign_node(&ctx->ast, expr_node, rhs_expr, start);
     }
     else
     {
-        error("Expected +, -, or or");
+        error(ctx, "Syntax error: Statement must be an assignment or function call");
+        return NULL;
     }
 }
 
-struct ASTNode *parse_term()
+/* Binding power of the binary operators, indexed from EQ_OP; other tokens
+   bind at PREC_NONE and end an expression */
+enum
+{
+    PREC_NONE,
+    PREC_RELATIONAL,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE
+};
+
+static const unsigned char binary_precedence[AND_OP - EQ_OP + 1] = {
+    [EQ_OP - EQ_OP] = PREC_RELATIONAL,
+    [NE_OP - EQ_OP] = PREC_RELATIONAL,
+    [LE_OP - EQ_OP] = PREC_RELATIONAL,
+    [GE_OP - EQ_OP] = PREC_RELATIONAL,
+    [LT_OP - EQ_OP] = PREC_RELATIONAL,
+    [GT_OP - EQ_OP] = PREC_RELATIONAL,
+    [PLUS_OP - EQ_OP] = PREC_ADDITIVE,
+    [MINUS_OP - EQ_OP] = PREC_ADDITIVE,
+    [OR_OP - EQ_OP] = PREC_ADDITIVE,
+    [MULT_OP - EQ_OP] = PREC_MULTIPLICATIVE,
+    [DIV_OP - EQ_OP] = PREC_MULTIPLICATIVE,
+    [AND_OP - EQ_OP] = PREC_MULTIPLICATIVE,
+};
+
+static int precedence_of(int token)
 {
+    return token >= EQ_OP && token <= AND_OP ? binary_precedence[token - EQ_OP] : PREC_NONE;
+}
 
-    struct ASTNode *left_factor = parse_factor();
+/* expr -> arithExpr [relOp arithExpr] */
+struct ASTNode *parse_expr(CompileContext *ctx)
+{
 
-    return parse_termPrime(left_factor);
+    return parse_binary(ctx, PREC_RELATIONAL);
 }
 
-struct ASTNode *parse_termPrime(struct ASTNode *left_factor)
+/* arithExpr -> term {addOp term}, term -> factor {multOp factor} */
+struct ASTNode *parse_arithExpr(CompileContext *ctx)
 {
-    if (lookahead == MULT_OP || lookahead == DIV_OP ||
-        (lookahead == KEYWORD && strcmp(current_lexeme, "and") == 0))
-    {
 
-        int op = lookahead;
-        parse_multOp();
-        struct ASTNode *right_factor = parse_factor();
+    return parse_binary(ctx, PREC_ADDITIVE);
+}
 
-        struct ASTNode *new_left = create_bin_op(op, left_factor, right_factor);
+/* Precedence climbing: folds every operator binding at least as tightly as
+   min_prec into the left operand, parsing its right operand one level
+   tighter so equal operators associate to the left. Relational operators
+   do not chain, so nothing is folded after one. */
+struct ASTNode *parse_binary(CompileContext *ctx, int min_prec)
+{
 
-        return parse_termPrime(new_left);
-    }
-    else
+    struct ASTNode *left = parse_factor(ctx);
+    int max_prec = PREC_MULTIPLICATIVE;
+
+    for (;;)
     {
+        int prec = precedence_of(ctx->lookahead);
+        if (prec < min_prec || prec > max_prec)
+        {
+            return left;
+        }
 
-        return left_factor;
-    }
-}
+        unsigned int start = ctx->current_token.offset;
+        int op = ctx->lookahead;
+        match(ctx, op);
+        struct ASTNode *right = parse_binary(ctx, prec + 1);
 
-void parse_multOp()
-{
-    if (lookahead == MULT_OP)
-    {
-        match(MULT_OP);
-    }
-    else if (lookahead == DIV_OP)
-    {
-        match(DIV_OP);
-    }
-    else if (lookahead == KEYWORD && strcmp(current_lexeme, "and") == 0)
-    {
-        match(KEYWORD);
-    }
-    else
-    {
-        error("Expected *, /, or and");
+        left = create_bin_op(&ctx->ast, op, left, right, left != NULL ? left->offset : start);
+        if (prec == PREC_RELATIONAL)
+        {
+            max_prec = PREC_NONE;
+        }
     }
 }
 
-struct ASTNode *parse_factor()
+struct ASTNode *parse_factor(CompileContext *ctx)
 {
-    if (lookahead == IDENTIFIER)
+    unsigned int start = ctx->current_token.offset;
+    switch (ctx->lookahead)
+    {
+    case IDENTIFIER:
     {
-        char *id = strdup(current_lexeme);
-        match(IDENTIFIER);
+        const char *id = lexeme_intern(ctx);
+        match(ctx, IDENTIFIER);
 
-        if (lookahead == LPAREN)
+        if (ctx->lookahead == LPAREN)
         {
 
-            match(LPAREN);
-            struct ASTNode *args = parse_aParams();
-            match(RPAREN);
+            match(ctx, LPAREN);
+            struct ASTNode *args = parse_aParams(ctx);
+            match(ctx, RPAREN);
 
-            return create_func_call(id, NULL, args);
+            return create_func_call(&ctx->ast, id, NULL, args, start);
         }
         else
         {
 
-            struct ASTNode *id_node = create_id_node(id);
-            struct ASTNode *indices = parse_indiceList();
+            struct ASTNode *id_node = create_id_node(&ctx->ast, id, start);
+            struct ASTNode *indices = parse_indiceList(ctx);
 
-            return create_var_node(id_node, indices, NULL);
+            return create_var_node(&ctx->ast, id_node, indices, NULL, start);
         }
     }
-    else if (lookahead == INTEGER_LIT)
+    case INTEGER_LIT:
     {
 
-        int val = atoi(current_lexeme);
-        match(INTEGER_LIT);
-        return create_int_lit(val);
+        int val = ctx->current_token.value.int_value;
+        match(ctx, INTEGER_LIT);
+        return create_int_lit(&ctx->ast, val, start);
     }
-    else if (lookahead == FLOAT_LIT)
+    case FLOAT_LIT:
     {
 
-        float val = atof(current_lexeme);
-        match(FLOAT_LIT);
-        return create_float_lit(val);
+        float val = ctx->current_token.value.float_value;
+        match(ctx, FLOAT_LIT);
+        return create_float_lit(&ctx->ast, val, start);
     }
-    else if (lookahead == STRING_LIT)
+    case STRING_LIT:
     {
 
-        char *val = strdup(current_lexeme);
-        match(STRING_LIT);
-        return create_string_lit(val);
+        const char *val = lexeme_intern(ctx);
+        match(ctx, STRING_LIT);
+        return create_string_lit(&ctx->ast, val, start);
     }
-    else if (lookahead == LPAREN)
+    case LPAREN:
     {
 
-        match(LPAREN);
-        struct ASTNode *expr = parse_arithExpr();
-        match(RPAREN);
+        match(ctx, LPAREN);
+        struct ASTNode *expr = parse_arithExpr(ctx);
+        match(ctx, RPAREN);
         return expr;
     }
-    else if (lookahead == KEYWORD && strcmp(current_lexeme, "not") == 0)
+    case NOT_OP:
     {
 
-        match(KEYWORD);
-        struct ASTNode *operand = parse_factor();
+        match(ctx, NOT_OP);
+        struct ASTNode *operand = parse_factor(ctx);
 
-        return create_unary_op(NOT_OP, operand);
+        return create_unary_op(&ctx->ast, NOT_OP, operand, start);
     }
-    else if (lookahead == PLUS_OP || lookahead == MINUS_OP)
+    case PLUS_OP:
+    case MINUS_OP:
     {
 
-        int op = lookahead;
-        parse_sign();
-        struct ASTNode *operand = parse_factor();
+        int op = ctx->lookahead;
+        parse_sign(ctx);
+        struct ASTNode *operand = parse_factor(ctx);
 
-        return create_unary_op(op, operand);
+        return create_unary_op(&ctx->ast, op, operand, start);
     }
-    else
-    {
-        error("Expected factor");
+    default:
+        error(ctx, "Expected factor");
         return NULL;
     }
 }
 
-struct ASTNode *parse_sign()
+struct ASTNode *parse_sign(CompileContext *ctx)
 {
-    if (lookahead == PLUS_OP)
+    unsigned int start = ctx->current_token.offset;
+    if (ctx->lookahead == PLUS_OP)
     {
-        match(PLUS_OP);
-        return create_op_node(PLUS_OP);
+        match(ctx, PLUS_OP);
+        return create_op_node(&ctx->ast, PLUS_OP, start);
     }
-    else if (lookahead == MINUS_OP)
+    else if (ctx->lookahead == MINUS_OP)
     {
-        match(MINUS_OP);
-        return create_op_node(MINUS_OP);
+        match(ctx, MINUS_OP);
+        return create_op_node(&ctx->ast, MINUS_OP, start);
     }
     else
     {
-        error("Expected + or -");
+        error(ctx, "Expected + or -");
         return NULL;
     }
 }
 
-struct ASTNode *parse_variable()
+struct ASTNode *parse_variable(CompileContext *ctx)
 {
+    unsigned int start = ctx->current_token.offset;
 
-    struct ASTNode *var_base = parse_idOrSelf();
-    struct ASTNode *indices = parse_indiceList();
-    struct ASTNode *members = parse_idnestList();
+    struct ASTNode *var_base = parse_idOrSelf(ctx);
+    struct ASTNode *indices = parse_indiceList(ctx);
+    struct ASTNode *members = parse_idnestList(ctx);
 
-    return create_var_node(var_base, indices, members);
+    return create_var_node(&ctx->ast, var_base, indices, members, start);
 }
 
-struct ASTNode *parse_idnestList()
+struct ASTNode *parse_idnestList(CompileContext *ctx)
 {
-    if (lookahead == COMMA)
+    struct ASTNode *head = NULL;
+    struct ASTNode **tail = &head;
+    while (ctx->lookahead == COMMA)
     {
 
-        match(COMMA);
-        struct ASTNode *head = parse_idOrSelf();
-        struct ASTNode *indices = parse_indiceList();
-
-        struct ASTNode *nested_var = create_var_node(head, indices, NULL);
-        nested_var->next = parse_idnestList();
-        return nested_var;
-    }
-    else
-    {
+        match(ctx, COMMA);
+        unsigned int member_start = ctx->current_token.offset;
+        struct ASTNode *member = parse_idOrSelf(ctx);
+        struct ASTNode *indices = parse_indiceList(ctx);
 
-        return NULL;
+        list_append(&tail, create_var_node(&ctx->ast, member, indices, NULL, member_start));
     }
+    return head;
 }
 
-struct ASTNode *parse_indiceList()
+struct ASTNode *parse_indiceList(CompileContext *ctx)
 {
-    if (lookahead == LBRACKET)
+    struct ASTNode *head = NULL;
+    struct ASTNode **tail = &head;
+    while (ctx->lookahead == LBRACKET)
     {
 
-        struct ASTNode *head = parse_indice();
-        if (head)
+        if (!list_append(&tail, parse_indice(ctx)))
         {
-            head->next = parse_indiceList();
+            break;
         }
-        return head;
-    }
-    else
-    {
-
-        return NULL;
     }
+    return head;
 }
 
-struct ASTNode *parse_indice()
+struct ASTNode *parse_indice(CompileContext *ctx)
 {
 
-    match(LBRACKET);
-    struct ASTNode *expr = parse_arithExpr();
-    match(RBRACKET);
+    match(ctx, LBRACKET);
+    struct ASTNode *expr = parse_arithExpr(ctx);
+    match(ctx, RBRACKET);
     return expr;
 }
 
-struct ASTNode *parse_functionCall()
+struct ASTNode *parse_functionCall(CompileContext *ctx)
 {
+    unsigned int start = ctx->current_token.offset;
 
-    struct ASTNode *idnest = parse_idnestList();
-    char *id = strdup(current_lexeme);
-    match(IDENTIFIER);
-    match(LPAREN);
-    struct ASTNode *args = parse_aParams();
-    match(RPAREN);
-
-    return create_func_call(id, idnest, args);
-}
+    struct ASTNode *idnest = parse_idnestList(ctx);
+    const char *id = lexeme_intern(ctx);
+    match(ctx, IDENTIFIER);
+    match(ctx, LPAREN);
+    struct ASTNode *args = parse_aParams(ctx);
+    match(ctx, RPAREN);
 
-struct ASTNode *parse_idOrSelf()
-{
-    char *id_name;
-    if (lookahead == IDENTIFIER)
-    {
-        id_name = strdup(current_lexeme);
-        match(IDENTIFIER);
-    }
-    else if (lookahead == KEYWORD && strcmp(current_lexeme, "self") == 0)
-    {
-        id_name = strdup(current_lexeme);
-        match(KEYWORD);
-    }
-    else
-    {
-        error("Expected id or self");
-        return NULL;
-    }
-    return create_id_node(id_name);
+    return create_func_call(&ctx->ast, id, idnest, args, start);
 }
 
-struct ASTNode *parse_fParams()
+struct ASTNode *parse_idOrSelf(CompileContext *ctx)
 {
-    if (lookahead == IDENTIFIER)
+    unsigned int start = ctx->current_token.offset;
+    const char *id_name;
+    switch (ctx->lookahead)
     {
-
-        char *id = strdup(current_lexeme);
-        match(IDENTIFIER);
-        match(COLON);
-        struct ASTNode *type = parse_type();
-        struct ASTNode *dims = parse_arraySizeList();
-
-        struct ASTNode *head = create_var_decl(id, type, dims);
-
-        head->next = parse_fParamsTailList();
-        return head;
-    }
-    else
-    {
-
+    case IDENTIFIER:
+        id_name = lexeme_intern(ctx);
+        match(ctx, IDENTIFIER);
+        break;
+    case SELF_KW:
+        id_name = lexeme_intern(ctx);
+        match(ctx, SELF_KW);
+        break;
+    default:
+        error(ctx, "Expected id or self");
         return NULL;
     }
+    return create_id_node(&ctx->ast, id_name, start);
 }
 
-struct ASTNode *parse_fParamsTailList()
+struct ASTNode *parse_aParams(CompileContext *ctx)
 {
-    if (lookahead == COMMA)
-    {
-
-        struct ASTNode *head = parse_fParamsTail();
-        if (head)
-        {
-            head->next = parse_fParamsTailList();
-        }
-        return head;
-    }
-    else
+    switch (ctx->lookahead)
     {
-
-        return NULL;
-    }
-}
-
-struct ASTNode *parse_fParamsTail()
-{
-
-    match(COMMA);
-    char *id = strdup(current_lexeme);
-    match(IDENTIFIER);
-    match(COLON);
-    struct ASTNode *type = parse_type();
-    struct ASTNode *dims = parse_arraySizeList();
-
-    return create_var_decl(id, type, dims);
-}
-
-struct ASTNode *parse_aParams()
-{
-    if (lookahead == IDENTIFIER || lookahead == INTEGER_LIT || lookahead == FLOAT_LIT ||
-        lookahead == STRING_LIT ||
-        lookahead == LPAREN || lookahead == PLUS_OP || lookahead == MINUS_OP ||
-        (lookahead == KEYWORD && strcmp(current_lexeme, "not") == 0))
+    case IDENTIFIER:
+    case INTEGER_LIT:
+    case FLOAT_LIT:
+    case STRING_LIT:
+    case LPAREN:
+    case PLUS_OP:
+    case MINUS_OP:
+    case NOT_OP:
     {
 
-        struct ASTNode *head = parse_expr();
+        struct ASTNode *head = parse_expr(ctx);
         if (head)
         {
-            head->next = parse_aParamsTailList();
+            head->next = parse_aParamsTailList(ctx);
         }
         return head;
     }
-    else
-    {
+    default:
 
         return NULL;
     }
 }
 
-struct ASTNode *parse_aParamsTailList()
+struct ASTNode *parse_aParamsTailList(CompileContext *ctx)
 {
-    if (lookahead == COMMA)
+    struct ASTNode *head = NULL;
+    struct ASTNode **tail = &head;
+    while (ctx->lookahead == COMMA)
     {
 
-        struct ASTNode *head = parse_aParamsTail();
-        if (head)
+        if (!list_append(&tail, parse_aParamsTail(ctx)))
         {
-            head->next = parse_aParamsTailList();
+            break;
         }
-        return head;
-    }
-    else
-    {
-
-        return NULL;
     }
+    return head;
 }
 
-struct ASTNode *parse_aParamsTail()
+struct ASTNode *parse_aParamsTail(CompileContext *ctx)
 {
 
-    match(COMMA);
-    return parse_expr();
+    match(ctx, COMMA);
+    return parse_expr(ctx);
 }
\ No newline at end of file
@@ -2,330 +2,529 @@
 #include "error_logger.h"
 #include "tokens.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-static char *get_expression_type(struct ASTNode *node, SymbolTable *st);
+static const char *get_expression_type(CompactAst *ast, AstId node, unsigned int at, SymbolTable *st);
+static void type_check_items(CompactAst *ast, AstList list, unsigned int from, SymbolTable *st);
 
-void build_symbol_table_pass(struct ASTNode *node, SymbolTable *st)
+void declare_function(CompactAst *ast, AstId node, SymbolTable *st)
 {
-    if (node == NULL)
-        return;
+    AstFuncDef *func_def = (AstFuncDef *)ast_record(ast, node);
+    AstFuncHead *head = (AstFuncHead *)ast_record(ast, func_def->head);
 
-    switch (node->type)
+    const char *func_type;
+    if (head->return_type)
     {
-
-    case NODE_FUNC_DEF:
+        func_type = ast_node_name(ast, head->return_type);
+    }
+    else
     {
-        struct FuncDefNode *func_def = (struct FuncDefNode *)node;
-        struct FuncHeadNode *head = (struct FuncHeadNode *)func_def->func_head;
+        func_type = NAME_CONSTRUCTOR;
+    }
 
-        char *func_type;
-        if (head->return_type)
-        {
-            func_type = ((struct IdentifierNode *)head->return_type)->name;
-        }
-        else
+    const char **param_types = NULL;
+    if (head->params.count > 0)
+    {
+        param_types = (const char **)malloc(head->params.count * sizeof(const char *));
+        for (unsigned int i = 0; i < head->params.count; i++)
         {
-            func_type = "constructor";
+            AstVarDecl *param_decl = (AstVarDecl *)ast_record(ast, ast_item(ast, head->params, i));
+            param_types[i] = ast_node_name(ast, param_decl->type);
         }
+    }
 
-        insert_symbol(st, head->id, func_type, KIND_FUNCTION, head->line_number, head->params);
-
-        enter_scope(st, head->id);
-        node->scope = st->current_scope;
+    insert_symbol(st, ast_name(ast, head->name), func_type, KIND_FUNCTION, ast->offset[func_def->head],
+                  param_types, head->params.count);
+}
 
-        build_symbol_table_pass(head->params, st);
-        build_symbol_table_pass(func_def->func_body, st);
+/* Enters the scope of a function's parameters and body; returns 0, and
+   enters nothing, for a body with syntax errors, which is not checked */
+static int enter_function_scope(CompactAst *ast, AstId node, SymbolTable *st)
+{
+    AstFuncDef *func_def = (AstFuncDef *)ast_record(ast, node);
+    AstFuncHead *head = (AstFuncHead *)ast_record(ast, func_def->head);
 
-        exit_scope(st);
-        break;
+    if (ast_kind(ast, func_def->body) == NODE_ERROR)
+    {
+        return 0;
     }
 
-    case NODE_VAR_DECL:
-    {
-        struct VarDeclNode *var_decl = (struct VarDeclNode *)node;
-        char *type_name = ((struct IdentifierNode *)var_decl->type_node)->name;
+    enter_scope(st, ast_name(ast, head->name));
+    ast->scopes[func_def->scope] = st->current_scope;
+    return 1;
+}
 
-        insert_symbol(st, var_decl->id, type_name, KIND_VAR, var_decl->line_number, NULL);
+static int symbols_enter_func_def(CompactAst *ast, AstId node, void *state)
+{
+    declare_function(ast, node, (SymbolTable *)state);
+    return enter_function_scope(ast, node, (SymbolTable *)state) ? AST_VISIT_CHILDREN : AST_VISIT_SKIP;
+}
 
-        build_symbol_table_pass(var_decl->array_dims, st);
-        break;
-    }
+static int symbols_enter_var_decl(CompactAst *ast, AstId node, void *state)
+{
+    AstVarDecl *var_decl = (AstVarDecl *)ast_record(ast, node);
+    const char *type_name = ast_node_name(ast, var_decl->type);
 
-    case NODE_STAT_BLOCK:
-    {
-        enter_scope(st, "stat_block");
-        node->scope = st->current_scope;
+    insert_symbol((SymbolTable *)state, ast_name(ast, var_decl->name), type_name, KIND_VAR, ast->offset[node],
+                  NULL, 0);
+    return AST_VISIT_SKIP;
+}
+
+static int symbols_enter_block(CompactAst *ast, AstId node, void *state)
+{
+    SymbolTable *st = (SymbolTable *)state;
+    enter_scope(st, NAME_STAT_BLOCK);
+    ast->scopes[((AstBlock *)ast_record(ast, node))->scope] = st->current_scope;
+    return AST_VISIT_CHILDREN;
+}
 
-        build_symbol_table_pass(((struct GenericNode *)node)->child1, st);
+static void symbols_leave_scope(CompactAst *ast, AstId node, void *state)
+{
+    (void)ast;
+    (void)node;
+    exit_scope((SymbolTable *)state);
+}
+
+/* Classes and implementations are not entered; nothing else below a
+   statement declares a name or opens a scope */
+static int symbols_skip(CompactAst *ast, AstId node, void *state)
+{
+    (void)ast;
+    (void)node;
+    (void)state;
+    return AST_VISIT_SKIP;
+}
 
+const AstVisitor symbol_table_visitor = {
+    .name = "symbols",
+    .pre =
+        {
+            [NODE_FUNC_DEF] = symbols_enter_func_def,
+            [NODE_VAR_DECL] = symbols_enter_var_decl,
+            [NODE_STAT_BLOCK] = symbols_enter_block,
+            [NODE_CLASS_DECL] = symbols_skip,
+            [NODE_IMPL_DEF] = symbols_skip,
+            [NODE_ATTRIBUTE_DECL] = symbols_skip,
+            [NODE_FUNC_DECL] = symbols_skip,
+            [NODE_READ_STMT] = symbols_skip,
+            [NODE_WRITE_STMT] = symbols_skip,
+            [NODE_RETURN_STMT] = symbols_skip,
+            [NODE_ASSIGN_STMT] = symbols_skip,
+            [NODE_BIN_OP] = symbols_skip,
+            [NODE_UNARY_OP] = symbols_skip,
+            [NODE_VARIABLE] = symbols_skip,
+            [NODE_FUNC_CALL] = symbols_skip,
+        },
+    .post =
+        {
+            [NODE_FUNC_DEF] = symbols_leave_scope,
+            [NODE_STAT_BLOCK] = symbols_leave_scope,
+        },
+};
+
+void build_function_scope(CompactAst *ast, AstId node, SymbolTable *st)
+{
+    if (enter_function_scope(ast, node, st))
+    {
+        AstFuncDef *func_def = (AstFuncDef *)ast_record(ast, node);
+        ast_visit(ast, func_def->head, &symbol_table_visitor, st);
+        ast_visit(ast, func_def->body, &symbol_table_visitor, st);
         exit_scope(st);
-        break;
     }
+}
 
-    case NODE_FUNC_BODY:
-    {
+void build_symbol_table_pass(CompactAst *ast, AstId node, SymbolTable *st)
+{
+    ast_visit(ast, node, &symbol_table_visitor, st);
+}
 
-        build_symbol_table_pass(((struct GenericNode *)node)->child1, st);
-        break;
-    }
+/* Uses are bound in source order, so the scope changes only at the edges
+   of functions and blocks. Those the first pass did not enter, in classes,
+   implementations and bodies with syntax errors, stay unbound. */
+void resolve_names_pass(CompactAst *ast, SymbolTable *st)
+{
+    for (int i = 0; i < ast->binding_count; i++)
+    {
+        Scope *scope = ast->scopes[ast->uses[i].scope];
+        if (scope == NULL)
+        {
+            continue;
+        }
+        if (scope != st->current_scope)
+        {
+            set_current_scope(st, scope);
+        }
 
-    case NODE_PROG:
-    case NODE_STATEMENT_LIST:
-    case NODE_PARAM_LIST:
-        build_symbol_table_pass(((struct GenericNode *)node)->child1, st);
-        build_symbol_table_pass(((struct GenericNode *)node)->child2, st);
-        break;
+        AstId node = ast->uses[i].node;
+        switch (ast_kind(ast, node))
+        {
+        case NODE_VARIABLE:
+        {
+            AstId base = ((AstVarAccess *)ast_record(ast, node))->base;
+            if (base != 0)
+            {
+                ast->bindings[i] = lookup_all_scopes(st, ast_node_name(ast, base));
+            }
+            break;
+        }
 
-    case NODE_IF_STMT:
-        build_symbol_table_pass(((struct IfNode *)node)->condition, st);
-        build_symbol_table_pass(((struct IfNode *)node)->if_body, st);
-        build_symbol_table_pass(((struct IfNode *)node)->else_body, st);
-        break;
+        case NODE_FUNC_CALL:
+            ast->bindings[i] = lookup_all_scopes(st, ast_name(ast, ((AstCall *)ast_record(ast, node))->name));
+            break;
 
-    case NODE_WHILE_STMT:
-        build_symbol_table_pass(((struct WhileNode *)node)->condition, st);
-        build_symbol_table_pass(((struct WhileNode *)node)->while_body, st);
-        break;
+        case NODE_RETURN_STMT:
 
-    case NODE_ASSIGN_STMT:
-        build_symbol_table_pass(((struct AssignNode *)node)->variable, st);
-        build_symbol_table_pass(((struct AssignNode *)node)->expression, st);
-        break;
+            /* By the name of the innermost scope, so inside a block this
+               finds no function */
+            ast->bindings[i] = lookup_all_scopes(st, scope->scope_name);
+            break;
 
-    default:
-        break;
+        default:
+            break;
+        }
     }
-
-    build_symbol_table_pass(node->next, st);
+    set_current_scope(st, st->global_scope);
 }
 
-static char *type_check_function_call(struct ASTNode *node, SymbolTable *st)
+static const char *type_check_function_call(CompactAst *ast, AstId node, SymbolTable *st)
 {
-    struct FuncCallNode *func_call = (struct FuncCallNode *)node;
+    AstCall *func_call = (AstCall *)ast_record(ast, node);
+    const char *func_name = ast_name(ast, func_call->name);
 
-    SymbolEntry *func_symbol = lookup_all_scopes(st, func_call->id);
+    SymbolEntry *func_symbol = ast->bindings[func_call->binding];
 
     if (func_symbol == NULL)
     {
         char buffer[256];
-        sprintf(buffer, "Undeclared function '%s'", func_call->id);
-        log_semantic_error(buffer, node->line_number);
-        return "error_type";
+        sprintf(buffer, "Undeclared function '%s'", func_name);
+        log_semantic_error(st->errors, buffer, ast->offset[node]);
+        return NAME_ERROR_TYPE;
     }
 
     if (func_symbol->kind != KIND_FUNCTION)
     {
         char buffer[256];
-        sprintf(buffer, "'%s' is not a function", func_call->id);
-        log_semantic_error(buffer, node->line_number);
-        return "error_type";
+        sprintf(buffer, "'%s' is not a function", func_name);
+        log_semantic_error(st->errors, buffer, ast->offset[node]);
+        return NAME_ERROR_TYPE;
     }
 
-    struct ASTNode *current_arg_node = func_call->args;
-
-    struct ASTNode *current_param_node = func_symbol->params;
+    AstList args = func_call->args;
+    unsigned int param_count = func_symbol->param_count;
 
-    while (current_arg_node != NULL && current_param_node != NULL)
+    unsigned int i = 0;
+    while (i < args.count && i < param_count)
     {
 
-        struct ASTNode *arg_expr = current_arg_node;
-        char *arg_type = get_expression_type(arg_expr, st);
+        AstId arg_expr = ast_item(ast, args, i);
+        unsigned int arg_at = ast_use_offset(ast, arg_expr, ast->offset[node]);
+        const char *arg_type = get_expression_type(ast, arg_expr, arg_at, st);
 
-        struct VarDeclNode *param_decl = (struct VarDeclNode *)current_param_node;
-        char *param_type = ((struct IdentifierNode *)param_decl->type_node)->name;
+        const char *param_type = func_symbol->param_types[i];
 
-        if (strcmp(arg_type, "error_type") != 0 && strcmp(arg_type, param_type) != 0)
+        if (arg_type != NAME_ERROR_TYPE && arg_type != param_type)
         {
 
-            if (strcmp(param_type, "float") == 0 && strcmp(arg_type, "integer") == 0)
+            if (param_type == NAME_FLOAT && arg_type == NAME_INTEGER)
             {
             }
             else
             {
                 char buffer[256];
                 sprintf(buffer, "Type mismatch in function call '%s': expected '%s' but got '%s'",
-                        func_call->id, param_type, arg_type);
-                log_semantic_error(buffer, arg_expr->line_number);
+                        func_name, param_type, arg_type);
+                log_semantic_error(st->errors, buffer, arg_at);
             }
         }
 
-        type_check_pass(arg_expr, st);
+        /* Like the rest of a statement list, the remaining arguments are
+           checked along with this one */
+        type_check_items(ast, args, i, st);
 
-        current_arg_node = current_arg_node->next;
-        current_param_node = current_param_node->next;
+        i++;
     }
 
-    if (current_arg_node != NULL)
+    if (i < args.count)
     {
-        log_semantic_error("Too many arguments to function", node->line_number);
+        log_semantic_error(st->errors, "Too many arguments to function", ast->offset[node]);
     }
-    if (current_param_node != NULL)
+    if (i < param_count)
     {
-        log_semantic_error("Too few arguments to function", node->line_number);
+        log_semantic_error(st->errors, "Too few arguments to function", ast->offset[node]);
     }
 
     return func_symbol->type;
 }
 
-static char *get_expression_type(struct ASTNode *node, SymbolTable *st)
+/* Type of a binary operation whose operand types are already known; its
+   errors are reported at offset at */
+static const char *bin_op_type(unsigned int at, unsigned int op,
+                               const char *left_type, const char *right_type, SymbolTable *st)
 {
-    if (node == NULL)
-        return "void";
-
-    switch (node->type)
+    if (left_type == NAME_ERROR_TYPE ||
+        right_type == NAME_ERROR_TYPE)
     {
-    case NODE_INT_LIT:
-        return "integer";
-
-    case NODE_FLOAT_LIT:
-        return "float";
-
-    case NODE_STRING_LIT:
-        return "string";
+        return NAME_ERROR_TYPE;
+    }
 
-    case NODE_ID:
+    switch (op)
     {
-        char *var_name = ((struct IdentifierNode *)node)->name;
-        SymbolEntry *symbol = lookup_all_scopes(st, var_name);
+    case PLUS_OP:
+    case MINUS_OP:
+    case MULT_OP:
+    case DIV_OP:
+        if ((left_type != NAME_INTEGER && left_type != NAME_FLOAT) ||
+            (right_type != NAME_INTEGER && right_type != NAME_FLOAT))
+        {
+            log_semantic_error(st->errors, "Operands for arithmetic op must be numeric", at);
+            return NAME_ERROR_TYPE;
+        }
+        if (left_type == NAME_FLOAT || right_type == NAME_FLOAT)
+        {
+            return NAME_FLOAT;
+        }
+        return NAME_INTEGER;
+
+    case EQ_OP:
+    case NE_OP:
+    case LT_OP:
+    case GT_OP:
+    case LE_OP:
+    case GE_OP:
+        if (left_type != right_type)
+        {
+            if (!((left_type == NAME_INTEGER && right_type == NAME_FLOAT) ||
+                  (left_type == NAME_FLOAT && right_type == NAME_INTEGER)))
+            {
+                log_semantic_error(st->errors, "Incompatible types for comparison", at);
+            }
+        }
+        return NAME_BOOLEAN;
 
-        if (symbol == NULL)
+    case AND_OP:
+    case OR_OP:
+        if (left_type != NAME_BOOLEAN || right_type != NAME_BOOLEAN)
         {
-            char buffer[256];
-            sprintf(buffer, "Undeclared variable '%s'", var_name);
-            log_semantic_error(buffer, node->line_number);
-            return "error_type";
+            log_semantic_error(st->errors, "Operands for logical op must be boolean", at);
+            return NAME_ERROR_TYPE;
         }
-        return symbol->type;
+        return NAME_BOOLEAN;
     }
+    return NAME_ERROR_TYPE;
+}
 
-    case NODE_VARIABLE:
-    {
-        struct VarAccessNode *var_node = (struct VarAccessNode *)node;
-        char *base_type = get_expression_type(var_node->base, st);
+/* An operator on the left spine of a chain and the offset it is reported at */
+typedef struct SpineUse
+{
+    AstId node;
+    unsigned int at;
+} SpineUse;
+
+/* Types a chain along its left spine; see AstBinary. Operands are typed
+   in the same order as a recursive walk. */
+static const char *bin_op_chain_type(CompactAst *ast, AstId node, unsigned int at, SymbolTable *st)
+{
+    SpineUse local[32];
+    SpineUse *spine = local;
+    int count = 0;
+    int capacity = 32;
 
-        if (var_node->indices != NULL)
+    while (node != 0 && ast_kind(ast, node) == NODE_BIN_OP)
+    {
+        if (count == capacity)
         {
-            struct ASTNode *currentIndex = var_node->indices;
-            while (currentIndex != NULL)
+            capacity *= 2;
+            if (spine == local)
             {
-
-                char *index_type = get_expression_type(currentIndex, st);
-
-                if (strcmp(index_type, "error_type") != 0 &&
-                    strcmp(index_type, "integer") != 0)
-                {
-                    char buffer[256];
-                    sprintf(buffer, "Array index must be an integer, but got '%s'", index_type);
-                    log_semantic_error(buffer, currentIndex->line_number);
-
-                    return "error_type";
-                }
-                currentIndex = currentIndex->next;
+                spine = (SpineUse *)malloc(capacity * sizeof(SpineUse));
+                memcpy(spine, local, sizeof(local));
+            }
+            else
+            {
+                spine = (SpineUse *)realloc(spine, capacity * sizeof(SpineUse));
             }
         }
-        return base_type;
+        spine[count].node = node;
+        spine[count].at = at;
+        count++;
+        node = ((AstBinary *)ast_record(ast, node))->left;
+        at = ast_use_offset(ast, node, at);
     }
 
-    case NODE_BIN_OP:
+    const char *left_type = get_expression_type(ast, node, at, st);
+    while (count > 0)
     {
-        struct BinOpNode *bin_op = (struct BinOpNode *)node;
-        char *left_type = get_expression_type(bin_op->left, st);
-        char *right_type = get_expression_type(bin_op->right, st);
+        SpineUse op = spine[--count];
+        AstBinary *bin_op = (AstBinary *)ast_record(ast, op.node);
+        const char *right_type = get_expression_type(ast, bin_op->right, ast_use_offset(ast, bin_op->right, op.at), st);
+        left_type = bin_op_type(op.at, bin_op->op, left_type, right_type, st);
+    }
 
-        if (strcmp(left_type, "error_type") == 0 ||
-            strcmp(right_type, "error_type") == 0)
-        {
-            return "error_type";
-        }
+    if (spine != local)
+    {
+        free(spine);
+    }
+    return left_type;
+}
 
-        switch (bin_op->op)
+/* at is the offset the node's errors are reported at */
+static const char *expression_type(CompactAst *ast, AstId node, unsigned int at, SymbolTable *st)
+{
+    if (node == 0)
+        return NAME_VOID;
+
+    switch (ast_kind(ast, node))
+    {
+    case NODE_INT_LIT:
+        return NAME_INTEGER;
+
+    case NODE_FLOAT_LIT:
+        return NAME_FLOAT;
+
+    case NODE_STRING_LIT:
+        return NAME_STRING;
+
+    case NODE_VARIABLE:
+    {
+        AstVarAccess *var_node = (AstVarAccess *)ast_record(ast, node);
+        const char *base_type = NAME_VOID;
+        if (var_node->base != 0)
         {
-        case PLUS_OP:
-        case MINUS_OP:
-        case MULT_OP:
-        case DIV_OP:
-            if ((strcmp(left_type, "integer") != 0 && strcmp(left_type, "float") != 0) ||
-                (strcmp(right_type, "integer") != 0 && strcmp(right_type, "float") != 0))
+            SymbolEntry *symbol = ast->bindings[var_node->binding];
+            if (symbol == NULL)
             {
-                log_semantic_error("Operands for arithmetic op must be numeric", node->line_number);
-                return "error_type";
+                char buffer[256];
+                sprintf(buffer, "Undeclared variable '%s'", ast_node_name(ast, var_node->base));
+                log_semantic_error(st->errors, buffer, ast_use_offset(ast, var_node->base, at));
+                base_type = NAME_ERROR_TYPE;
             }
-            if (strcmp(left_type, "float") == 0 || strcmp(right_type, "float") == 0)
+            else
             {
-                return "float";
+                base_type = symbol->type;
             }
-            return "integer";
-
-        case EQ_OP:
-        case NE_OP:
-        case LT_OP:
-        case GT_OP:
-        case LE_OP:
-        case GE_OP:
-            if (strcmp(left_type, right_type) != 0)
-            {
-                if (!((strcmp(left_type, "integer") == 0 && strcmp(right_type, "float") == 0) ||
-                      (strcmp(left_type, "float") == 0 && strcmp(right_type, "integer") == 0)))
-                {
-                    log_semantic_error("Incompatible types for comparison", node->line_number);
-                }
-            }
-            return "boolean";
+        }
 
-        case KEYWORD:
-            if (strcmp(current_lexeme, "and") == 0 || strcmp(current_lexeme, "or") == 0)
+        for (unsigned int i = 0; i < var_node->indices.count; i++)
+        {
+            AstId index = ast_item(ast, var_node->indices, i);
+            unsigned int index_at = ast_use_offset(ast, index, at);
+            const char *index_type = get_expression_type(ast, index, index_at, st);
+
+            if (index_type != NAME_ERROR_TYPE &&
+                index_type != NAME_INTEGER)
             {
-                if (strcmp(left_type, "boolean") != 0 || strcmp(right_type, "boolean") != 0)
-                {
-                    log_semantic_error("Operands for logical op must be boolean", node->line_number);
-                    return "error_type";
-                }
-                return "boolean";
+                char buffer[256];
+                sprintf(buffer, "Array index must be an integer, but got '%s'", index_type);
+                log_semantic_error(st->errors, buffer, index_at);
+
+                return NAME_ERROR_TYPE;
             }
-            break;
         }
-        break;
+        return base_type;
     }
+
+    case NODE_BIN_OP:
+        return bin_op_chain_type(ast, node, at, st);
+
     case NODE_FUNC_CALL:
     {
-        return type_check_function_call(node, st);
+        return type_check_function_call(ast, node, st);
     }
+    default:
+        break;
     }
-    return "error_type";
+    return NAME_ERROR_TYPE;
 }
 
-void type_check_pass(struct ASTNode *node, SymbolTable *st)
+/* With shared expressions a node is typed once. A type whose computation
+   logged errors is not kept, so each use reports them. */
+static const char *get_expression_type(CompactAst *ast, AstId node, unsigned int at, SymbolTable *st)
 {
-    if (node == NULL)
+    AstTypeMemo *memo = ast_type_memo(ast, node);
+    if (memo == NULL)
+    {
+        return expression_type(ast, node, at, st);
+    }
+    if (memo->type != NULL)
+    {
+        return memo->type;
+    }
+    int errors = st->errors->count;
+    const char *type = expression_type(ast, node, at, st);
+    if (st->errors->count == errors)
+    {
+        memo->type = type;
+    }
+    return type;
+}
+
+/* Statements waiting to be checked, last pushed first */
+typedef struct CheckStack
+{
+    AstId *nodes;
+    int count;
+    int capacity;
+} CheckStack;
+
+static void check_push(CheckStack *stack, AstId node)
+{
+    if (node == 0)
+    {
         return;
+    }
+    if (stack->count == stack->capacity)
+    {
+        stack->capacity = stack->capacity != 0 ? stack->capacity * 2 : 64;
+        stack->nodes = (AstId *)realloc(stack->nodes, stack->capacity * sizeof(AstId));
+    }
+    stack->nodes[stack->count++] = node;
+}
+
+/* In the order of push_list in ast_visit.c */
+static void check_push_list(CheckStack *stack, CompactAst *ast, AstList list)
+{
+    for (unsigned int i = list.count; i-- > 0;)
+    {
+        check_push(stack, ast_item(ast, list, i));
+    }
+}
 
-    if (node->scope != NULL)
+/* Below a statement only calls are checked, other than by typing */
+static void type_check_expression(CompactAst *ast, AstId node, SymbolTable *st)
+{
+    if (node != 0 && ast_kind(ast, node) == NODE_FUNC_CALL)
     {
-        st->current_scope = node->scope;
+        type_check_function_call(ast, node, st);
     }
+}
 
-    switch (node->type)
+/* Checks one node and pushes the statements under it */
+static void type_check_statement(CompactAst *ast, AstId node, SymbolTable *st, CheckStack *stack)
+{
+    switch (ast_kind(ast, node))
     {
     case NODE_ASSIGN_STMT:
     {
-        struct AssignNode *assign = (struct AssignNode *)node;
-        char *lhs_type = get_expression_type(assign->variable, st);
-        char *rhs_type = get_expression_type(assign->expression, st);
+        AstAssign *assign = (AstAssign *)ast_record(ast, node);
+        const char *lhs_type =
+            get_expression_type(ast, assign->variable, ast_use_offset(ast, assign->variable, ast->offset[node]), st);
+        const char *rhs_type =
+            get_expression_type(ast, assign->expression, ast_use_offset(ast, assign->expression, ast->offset[node]), st);
 
-        if (strcmp(lhs_type, "error_type") != 0 && strcmp(rhs_type, "error_type") != 0)
+        if (lhs_type != NAME_ERROR_TYPE && rhs_type != NAME_ERROR_TYPE)
         {
 
-            if (strcmp(lhs_type, rhs_type) != 0)
+            if (lhs_type != rhs_type)
             {
-                if (strcmp(lhs_type, "float") == 0 && strcmp(rhs_type, "integer") == 0)
+                if (lhs_type == NAME_FLOAT && rhs_type == NAME_INTEGER)
                 {
                 }
                 else
                 {
                     char buffer[256];
                     sprintf(buffer, "Type mismatch: cannot assign type '%s' to variable of type '%s'", rhs_type, lhs_type);
-                    log_semantic_error(buffer, node->line_number);
+                    log_semantic_error(st->errors, buffer, ast->offset[node]);
                 }
             }
         }
@@ -334,86 +533,85 @@ void type_check_pass(struct ASTNode *node, SymbolTable *st)
     case NODE_IF_STMT:
     case NODE_WHILE_STMT:
     {
-        struct ASTNode *condition;
-        if (node->type == NODE_IF_STMT)
+        AstId condition;
+        if (ast_kind(ast, node) == NODE_IF_STMT)
         {
-            condition = ((struct IfNode *)node)->condition;
+            condition = ((AstIf *)ast_record(ast, node))->condition;
         }
         else
         {
-            condition = ((struct WhileNode *)node)->condition;
+            condition = ((AstWhile *)ast_record(ast, node))->condition;
         }
 
-        char *cond_type = get_expression_type(condition, st);
-        if (strcmp(cond_type, "error_type") != 0 &&
-            strcmp(cond_type, "boolean") != 0)
+        unsigned int condition_at = ast_use_offset(ast, condition, ast->offset[node]);
+        const char *cond_type = get_expression_type(ast, condition, condition_at, st);
+        if (cond_type != NAME_ERROR_TYPE &&
+            cond_type != NAME_BOOLEAN)
         {
-            log_semantic_error("Condition expression must be of type boolean", condition->line_number);
+            log_semantic_error(st->errors, "Condition expression must be of type boolean", condition_at);
         }
 
-        if (node->type == NODE_IF_STMT)
+        if (ast_kind(ast, node) == NODE_IF_STMT)
         {
-            type_check_pass(((struct IfNode *)node)->if_body, st);
-            type_check_pass(((struct IfNode *)node)->else_body, st);
+            check_push(stack, ((AstIf *)ast_record(ast, node))->else_body);
+            check_push(stack, ((AstIf *)ast_record(ast, node))->then_body);
         }
         else
         {
-            type_check_pass(((struct WhileNode *)node)->while_body, st);
+            check_push(stack, ((AstWhile *)ast_record(ast, node))->body);
         }
         break;
     }
 
     case NODE_PROG:
     case NODE_FUNC_BODY:
-    case NODE_STATEMENT_LIST:
-    case NODE_STAT_BLOCK:
 
-        type_check_pass(((struct GenericNode *)node)->child1, st);
-        type_check_pass(((struct GenericNode *)node)->child2, st);
+        check_push_list(stack, ast, ast_list(ast, node));
         break;
 
-    case NODE_FUNC_DEF:
-    {
+    case NODE_STAT_BLOCK:
 
-        Scope *old_scope = st->current_scope;
-        st->current_scope = node->scope;
+        check_push_list(stack, ast, ((AstBlock *)ast_record(ast, node))->items);
+        break;
 
-        type_check_pass(((struct FuncDefNode *)node)->func_body, st);
+    case NODE_FUNC_DEF:
 
-        st->current_scope = old_scope;
+        /* A body with syntax errors checks nothing */
+        check_push(stack, ((AstFuncDef *)ast_record(ast, node))->body);
         break;
-    }
 
     case NODE_WRITE_STMT:
 
-        type_check_pass(((struct GenericNode *)node)->child1, st);
+        type_check_expression(ast, ast_child(ast, node), st);
         break;
 
     case NODE_RETURN_STMT:
     {
-        struct ASTNode *return_expr = ((struct GenericNode *)node)->child1;
+        AstReturn *return_stmt = (AstReturn *)ast_record(ast, node);
+        AstId return_expr = return_stmt->value;
 
-        type_check_pass(return_expr, st);
+        type_check_expression(ast, return_expr, st);
 
-        char *actual_return_type = "void";
-        if (return_expr != NULL)
+        const char *actual_return_type = NAME_VOID;
+        if (return_expr != 0)
         {
-            actual_return_type = get_expression_type(return_expr, st);
+            actual_return_type =
+                get_expression_type(ast, return_expr, ast_use_offset(ast, return_expr, ast->offset[node]), st);
         }
 
-        SymbolEntry *func_symbol = lookup_all_scopes(st, st->current_scope->scope_name);
+        SymbolEntry *func_symbol = ast->bindings[return_stmt->binding];
 
         if (func_symbol == NULL)
         {
-            log_semantic_error("Compiler Bug: Cannot find symbol for current function", node->line_number);
+            log_semantic_error(st->errors, "Compiler Bug: Cannot find symbol for current function", ast->offset[node]);
             break;
         }
-        char *expected_return_type = func_symbol->type;
+        const char *expected_return_type = func_symbol->type;
 
-        if (strcmp(actual_return_type, "error_type") != 0 &&
-            strcmp(expected_return_type, actual_return_type) != 0)
+        if (actual_return_type != NAME_ERROR_TYPE &&
+            expected_return_type != actual_return_type)
         {
-            if (strcmp(expected_return_type, "float") == 0 && strcmp(actual_return_type, "integer") == 0)
+            if (expected_return_type == NAME_FLOAT && actual_return_type == NAME_INTEGER)
             {
             }
             else
@@ -422,7 +620,7 @@ void type_check_pass(struct ASTNode *node, SymbolTable *st)
                 char buffer[256];
                 sprintf(buffer, "Return type mismatch: function expects '%s' but returns '%s'",
                         expected_return_type, actual_return_type);
-                log_semantic_error(buffer, node->line_number);
+                log_semantic_error(st->errors, buffer, ast->offset[node]);
             }
         }
         break;
@@ -434,18 +632,35 @@ void type_check_pass(struct ASTNode *node, SymbolTable *st)
 
     case NODE_FUNC_CALL:
     {
-        type_check_function_call(node, st);
+        type_check_function_call(ast, node, st);
         break;
     }
 
     default:
         break;
     }
+}
 
-    type_check_pass(node->next, st);
+/* Names were bound by resolve_names_pass, so no scope is searched. Bodies
+   nest one level per block, if or while, so the statements wait on an
+   explicit stack rather than in a C frame per level. */
+void type_check_pass(CompactAst *ast, AstId node, SymbolTable *st)
+{
+    CheckStack stack = {NULL, 0, 0};
+    check_push(&stack, node);
+    while (stack.count > 0)
+    {
+        AstId next = stack.nodes[--stack.count];
+        type_check_statement(ast, next, st, &stack);
+    }
+    free(stack.nodes);
+}
 
-    if (node->scope != NULL)
+static void type_check_items(CompactAst *ast, AstList list, unsigned int from, SymbolTable *st)
+{
+    for (unsigned int i = from; i < list.count; i++)
     {
-        exit_scope(st);
+        type_check_expression(ast, ast_item(ast, list, i), st);
     }
-}
\ No newline at end of file
+}
+
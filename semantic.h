@@ -2,11 +2,29 @@
 #ifndef SEMANTIC_H
 #define SEMANTIC_H
 
-#include "ast.h"
+#include "ast_visit.h"
+#include "compact_ast.h"
 #include "symbol_table.h"
 
-void build_symbol_table_pass(struct ASTNode *node, SymbolTable *st);
+void build_symbol_table_pass(CompactAst *ast, AstId node, SymbolTable *st);
 
-void type_check_pass(struct ASTNode *node, SymbolTable *st);
+/* The first pass as a visitor whose state is the SymbolTable, so a walk
+   can run other analyses along with it */
+extern const AstVisitor symbol_table_visitor;
+
+/* Binds every variable, call and return in the tree to its symbol table
+   entry, once the first pass has declared everything; type checking then
+   reads the bindings instead of searching scopes. Logs nothing. */
+void resolve_names_pass(CompactAst *ast, SymbolTable *st);
+
+void type_check_pass(CompactAst *ast, AstId node, SymbolTable *st);
+
+/* The two halves of the first pass over a function definition: its entry
+   in the current scope, then the scope of its parameters and body. A
+   streaming compilation declares every function before building any
+   function's scope. */
+void declare_function(CompactAst *ast, AstId node, SymbolTable *st);
+
+void build_function_scope(CompactAst *ast, AstId node, SymbolTable *st);
 
 #endif
\ No newline at end of file
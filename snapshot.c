@@ -0,0 +1,334 @@
+#include "snapshot.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+static const char snapshot_magic[8] = "ASTSNAP";
+
+typedef struct SnapshotHeader
+{
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned long long source_hash;
+    unsigned long long source_size;
+    unsigned int node_count;
+    unsigned int pool_count;
+    unsigned int item_count;
+    unsigned int name_count;
+    unsigned int string_bytes;
+    unsigned int scope_count;
+    unsigned int binding_count;
+    unsigned int line_count;
+    unsigned int parent_line_words; /* 0 unless expressions are shared */
+    AstId root;
+} SnapshotHeader;
+
+/* Byte offset of each section; every section starts 8-byte aligned */
+typedef struct SnapshotLayout
+{
+    size_t kind;
+    size_t offset;
+    size_t word;
+    size_t pool;
+    size_t items;
+    size_t uses;
+    size_t parent_lines;
+    size_t lines;
+    size_t name_starts; /* name_count + 1 offsets into the strings */
+    size_t strings;
+    size_t size;
+} SnapshotLayout;
+
+static size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+static void snapshot_layout(const SnapshotHeader *header, SnapshotLayout *layout)
+{
+    size_t at = align8(sizeof(SnapshotHeader));
+    layout->kind = at;
+    at = align8(at + header->node_count * sizeof(unsigned char));
+    layout->offset = at;
+    at = align8(at + header->node_count * sizeof(unsigned int));
+    layout->word = at;
+    at = align8(at + header->node_count * sizeof(unsigned int));
+    layout->pool = at;
+    at = align8(at + header->pool_count * sizeof(unsigned int));
+    layout->items = at;
+    at = align8(at + header->item_count * sizeof(AstId));
+    layout->uses = at;
+    at = align8(at + header->binding_count * sizeof(AstUse));
+    layout->parent_lines = at;
+    at = align8(at + header->parent_line_words * sizeof(unsigned int));
+    layout->lines = at;
+    at = align8(at + header->line_count * sizeof(unsigned int));
+    layout->name_starts = at;
+    at = align8(at + ((size_t)header->name_count + 1) * sizeof(unsigned int));
+    layout->strings = at;
+    layout->size = at + header->string_bytes;
+}
+
+/* Eight bytes per multiply; the padding after the source reads as zero */
+unsigned long long snapshot_hash(const char *data, size_t size)
+{
+    unsigned long long h = 0x243F6A8885A308D3ULL ^ size;
+    for (size_t p = 0; p < size; p += 8)
+    {
+        unsigned long long w;
+        memcpy(&w, data + p, sizeof(w));
+        h = (h ^ w) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+char *snapshot_path(const char *input_path, const char *dir, unsigned long long hash)
+{
+    size_t length = (dir != NULL ? strlen(dir) : strlen(input_path)) + 32;
+    char *path = (char *)malloc(length);
+    if (dir != NULL)
+    {
+        snprintf(path, length, "%s/%016llx.ast", dir, hash);
+    }
+    else
+    {
+        snprintf(path, length, "%s.ast", input_path);
+    }
+    return path;
+}
+
+int snapshot_save(const char *path, unsigned long long hash, size_t source_size, const CompactAst *ast,
+                  const LineIndex *lines)
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.source_hash = hash;
+    header.source_size = source_size;
+    header.node_count = (unsigned int)ast->count;
+    header.pool_count = (unsigned int)ast->pool_count;
+    header.item_count = (unsigned int)ast->item_count;
+    header.name_count = (unsigned int)ast->name_count;
+    header.scope_count = (unsigned int)ast->scope_count;
+    header.binding_count = (unsigned int)ast->binding_count;
+    header.line_count = (unsigned int)lines->count;
+    if (ast->on_parent_line != NULL)
+    {
+        header.parent_line_words = (unsigned int)(ast->count + 31) / 32;
+    }
+    header.root = ast->root;
+    for (int i = 0; i < ast->name_count; i++)
+    {
+        header.string_bytes += (unsigned int)strlen(ast->names[i]) + 1;
+    }
+
+    SnapshotLayout layout;
+    snapshot_layout(&header, &layout);
+    char *image = (char *)calloc(1, layout.size);
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + layout.kind, ast->kind, header.node_count * sizeof(unsigned char));
+    memcpy(image + layout.offset, ast->offset, header.node_count * sizeof(unsigned int));
+    memcpy(image + layout.word, ast->word, header.node_count * sizeof(unsigned int));
+    memcpy(image + layout.pool, ast->pool, header.pool_count * sizeof(unsigned int));
+    memcpy(image + layout.items, ast->items, header.item_count * sizeof(AstId));
+    memcpy(image + layout.uses, ast->uses, header.binding_count * sizeof(AstUse));
+    if (header.parent_line_words != 0)
+    {
+        memcpy(image + layout.parent_lines, ast->on_parent_line, header.parent_line_words * sizeof(unsigned int));
+    }
+    memcpy(image + layout.lines, lines->starts, header.line_count * sizeof(unsigned int));
+
+    unsigned int *name_starts = (unsigned int *)(image + layout.name_starts);
+    unsigned int at = 0;
+    for (int i = 0; i < ast->name_count; i++)
+    {
+        size_t length = strlen(ast->names[i]) + 1;
+        name_starts[i] = at;
+        memcpy(image + layout.strings + at, ast->names[i], length);
+        at += (unsigned int)length;
+    }
+    name_starts[ast->name_count] = at;
+
+    /* Files compiled on different threads may share a cache entry */
+    static atomic_uint serial;
+    size_t temp_length = strlen(path) + 32;
+    char *temp_path = (char *)malloc(temp_length);
+    snprintf(temp_path, temp_length, "%s.%d.%u.tmp", path, (int)getpid(), atomic_fetch_add(&serial, 1));
+
+    int status = 1;
+    FILE *file = fopen(temp_path, "wb");
+    if (file != NULL)
+    {
+        size_t written = fwrite(image, 1, layout.size, file);
+        if (fclose(file) == 0 && written == layout.size &&
+            (rename(temp_path, path) == 0 || (remove(path) == 0 && rename(temp_path, path) == 0)))
+        {
+            status = 0;
+        }
+        if (status != 0)
+        {
+            remove(temp_path);
+        }
+    }
+
+    free(temp_path);
+    free(image);
+    return status;
+}
+
+static int snapshot_read(Snapshot *snapshot, const char *path)
+{
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return 1;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return 1;
+    }
+    snapshot->data = data;
+    snapshot->size = (size_t)st.st_size;
+    snapshot->is_mapped = 1;
+    return 0;
+#else
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < (long)sizeof(SnapshotHeader))
+    {
+        fclose(file);
+        return 1;
+    }
+
+    snapshot->data = malloc((size_t)size);
+    snapshot->size = fread(snapshot->data, 1, (size_t)size, file);
+    snapshot->is_mapped = 0;
+    fclose(file);
+    return 0;
+#endif
+}
+
+static void snapshot_unmap(Snapshot *snapshot)
+{
+#ifndef _WIN32
+    if (snapshot->is_mapped)
+    {
+        munmap(snapshot->data, snapshot->size);
+    }
+    else
+#endif
+    {
+        free(snapshot->data);
+    }
+    snapshot->data = NULL;
+    snapshot->size = 0;
+}
+
+int snapshot_load(Snapshot *snapshot, const char *path, unsigned long long hash, size_t source_size,
+                  Interner *strings, CompactAst *ast, LineIndex *lines)
+{
+    if (snapshot_read(snapshot, path) != 0)
+    {
+        return 1;
+    }
+
+    const SnapshotHeader *header = (const SnapshotHeader *)snapshot->data;
+    SnapshotLayout layout;
+    snapshot_layout(header, &layout);
+    if (memcmp(header->magic, snapshot_magic, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION ||
+        header->byte_order != SNAPSHOT_BYTE_ORDER || header->source_hash != hash ||
+        header->source_size != source_size || layout.size != snapshot->size || header->node_count == 0 ||
+        header->root >= header->node_count ||
+        (header->parent_line_words != 0 && header->parent_line_words != (header->node_count + 31) / 32))
+    {
+        snapshot_unmap(snapshot);
+        return 1;
+    }
+
+    const char *base = (const char *)snapshot->data;
+    const unsigned int *name_starts = (const unsigned int *)(base + layout.name_starts);
+    if (name_starts[header->name_count] != header->string_bytes)
+    {
+        snapshot_unmap(snapshot);
+        return 1;
+    }
+
+    /* The arrays are only read, so they stay in the mapping */
+    memset(ast, 0, sizeof(*ast));
+    ast->kind = (unsigned char *)(base + layout.kind);
+    ast->offset = (unsigned int *)(base + layout.offset);
+    ast->word = (unsigned int *)(base + layout.word);
+    ast->count = ast->capacity = (int)header->node_count;
+    ast->pool = (unsigned int *)(base + layout.pool);
+    ast->pool_count = ast->pool_capacity = (int)header->pool_count;
+    ast->items = (AstId *)(base + layout.items);
+    ast->item_count = ast->item_capacity = (int)header->item_count;
+    ast->root = header->root;
+    if (header->parent_line_words != 0)
+    {
+        ast->on_parent_line = (unsigned int *)(base + layout.parent_lines);
+    }
+
+    ast->name_count = ast->name_capacity = (int)header->name_count;
+    ast->names = (const char **)malloc((header->name_count + 1) * sizeof(const char *));
+    for (unsigned int i = 0; i < header->name_count; i++)
+    {
+        ast->names[i] = intern(strings, base + layout.strings + name_starts[i],
+                               (int)(name_starts[i + 1] - name_starts[i] - 1));
+    }
+
+    ast->scope_count = ast->scope_capacity = (int)header->scope_count;
+    ast->scopes = (struct Scope **)calloc(header->scope_count + 1, sizeof(struct Scope *));
+    ast->uses = (AstUse *)(base + layout.uses);
+    ast->binding_count = ast->binding_capacity = (int)header->binding_count;
+    ast->bindings = (struct SymbolEntry **)calloc(header->binding_count + 1, sizeof(struct SymbolEntry *));
+
+    lines->count = (int)header->line_count;
+    lines->starts = (unsigned int *)malloc((header->line_count + 1) * sizeof(unsigned int));
+    memcpy(lines->starts, base + layout.lines, header->line_count * sizeof(unsigned int));
+    return 0;
+}
+
+void snapshot_close(Snapshot *snapshot, CompactAst *ast)
+{
+    free(ast->names);
+    free(ast->scopes);
+    free(ast->bindings);
+    memset(ast, 0, sizeof(*ast));
+    snapshot_unmap(snapshot);
+}
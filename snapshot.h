@@ -0,0 +1,46 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include "compact_ast.h"
+#include "line_index.h"
+#include "interner.h"
+
+/* A compact AST saved to disk, so a source that has not changed since
+   the last run is neither lexed nor parsed again. The file holds the
+   node, pool, list and use arrays as they are in memory, which only refer to
+   each other by index, and the on_parent_line bits of a shared tree,
+   followed by the line starts and a string table in place of the name
+   pointers. It is keyed by a hash of the source
+   text and ignored when the hash, size, version or byte order differ. */
+
+#define SNAPSHOT_VERSION 3
+
+/* Hash of the source text; data must be followed by SOURCE_PADDING bytes */
+unsigned long long snapshot_hash(const char *data, size_t size);
+
+/* <input_path>.ast when dir is NULL, else <dir>/<hash>.ast */
+char *snapshot_path(const char *input_path, const char *dir, unsigned long long hash);
+
+/* Writes through a temporary file, so a reader never sees half a snapshot */
+int snapshot_save(const char *path, unsigned long long hash, size_t source_size, const CompactAst *ast,
+                  const LineIndex *lines);
+
+typedef struct Snapshot
+{
+    void *data;
+    size_t size;
+    int is_mapped;
+} Snapshot;
+
+/* Maps the snapshot at path and points ast at its arrays. Names are
+   interned in strings, so they compare equal to the ones the parser would
+   have produced; lines gets its own copy of the line starts. Returns
+   nonzero when there is no usable snapshot for this source. */
+int snapshot_load(Snapshot *snapshot, const char *path, unsigned long long hash, size_t source_size,
+                  Interner *strings, CompactAst *ast, LineIndex *lines);
+
+/* Releases a loaded ast along with the mapping it points into */
+void snapshot_close(Snapshot *snapshot, CompactAst *ast);
+
+#endif
@@ -0,0 +1,124 @@
+#include "source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int source_read(SourceBuffer *src, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0)
+    {
+        fclose(file);
+        return 1;
+    }
+
+    src->data = (char *)malloc((size_t)size + SOURCE_PADDING);
+    src->size = fread(src->data, 1, (size_t)size, file);
+    memset(src->data + src->size, 0, SOURCE_PADDING);
+    src->reserved_size = (size_t)size + SOURCE_PADDING;
+    src->is_mapped = 0;
+
+    fclose(file);
+    return 0;
+}
+
+#ifndef _WIN32
+/* The file is mapped over an anonymous reservation that is a little
+   larger than the file, so the bytes past EOF read as zero even when
+   the file ends exactly on a page boundary. The mapping is private and
+   writable because flex NUL-terminates yytext in place; only the pages
+   it touches are copied. */
+static int source_map(SourceBuffer *src, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return 1;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)st.st_size;
+    size_t reserved = (size + SOURCE_PADDING + page - 1) / page * page;
+
+    char *base = (char *)mmap(NULL, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return 1;
+    }
+
+    if (size > 0 &&
+        mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(base, reserved);
+        close(fd);
+        return 1;
+    }
+    close(fd);
+
+    src->data = base;
+    src->size = size;
+    src->reserved_size = reserved;
+    src->is_mapped = 1;
+    return 0;
+}
+#endif
+
+int source_open(SourceBuffer *src, const char *path, int use_mmap)
+{
+    src->data = NULL;
+    src->size = 0;
+    src->reserved_size = 0;
+    src->is_mapped = 0;
+
+#ifndef _WIN32
+    if (use_mmap)
+    {
+        return source_map(src, path);
+    }
+#endif
+    return source_read(src, path);
+}
+
+void source_close(SourceBuffer *src)
+{
+    if (src->data == NULL)
+    {
+        return;
+    }
+
+#ifndef _WIN32
+    if (src->is_mapped)
+    {
+        munmap(src->data, src->reserved_size);
+    }
+    else
+#endif
+    {
+        free(src->data);
+    }
+    src->data = NULL;
+    src->size = 0;
+}
@@ -0,0 +1,22 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+/* Every loaded source is followed by at least this many zero bytes,
+   which covers flex's two end-of-buffer NULs. */
+#define SOURCE_PADDING 64
+
+typedef struct SourceBuffer
+{
+    char *data;
+    size_t size;
+    size_t reserved_size;
+    int is_mapped;
+} SourceBuffer;
+
+int source_open(SourceBuffer *src, const char *path, int use_mmap);
+
+void source_close(SourceBuffer *src);
+
+#endif
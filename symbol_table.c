@@ -1,44 +1,138 @@
 #include "symbol_table.h"
 #include "error_logger.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static void print_scope_recursive(FILE *file, Scope *scope, int indent_level);
-static void free_scope_recursive(Scope *scope);
+#define SYMBOL_INITIAL_SLOTS 256
 
-static Scope *create_scope(Scope *parent, char *scope_name)
+static void print_scope_tree(FILE *file, Scope *scope, int indent_level);
+static void free_scope_tree(Scope *scope);
+static void free_scope_data(Scope *scope);
+
+static Scope *create_scope(Scope *parent, const char *scope_name)
 {
     Scope *scope = (Scope *)malloc(sizeof(Scope));
     scope->head = NULL;
     scope->parent = parent;
-    scope->scope_name = strdup(scope_name);
+    scope->scope_name = scope_name;
 
     scope->children = NULL;
     scope->next_sibling = NULL;
+    scope->depth = 0;
+    scope->undo_mark = 0;
 
     if (parent != NULL)
     {
 
         scope->next_sibling = parent->children;
         parent->children = scope;
+        scope->depth = parent->depth + 1;
     }
 
     return scope;
 }
 
-SymbolTable *create_symbol_table()
+static unsigned int name_hash(const char *name)
+{
+    return (unsigned int)(((uintptr_t)name >> 3) * 2654435761u);
+}
+
+/* Slot of name, claimed if it has none */
+static SymbolSlot *find_slot(SymbolTable *st, const char *name)
+{
+    unsigned int mask = (unsigned int)st->slot_capacity - 1;
+    unsigned int i = name_hash(name) & mask;
+    while (st->slots[i].name != NULL && st->slots[i].name != name)
+    {
+        i = (i + 1) & mask;
+    }
+    return &st->slots[i];
+}
+
+static void slots_grow(SymbolTable *st)
+{
+    SymbolSlot *old = st->slots;
+    int old_capacity = st->slot_capacity;
+
+    st->slot_capacity = old_capacity * 2;
+    st->slots = (SymbolSlot *)calloc(st->slot_capacity, sizeof(SymbolSlot));
+    for (int i = 0; i < old_capacity; i++)
+    {
+        if (old[i].name != NULL)
+        {
+            *find_slot(st, old[i].name) = old[i];
+        }
+    }
+    free(old);
+}
+
+/* Makes entry the innermost binding of its name until the log is popped past it */
+static void bind(SymbolTable *st, SymbolEntry *entry)
+{
+    SymbolSlot *slot = find_slot(st, entry->name);
+    if (slot->name == NULL)
+    {
+        slot->name = entry->name;
+        if (2 * ++st->slot_count > st->slot_capacity)
+        {
+            slots_grow(st);
+            slot = find_slot(st, entry->name);
+        }
+    }
+    entry->shadowed = slot->top;
+    slot->top = entry;
+
+    if (st->undo_count == st->undo_capacity)
+    {
+        st->undo_capacity *= 2;
+        st->undo = (SymbolEntry **)realloc(st->undo, st->undo_capacity * sizeof(SymbolEntry *));
+    }
+    st->undo[st->undo_count++] = entry;
+}
+
+/* Binds what scope declares; its enclosing scopes must be bound already */
+static void bind_scope(SymbolTable *st, Scope *scope)
+{
+    scope->undo_mark = st->undo_count;
+    for (SymbolEntry *entry = scope->head; entry != NULL; entry = entry->next)
+    {
+        bind(st, entry);
+    }
+}
+
+/* Unbinds scope and everything bound after it */
+static void unbind_scope(SymbolTable *st, Scope *scope)
+{
+    while (st->undo_count > scope->undo_mark)
+    {
+        SymbolEntry *entry = st->undo[--st->undo_count];
+        find_slot(st, entry->name)->top = entry->shadowed;
+        entry->shadowed = NULL;
+    }
+}
+
+SymbolTable *create_symbol_table(ErrorLog *errors)
 {
     SymbolTable *st = (SymbolTable *)malloc(sizeof(SymbolTable));
-    st->global_scope = create_scope(NULL, "global");
+    st->global_scope = create_scope(NULL, NAME_GLOBAL);
     st->current_scope = st->global_scope;
+    st->errors = errors;
+    st->slot_count = 0;
+    st->slot_capacity = SYMBOL_INITIAL_SLOTS;
+    st->slots = (SymbolSlot *)calloc(st->slot_capacity, sizeof(SymbolSlot));
+    st->undo_count = 0;
+    st->undo_capacity = SYMBOL_INITIAL_SLOTS;
+    st->undo = (SymbolEntry **)malloc(st->undo_capacity * sizeof(SymbolEntry *));
     return st;
 }
 
-void enter_scope(SymbolTable *st, char *scope_name)
+void enter_scope(SymbolTable *st, const char *scope_name)
 {
 
     Scope *new_scope = create_scope(st->current_scope, scope_name);
+    new_scope->undo_mark = st->undo_count;
     st->current_scope = new_scope;
 }
 
@@ -47,64 +141,96 @@ void exit_scope(SymbolTable *st)
 
     if (st->current_scope != st->global_scope)
     {
+        unbind_scope(st, st->current_scope);
         st->current_scope = st->current_scope->parent;
     }
 }
 
+/* Unbinds up to the scope both chains share, then binds down to scope */
+void set_current_scope(SymbolTable *st, Scope *scope)
+{
+    Scope *from = st->current_scope;
+    if (from == scope)
+    {
+        return;
+    }
+
+    Scope *local[32];
+    Scope **path = local;
+    int count = 0;
+    int capacity = 32;
+    while (from != scope)
+    {
+        if (from->depth >= scope->depth)
+        {
+            unbind_scope(st, from);
+            from = from->parent;
+            continue;
+        }
+        if (count == capacity)
+        {
+            capacity *= 2;
+            if (path == local)
+            {
+                path = (Scope **)malloc(capacity * sizeof(Scope *));
+                memcpy(path, local, sizeof(local));
+            }
+            else
+            {
+                path = (Scope **)realloc(path, capacity * sizeof(Scope *));
+            }
+        }
+        path[count++] = scope;
+        scope = scope->parent;
+    }
+
+    st->current_scope = count > 0 ? path[0] : from;
+    while (count > 0)
+    {
+        bind_scope(st, path[--count]);
+    }
+    if (path != local)
+    {
+        free(path);
+    }
+}
+
 void insert_symbol(SymbolTable *st, const char *name, const char *type,
-                   SymbolKind kind, int line, struct ASTNode *params)
+                   SymbolKind kind, unsigned int offset, const char **param_types, unsigned int param_count)
 {
 
     if (lookup_current_scope(st, name) != NULL)
     {
         char buffer[256];
         sprintf(buffer, "Symbol '%s' already declared in this scope", name);
-        log_semantic_error(buffer, line);
+        log_semantic_error(st->errors, buffer, offset);
+        free(param_types);
         return;
     }
 
     SymbolEntry *new_entry = (SymbolEntry *)malloc(sizeof(SymbolEntry));
-    new_entry->name = strdup(name);
-    new_entry->type = strdup(type);
+    new_entry->name = name;
+    new_entry->type = type;
     new_entry->kind = kind;
-    new_entry->line_number = line;
-    new_entry->params = params;
+    new_entry->offset = offset;
+    new_entry->param_types = param_types;
+    new_entry->param_count = param_count;
+    new_entry->scope = st->current_scope;
 
     new_entry->next = st->current_scope->head;
     st->current_scope->head = new_entry;
+    bind(st, new_entry);
 }
 
 SymbolEntry *lookup_current_scope(SymbolTable *st, const char *name)
 {
-    SymbolEntry *current = st->current_scope->head;
-    while (current != NULL)
-    {
-        if (strcmp(current->name, name) == 0)
-        {
-            return current;
-        }
-        current = current->next;
-    }
-    return NULL;
+    SymbolEntry *entry = lookup_all_scopes(st, name);
+    return entry != NULL && entry->scope == st->current_scope ? entry : NULL;
 }
 
 SymbolEntry *lookup_all_scopes(SymbolTable *st, const char *name)
 {
-    Scope *scope = st->current_scope;
-    while (scope != NULL)
-    {
-        SymbolEntry *entry = scope->head;
-        while (entry != NULL)
-        {
-            if (strcmp(entry->name, name) == 0)
-            {
-                return entry;
-            }
-            entry = entry->next;
-        }
-        scope = scope->parent;
-    }
-    return NULL;
+    return find_slot(st, name)->top;
 }
 
 static const char *kind_to_string(SymbolKind kind)
@@ -135,10 +261,10 @@ static const char *kind_to_string(SymbolKind kind)
 static void print_scope(FILE *file, Scope *scope, int indent_level)
 {
     char indent[40] = {0};
-    for (int i = 0; i < indent_level * 2; i++)
+    int indent_width = indent_level * 2 < 39 ? indent_level * 2 : 39;
+    for (int i = 0; i < indent_width; i++)
     {
-        if (i < 39)
-            indent[i] = ' ';
+        indent[i] = ' ';
     }
 
     static const char *dashes = "----------------------------------------------------------------------------------------------------";
@@ -196,7 +322,7 @@ static void print_scope(FILE *file, Scope *scope, int indent_level)
         char f_other[WIDTH_OTHER + 5];
 
         char other_info_content[WIDTH_OTHER + 1] = "";
-        if (entry->kind == KIND_FUNCTION && entry->params != NULL)
+        if (entry->kind == KIND_FUNCTION && entry->param_count > 0)
         {
             strncpy(other_info_content, "(has params)", WIDTH_OTHER);
         }
@@ -227,17 +353,49 @@ static void print_scope(FILE *file, Scope *scope, int indent_level)
     fprintf(file, "+\n");
 }
 
-static void print_scope_recursive(FILE *file, Scope *scope, int indent_level)
+/* Prints each scope of the list with its children indented below it.
+   Blocks may nest very deeply, so the walk climbs back up through the
+   parent links instead of recursing. */
+static void print_scope_tree(FILE *file, Scope *scope, int indent_level)
 {
     if (scope == NULL)
         return;
 
-    print_scope(file, scope, indent_level);
-    fprintf(file, "\n");
+    Scope *top = scope->parent;
+    while (scope != NULL)
+    {
+        print_scope(file, scope, indent_level);
+        fprintf(file, "\n");
+
+        if (scope->children != NULL)
+        {
+            scope = scope->children;
+            indent_level++;
+            continue;
+        }
+        while (scope->next_sibling == NULL && scope->parent != top)
+        {
+            scope = scope->parent;
+            indent_level--;
+        }
+        scope = scope->next_sibling;
+    }
+}
+
+static void print_table_title(FILE *file)
+{
+    const char *title = " Symbol Table ";
+    int title_len = (int)strlen(title);
 
-    print_scope_recursive(file, scope->children, indent_level + 1);
+    int total_width = WIDTH_NAME + WIDTH_TYPE + WIDTH_KIND + WIDTH_OTHER + 5;
 
-    print_scope_recursive(file, scope->next_sibling, indent_level);
+    int padding_total = total_width - 2 - title_len;
+    int padding_left = padding_total / 2;
+    int padding_right = padding_total - padding_left;
+
+    const char *dashes = "----------------------------------------------------------------------------------------------------";
+
+    fprintf(file, "+%.*s%s%.*s+\n\n", padding_left, dashes, title, padding_right, dashes);
 }
 
 void print_symbol_table_to_file(SymbolTable *st, const char *filename)
@@ -249,25 +407,94 @@ void print_symbol_table_to_file(SymbolTable *st, const char *filename)
         return;
     }
 
-    const char *title = " Symbol Table ";
-    int title_len = (int)strlen(title);
+    print_table_title(file);
+    print_scope_tree(file, st->global_scope, 0);
 
-    int total_width = WIDTH_NAME + WIDTH_TYPE + WIDTH_KIND + WIDTH_OTHER + 5;
+    fclose(file);
+    printf("Symbol table written to %s\n", filename);
+}
 
-    int padding_total = total_width - 2 - title_len;
-    int padding_left = padding_total / 2;
-    int padding_right = padding_total - padding_left;
+int scope_spill_init(ScopeSpill *spill)
+{
+    spill->file = tmpfile();
+    spill->count = 0;
+    spill->capacity = 64;
+    spill->ends = (long *)malloc(spill->capacity * sizeof(long));
+    return spill->file == NULL;
+}
 
-    const char *dashes = "----------------------------------------------------------------------------------------------------";
+void spill_scope(SymbolTable *st, Scope *scope, ScopeSpill *spill)
+{
+    set_current_scope(st, st->global_scope);
+    print_scope(spill->file, scope, 1);
+    fprintf(spill->file, "\n");
+    print_scope_tree(spill->file, scope->children, 2);
 
-    fprintf(file, "+%.*s%s%.*s+\n\n", padding_left, dashes, title, padding_right, dashes);
+    if (spill->count == spill->capacity)
+    {
+        spill->capacity *= 2;
+        spill->ends = (long *)realloc(spill->ends, spill->capacity * sizeof(long));
+    }
+    spill->ends[spill->count++] = ftell(spill->file);
+
+    Scope **link = &st->global_scope->children;
+    while (*link != scope)
+    {
+        link = &(*link)->next_sibling;
+    }
+    *link = scope->next_sibling;
+    free_scope_tree(scope->children);
+    free_scope_data(scope);
+}
+
+/* Children print newest first, so the spilled ones come last and in
+   reverse order */
+void print_spilled_symbol_table_to_file(SymbolTable *st, ScopeSpill *spill, const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error: Could not open symbol table file %s\n", filename);
+        return;
+    }
 
-    print_scope_recursive(file, st->global_scope, 0);
+    print_table_title(file);
+    print_scope_tree(file, st->global_scope, 0);
+
+    char buffer[8192];
+    for (int i = spill->count - 1; i >= 0; i--)
+    {
+        long start = i > 0 ? spill->ends[i - 1] : 0;
+        long left = spill->ends[i] - start;
+        fseek(spill->file, start, SEEK_SET);
+        while (left > 0)
+        {
+            size_t n = fread(buffer, 1, left < (long)sizeof(buffer) ? (size_t)left : sizeof(buffer), spill->file);
+            if (n == 0)
+            {
+                break;
+            }
+            fwrite(buffer, 1, n, file);
+            left -= (long)n;
+        }
+    }
 
     fclose(file);
     printf("Symbol table written to %s\n", filename);
 }
 
+void scope_spill_free(ScopeSpill *spill)
+{
+    if (spill->file != NULL)
+    {
+        fclose(spill->file);
+    }
+    free(spill->ends);
+    spill->file = NULL;
+    spill->ends = NULL;
+    spill->count = 0;
+}
+
 static void free_scope_data(Scope *scope)
 {
     if (scope == NULL)
@@ -278,23 +505,34 @@ static void free_scope_data(Scope *scope)
     {
         SymbolEntry *temp = entry;
         entry = entry->next;
-        free(temp->name);
-        free(temp->type);
+        free(temp->param_types);
         free(temp);
     }
-    free(scope->scope_name);
     free(scope);
 }
 
-static void free_scope_recursive(Scope *scope)
+/* Frees the list and everything below it, children first, without a
+   C frame per level */
+static void free_scope_tree(Scope *scope)
 {
     if (scope == NULL)
         return;
 
-    free_scope_recursive(scope->children);
-    free_scope_recursive(scope->next_sibling);
-
-    free_scope_data(scope);
+    Scope *top = scope->parent;
+    while (scope != NULL)
+    {
+        if (scope->children != NULL)
+        {
+            Scope *child = scope->children;
+            scope->children = NULL;
+            scope = child;
+            continue;
+        }
+        Scope *next = scope->next_sibling;
+        Scope *parent = scope->parent;
+        free_scope_data(scope);
+        scope = next != NULL ? next : (parent != top ? parent : NULL);
+    }
 }
 
 void free_symbol_table(SymbolTable *st)
@@ -302,7 +540,9 @@ void free_symbol_table(SymbolTable *st)
     if (st == NULL)
         return;
 
-    free_scope_recursive(st->global_scope);
+    free_scope_tree(st->global_scope);
+    free(st->slots);
+    free(st->undo);
 
     st->global_scope = NULL;
     st->current_scope = NULL;
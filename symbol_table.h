@@ -2,7 +2,9 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
-#include "ast.h"
+#include "compact_ast.h"
+#include "error_logger.h"
+#include "interner.h"
 
 typedef enum
 {
@@ -13,41 +15,76 @@ typedef enum
     KIND_ATTRIBUTE
 } SymbolKind;
 
+/* Names, types and scope names are interned strings and are compared
+   by pointer; the table does not own them. */
 typedef struct SymbolEntry
 {
-    char *name;
-    char *type;
+    const char *name;
+    const char *type;
     SymbolKind kind;
-    int line_number;
+    unsigned int offset;
 
-    struct ASTNode *params;
+    /* A function's parameter types, owned by the entry, so calls can be
+       checked after the function's tree is gone */
+    const char **param_types;
+    unsigned int param_count;
 
     struct SymbolEntry *next;
+    struct Scope *scope;
+    struct SymbolEntry *shadowed; /* same name in an enclosing scope, while bound */
 } SymbolEntry;
 
 typedef struct Scope
 {
     SymbolEntry *head;
     struct Scope *parent;
-    char *scope_name;
+    const char *scope_name;
     struct Scope *children;
     struct Scope *next_sibling;
+    int depth;      /* 0 for the global scope */
+    int undo_mark;  /* undo log length when the scope was bound */
 } Scope;
 
+/* Innermost visible binding of a name */
+typedef struct SymbolSlot
+{
+    const char *name;
+    SymbolEntry *top;
+} SymbolSlot;
+
+/* The Scope tree keeps every entry, for printing. Lookups go through a
+   hash table of the names visible from current_scope instead: each slot
+   holds the innermost entry, which links to the one it shadows. Entries
+   are bound as their scope becomes visible and logged, so leaving a
+   scope unbinds them by popping the log back to its mark. */
 typedef struct SymbolTable
 {
     Scope *global_scope;
-    Scope *current_scope;
+    Scope *current_scope; /* only moved by enter_scope, exit_scope and set_current_scope */
+    ErrorLog *errors;
+
+    SymbolSlot *slots;
+    int slot_count;
+    int slot_capacity;
+
+    SymbolEntry **undo;
+    int undo_count;
+    int undo_capacity;
 } SymbolTable;
 
-SymbolTable *create_symbol_table();
+SymbolTable *create_symbol_table(ErrorLog *errors);
 
-void enter_scope(SymbolTable *st, char *scope_name);
+void enter_scope(SymbolTable *st, const char *scope_name);
 
 void exit_scope(SymbolTable *st);
 
+/* Makes scope, anywhere in the tree, the current one */
+void set_current_scope(SymbolTable *st, Scope *scope);
+
+/* Takes param_types, a malloc'd array or NULL, whether or not the symbol
+   is inserted */
 void insert_symbol(SymbolTable *st, const char *name, const char *type,
-                   SymbolKind kind, int line, struct ASTNode *params);
+                   SymbolKind kind, unsigned int offset, const char **param_types, unsigned int param_count);
 
 SymbolEntry *lookup_current_scope(SymbolTable *st, const char *name);
 
@@ -55,6 +92,27 @@ SymbolEntry *lookup_all_scopes(SymbolTable *st, const char *name);
 
 void print_symbol_table_to_file(SymbolTable *st, const char *filename);
 
+/* Finished subtrees of the global scope, already printed to a temporary
+   file and freed, so a streaming compilation does not keep every scope */
+typedef struct ScopeSpill
+{
+    FILE *file;
+    long *ends; /* where each subtree's text ends in file */
+    int count;
+    int capacity;
+} ScopeSpill;
+
+int scope_spill_init(ScopeSpill *spill);
+
+/* Prints scope, a child of the global scope with nothing created after it,
+   and everything under it; then frees them */
+void spill_scope(SymbolTable *st, Scope *scope, ScopeSpill *spill);
+
+/* print_symbol_table_to_file with the spilled scopes back in their places */
+void print_spilled_symbol_table_to_file(SymbolTable *st, ScopeSpill *spill, const char *filename);
+
+void scope_spill_free(ScopeSpill *spill);
+
 void free_symbol_table(SymbolTable *st);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "token_buffer.h"
+#include "token_trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void token_buffer_grow(TokenBuffer *buf, int capacity)
+{
+    buf->kind = (short *)realloc(buf->kind, capacity * sizeof(short));
+    buf->start = (unsigned int *)realloc(buf->start, capacity * sizeof(unsigned int));
+    buf->len = (unsigned int *)realloc(buf->len, capacity * sizeof(unsigned int));
+    buf->value = (TokenValue *)realloc(buf->value, capacity * sizeof(TokenValue));
+    buf->capacity = capacity;
+}
+
+void token_buffer_init(TokenBuffer *buf, const char *text, int capacity_hint)
+{
+    buf->kind = NULL;
+    buf->start = NULL;
+    buf->len = NULL;
+    buf->value = NULL;
+    buf->count = 0;
+    buf->capacity = 0;
+    buf->text = text;
+    token_buffer_grow(buf, capacity_hint > 16 ? capacity_hint : 16);
+}
+
+void token_buffer_push(TokenBuffer *buf, int kind, unsigned int start, unsigned int len, TokenValue value)
+{
+    if (buf->count == buf->capacity)
+    {
+        token_buffer_grow(buf, buf->capacity * 2);
+    }
+    int i = buf->count++;
+    buf->kind[i] = (short)kind;
+    buf->start[i] = start;
+    buf->len[i] = len;
+    buf->value[i] = value;
+}
+
+void token_buffer_free(TokenBuffer *buf)
+{
+    free(buf->kind);
+    free(buf->start);
+    free(buf->len);
+    free(buf->value);
+    buf->kind = NULL;
+    buf->start = NULL;
+    buf->len = NULL;
+    buf->value = NULL;
+    buf->count = 0;
+    buf->capacity = 0;
+}
+
+void token_buffer_append(TokenBuffer *buf, const TokenBuffer *src, int from, int to, int shift)
+{
+    int n = to - from;
+    if (n <= 0)
+    {
+        return;
+    }
+    if (buf->count + n > buf->capacity)
+    {
+        int capacity = buf->capacity * 2;
+        if (capacity < buf->count + n)
+        {
+            capacity = buf->count + n;
+        }
+        token_buffer_grow(buf, capacity);
+    }
+    memcpy(buf->kind + buf->count, src->kind + from, n * sizeof(short));
+    for (int i = 0; i < n; i++)
+    {
+        buf->start[buf->count + i] = src->start[from + i] + shift;
+    }
+    memcpy(buf->len + buf->count, src->len + from, n * sizeof(unsigned int));
+    memcpy(buf->value + buf->count, src->value + from, n * sizeof(TokenValue));
+    buf->count += n;
+}
+
+static void describe_token(const TokenBuffer *buf, int i, FILE *out)
+{
+    if (i >= buf->count)
+    {
+        fprintf(out, "<missing>");
+        return;
+    }
+    fprintf(out, "%s '%.*s' at offset %u", token_type_name(buf->kind[i]),
+            (int)buf->len[i], buf->text + buf->start[i], buf->start[i]);
+}
+
+static int same_value(const TokenBuffer *a, const TokenBuffer *b, int i)
+{
+    switch (a->kind[i])
+    {
+    case INTEGER_LIT:
+        return a->value[i].int_value == b->value[i].int_value;
+    case FLOAT_LIT:
+        return a->value[i].float_value == b->value[i].float_value;
+    default:
+        return 1;
+    }
+}
+
+/* Reports the first token where the two streams disagree; returns 1 if they differ */
+int token_buffer_diff(const TokenBuffer *expected, const TokenBuffer *actual, FILE *out)
+{
+    int count = expected->count > actual->count ? expected->count : actual->count;
+    for (int i = 0; i < count; i++)
+    {
+        if (i < expected->count && i < actual->count &&
+            expected->kind[i] == actual->kind[i] &&
+            expected->start[i] == actual->start[i] &&
+            expected->len[i] == actual->len[i] &&
+            same_value(expected, actual, i))
+        {
+            continue;
+        }
+
+        fprintf(out, "Token %d differs:\n  expected: ", i);
+        describe_token(expected, i, out);
+        fprintf(out, "\n  actual:   ");
+        describe_token(actual, i, out);
+        fprintf(out, "\n");
+        return 1;
+    }
+    return 0;
+}
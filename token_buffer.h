@@ -0,0 +1,42 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include <stdio.h>
+#include "tokens.h"
+
+/* The whole token stream of one source, stored as parallel arrays.
+   start[] is a byte offset into text; the last entry is always an
+   end-of-input token of kind 0, so lookahead never runs off the end. */
+typedef struct TokenBuffer
+{
+    short *kind;
+    unsigned int *start;
+    unsigned int *len;
+    TokenValue *value; /* meaningful for INTEGER_LIT and FLOAT_LIT only */
+    int count;
+    int capacity;
+    const char *text;
+} TokenBuffer;
+
+void token_buffer_init(TokenBuffer *buf, const char *text, int capacity_hint);
+
+void token_buffer_push(TokenBuffer *buf, int kind, unsigned int start, unsigned int len, TokenValue value);
+
+void token_buffer_free(TokenBuffer *buf);
+
+/* Appends src's tokens [from, to), moving their offsets by shift */
+void token_buffer_append(TokenBuffer *buf, const TokenBuffer *src, int from, int to, int shift);
+
+int token_buffer_diff(const TokenBuffer *expected, const TokenBuffer *actual, FILE *out);
+
+static inline TokenView token_view_at(const TokenBuffer *buf, int index)
+{
+    TokenView view;
+    view.text = buf->text + buf->start[index];
+    view.offset = (int)buf->start[index];
+    view.length = (int)buf->len[index];
+    view.value = buf->value[index];
+    return view;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <sched.h>
+#include "token_ring.h"
+
+/* Spin briefly before giving up the core; the other side is usually
+   only a few tokens behind */
+#define TOKEN_RING_SPINS 64
+
+static void ring_wait(int *spins)
+{
+    if (++*spins > TOKEN_RING_SPINS)
+    {
+        sched_yield();
+    }
+}
+
+void token_ring_init(TokenRing *ring, const char *text, int capacity)
+{
+    unsigned int size = 1;
+    while (size < (unsigned int)capacity || size <= TOKEN_RING_MAX_LOOKAHEAD)
+    {
+        size <<= 1;
+    }
+    ring->slots = (TokenRecord *)malloc(size * sizeof(TokenRecord));
+    ring->mask = size - 1;
+    ring->text = text;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+}
+
+void token_ring_free(TokenRing *ring)
+{
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+void token_ring_push(TokenRing *ring, int kind, unsigned int start, unsigned int len, TokenValue value)
+{
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    int spins = 0;
+    while (head - ring->cached_tail > ring->mask)
+    {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->cached_tail > ring->mask)
+        {
+            ring_wait(&spins);
+        }
+    }
+
+    TokenRecord *slot = &ring->slots[head & ring->mask];
+    slot->kind = kind;
+    slot->start = start;
+    slot->len = len;
+    slot->value = value;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+const TokenRecord *token_ring_peek(TokenRing *ring, int k)
+{
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (int i = 0;; i++)
+    {
+        int spins = 0;
+        while (ring->cached_head - tail <= (unsigned int)i)
+        {
+            ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            if (ring->cached_head - tail <= (unsigned int)i)
+            {
+                ring_wait(&spins);
+            }
+        }
+
+        const TokenRecord *slot = &ring->slots[(tail + i) & ring->mask];
+        if (i == k || slot->kind == 0)
+        {
+            return slot;
+        }
+    }
+}
+
+void token_ring_pop(TokenRing *ring)
+{
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
@@ -0,0 +1,52 @@
+#ifndef TOKEN_RING_H
+#define TOKEN_RING_H
+
+#include <stdatomic.h>
+#include "tokens.h"
+
+#define TOKEN_RING_CACHE_LINE 64
+
+/* Tokens the parser may look at past the current one while pipelined */
+#define TOKEN_RING_MAX_LOOKAHEAD 8
+
+typedef struct TokenRecord
+{
+    int kind;
+    unsigned int start;
+    unsigned int len;
+    TokenValue value;
+} TokenRecord;
+
+/* Single-producer/single-consumer queue between the lexer thread and the
+   parser. head and tail only ever grow; each side keeps a stale copy of
+   the other's index and rereads it only when the ring looks full or empty.
+   A full ring makes the lexer wait, which bounds memory. */
+typedef struct TokenRing
+{
+    TokenRecord *slots;
+    unsigned int mask;
+    const char *text;
+
+    _Alignas(TOKEN_RING_CACHE_LINE) atomic_uint head;
+    unsigned int cached_tail;
+
+    _Alignas(TOKEN_RING_CACHE_LINE) atomic_uint tail;
+    unsigned int cached_head;
+} TokenRing;
+
+/* capacity is rounded up to a power of two above TOKEN_RING_MAX_LOOKAHEAD */
+void token_ring_init(TokenRing *ring, const char *text, int capacity);
+
+void token_ring_free(TokenRing *ring);
+
+/* Producer side; waits while the ring is full */
+void token_ring_push(TokenRing *ring, int kind, unsigned int start, unsigned int len, TokenValue value);
+
+/* Consumer side: the token k places from the front, waiting for the lexer
+   if needed. k must be below TOKEN_RING_MAX_LOOKAHEAD, and the producer's
+   last token must have kind 0 so a peek past the end returns that token. */
+const TokenRecord *token_ring_peek(TokenRing *ring, int k);
+
+void token_ring_pop(TokenRing *ring);
+
+#endif
@@ -0,0 +1,199 @@
+#include "token_trace.h"
+#include "tokens.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_BUFFER_SIZE (64 * 1024)
+#define TRACE_RECORD_SIZE 20
+
+static void trace_write(TraceSink *sink, const char *data, size_t length)
+{
+    if (sink->pos + length > TRACE_BUFFER_SIZE)
+    {
+        trace_flush(sink);
+        if (length > TRACE_BUFFER_SIZE)
+        {
+            fwrite(data, 1, length, sink->out);
+            return;
+        }
+    }
+    memcpy(sink->buffer + sink->pos, data, length);
+    sink->pos += length;
+}
+
+static void put_u32(unsigned char *p, unsigned int value)
+{
+    p[0] = (unsigned char)(value & 0xFF);
+    p[1] = (unsigned char)((value >> 8) & 0xFF);
+    p[2] = (unsigned char)((value >> 16) & 0xFF);
+    p[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static void trace_write_record(TraceSink *sink, int type, int offset, int length, int line, int col)
+{
+    unsigned char record[TRACE_RECORD_SIZE];
+    put_u32(record, (unsigned int)type);
+    put_u32(record + 4, (unsigned int)offset);
+    put_u32(record + 8, (unsigned int)length);
+    put_u32(record + 12, (unsigned int)line);
+    put_u32(record + 16, (unsigned int)col);
+    trace_write(sink, (const char *)record, TRACE_RECORD_SIZE);
+}
+
+TraceSink *trace_open(TraceMode mode, const char *filename)
+{
+    if (mode == TRACE_OFF)
+    {
+        return NULL;
+    }
+
+    FILE *out = stdout;
+    if (filename != NULL)
+    {
+        out = fopen(filename, mode == TRACE_BINARY ? "wb" : "w");
+        if (!out)
+        {
+            fprintf(stderr, "Error: Could not open trace file %s\n", filename);
+            return NULL;
+        }
+    }
+
+    TraceSink *sink = (TraceSink *)malloc(sizeof(TraceSink));
+    sink->mode = mode;
+    sink->out = out;
+    sink->buffer = (char *)malloc(TRACE_BUFFER_SIZE);
+    sink->pos = 0;
+
+    if (mode == TRACE_BINARY)
+    {
+        unsigned char header[8];
+        memcpy(header, TRACE_BINARY_MAGIC, 4);
+        put_u32(header + 4, TRACE_BINARY_VERSION);
+        trace_write(sink, (const char *)header, sizeof(header));
+    }
+    return sink;
+}
+
+void trace_token(TraceSink *sink, const LineIndex *lines, int type, const char *lexeme, int offset, int length)
+{
+    int line, col;
+    line_index_locate(lines, (unsigned int)offset, &line, &col);
+
+    if (sink->mode == TRACE_TEXT)
+    {
+        char line_buf[512];
+        int n = snprintf(line_buf, sizeof(line_buf), "Token: %-12s Lexeme: %-15s Line: %d Column: %d\n",
+                         token_type_name(type), lexeme, line, col);
+        if (n >= (int)sizeof(line_buf))
+        {
+            n = sizeof(line_buf) - 1;
+            line_buf[n - 1] = '\n';
+        }
+        trace_write(sink, line_buf, n);
+    }
+    else
+    {
+        trace_write_record(sink, type, offset, length, line, col);
+    }
+}
+
+void trace_error(TraceSink *sink, const LineIndex *lines, const char *lexeme, int offset, int length,
+                 const char *message)
+{
+    int line, col;
+    line_index_locate(lines, (unsigned int)offset, &line, &col);
+
+    char line_buf[512];
+    int n = snprintf(line_buf, sizeof(line_buf), "ERROR: %-25s Lexeme: %-15s Line: %d Column: %d\n",
+                     message, lexeme, line, col);
+    if (n >= (int)sizeof(line_buf))
+    {
+        n = sizeof(line_buf) - 1;
+        line_buf[n - 1] = '\n';
+    }
+
+    if (sink != NULL && sink->mode == TRACE_TEXT)
+    {
+        trace_write(sink, line_buf, n);
+        if (sink->out == stdout)
+        {
+            return;
+        }
+    }
+    else if (sink != NULL)
+    {
+        trace_write_record(sink, INVALID_TOKEN, offset, length, line, col);
+    }
+
+    fputs(line_buf, stdout);
+}
+
+void trace_flush(TraceSink *sink)
+{
+    if (sink->pos > 0)
+    {
+        fwrite(sink->buffer, 1, sink->pos, sink->out);
+        fflush(sink->out);
+    }
+    sink->pos = 0;
+}
+
+void trace_close(TraceSink *sink)
+{
+    if (sink == NULL)
+    {
+        return;
+    }
+    trace_flush(sink);
+    if (sink->out != stdout)
+    {
+        fclose(sink->out);
+    }
+    free(sink->buffer);
+    free(sink);
+}
+
+const char *token_type_name(int type)
+{
+    if (IS_KEYWORD_TOKEN(type))
+    {
+        return "KEYWORD";
+    }
+
+    switch (type)
+    {
+    case IDENTIFIER: return "IDENTIFIER";
+    case INTEGER_LIT: return "INTEGER";
+    case FLOAT_LIT: return "FLOAT";
+    case ASSIGN_OP: return "ASSIGN_OP";
+    case EQ_OP: return "EQ_OP";
+    case NE_OP: return "NE_OP";
+    case LE_OP: return "LE_OP";
+    case GE_OP: return "GE_OP";
+    case LT_OP: return "LT_OP";
+    case GT_OP: return "GT_OP";
+    case PLUS_OP: return "PLUS_OP";
+    case MINUS_OP: return "MINUS_OP";
+    case MULT_OP: return "MULT_OP";
+    case DIV_OP: return "DIV_OP";
+    case OR_OP: return "OR_OP";
+    case AND_OP: return "AND_OP";
+    case NOT_OP: return "NOT_OP";
+    case LPAREN: return "LPAREN";
+    case RPAREN: return "RPAREN";
+    case LBRACE: return "LBRACE";
+    case RBRACE: return "RBRACE";
+    case LBRACKET: return "LBRACKET";
+    case RBRACKET: return "RBRACKET";
+    case SEMICOLON: return "SEMICOLON";
+    case COMMA: return "COMMA";
+    case DOT: return "DOT";
+    case ARROW: return "ARROW";
+    case COLON: return "COLON";
+    case COMMENT: return "COMMENT";
+    case STRING_LIT: return "STRING_LIT";
+    case INVALID_TOKEN: return "INVALID";
+    default: return "UNKNOWN";
+    }
+}
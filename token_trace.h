@@ -0,0 +1,46 @@
+#ifndef TOKEN_TRACE_H
+#define TOKEN_TRACE_H
+
+#include <stdio.h>
+#include "line_index.h"
+
+typedef enum
+{
+    TRACE_OFF,
+    TRACE_TEXT,
+    TRACE_BINARY
+} TraceMode;
+
+/* Binary records are five little-endian 32-bit words:
+   kind, offset, length, line, column. The stream starts with
+   the 4-byte magic "TOKT" followed by a 32-bit version. */
+#define TRACE_BINARY_MAGIC "TOKT"
+#define TRACE_BINARY_VERSION 1
+
+/* One sink per compilation, so concurrent compilations never share a
+   buffer. A NULL sink means tracing is off. */
+typedef struct TraceSink
+{
+    TraceMode mode;
+    FILE *out;
+    char *buffer;
+    size_t pos;
+} TraceSink;
+
+/* Returns NULL when mode is TRACE_OFF or the file cannot be opened */
+TraceSink *trace_open(TraceMode mode, const char *filename);
+
+/* Line and column are looked up in lines from offset */
+void trace_token(TraceSink *sink, const LineIndex *lines, int type, const char *lexeme, int offset, int length);
+
+/* Errors always reach stdout; sink may be NULL */
+void trace_error(TraceSink *sink, const LineIndex *lines, const char *lexeme, int offset, int length,
+                 const char *message);
+
+void trace_flush(TraceSink *sink);
+
+void trace_close(TraceSink *sink);
+
+const char *token_type_name(int type);
+
+#endif
@@ -1,7 +1,6 @@
 #ifndef TOKENS_H
 #define TOKENS_H
 
-#define KEYWORD 256
 #define IDENTIFIER 257
 #define INTEGER_LIT 258
 #define FLOAT_LIT 259
@@ -34,4 +33,50 @@
 #define INVALID_TOKEN 286
 #define STRING_LIT 287
 
+/* One token code per reserved keyword */
+#define ELSE_KW 288
+#define INTEGER_KW 289
+#define SELF_KW 290
+#define FLOAT_KW 291
+#define ISA_KW 292
+#define CONSTRUCT_KW 293
+#define CONSTRUCTOR_KW 294
+#define FUNC_KW 295
+#define PRIVATE_KW 296
+#define THEN_KW 297
+#define IF_KW 298
+#define PUBLIC_KW 299
+#define LOCAL_KW 300
+#define IMPLEMENT_KW 301
+#define READ_KW 302
+#define VOID_KW 303
+#define CLASS_KW 304
+#define RETURN_KW 305
+#define WHILE_KW 306
+#define ATTRIBUTE_KW 307
+#define WRITE_KW 308
+#define STRING_KW 309
+
+#define FIRST_KEYWORD ELSE_KW
+#define LAST_KEYWORD STRING_KW
+#define IS_KEYWORD_TOKEN(t) ((t) >= FIRST_KEYWORD && (t) <= LAST_KEYWORD)
+
+/* Value of a numeric literal, converted once by the lexer */
+typedef union TokenValue
+{
+    int int_value;
+    float float_value;
+} TokenValue;
+
+/* A lexeme as a view into the scanner's buffer. The text is not owned
+   and is only guaranteed to stay valid while the token is current,
+   unless the input is memory-mapped. */
+typedef struct TokenView
+{
+    const char *text;
+    int offset;
+    int length;
+    TokenValue value;
+} TokenView;
+
 #endif
\ No newline at end of file
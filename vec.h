@@ -0,0 +1,36 @@
+#ifndef VEC_H
+#define VEC_H
+
+/* Byte-vector primitives shared by the scanners. VEC_WIDTH is left
+   undefined when neither AVX2 nor SSE2 is available, and callers fall
+   back to scalar loops. */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VEC_WIDTH 32
+typedef __m256i vec_t;
+#define vec_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define vec_set1(c) _mm256_set1_epi8((char)(c))
+#define vec_eq(a, b) _mm256_cmpeq_epi8((a), (b))
+#define vec_or(a, b) _mm256_or_si256((a), (b))
+#define vec_sub(a, b) _mm256_sub_epi8((a), (b))
+#define vec_min(a, b) _mm256_min_epu8((a), (b))
+#define vec_mask(v) ((unsigned int)_mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VEC_WIDTH 16
+typedef __m128i vec_t;
+#define vec_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define vec_set1(c) _mm_set1_epi8((char)(c))
+#define vec_eq(a, b) _mm_cmpeq_epi8((a), (b))
+#define vec_or(a, b) _mm_or_si128((a), (b))
+#define vec_sub(a, b) _mm_sub_epi8((a), (b))
+#define vec_min(a, b) _mm_min_epu8((a), (b))
+#define vec_mask(v) ((unsigned int)_mm_movemask_epi8(v))
+#endif
+
+#ifdef VEC_WIDTH
+#define VEC_ALL_MASK ((unsigned int)((1ULL << VEC_WIDTH) - 1))
+#endif
+
+#endif